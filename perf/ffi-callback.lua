@@ -0,0 +1,47 @@
+-- Throughput of FFI callbacks: a Lua comparator called from libc
+-- qsort() and a callback with a mix of argument types called via a
+-- C function pointer.
+--
+-- Usage: luajit perf/ffi-callback.lua [elements]
+
+local ffi = require('ffi')
+
+local N = tonumber(arg and arg[1]) or 1e6
+local clock = os.clock
+
+ffi.cdef([[
+  void qsort(void *base, size_t nmemb, size_t size,
+             int (*compar)(const void *, const void *));
+]])
+
+local function report(name, ncalls, t)
+  io.write(('%-10s %8.3f s %8.2f Mcalls/s %7.1f ns/call\n'):format(
+    name, t, ncalls / t / 1e6, t / ncalls * 1e9))
+end
+
+-- qsort() with a Lua comparator.
+local ncmp = 0
+local cmp = ffi.cast('int (*)(const void *, const void *)',
+  function(a, b)
+    ncmp = ncmp + 1
+    local x = ffi.cast('const int32_t *', a)[0]
+    local y = ffi.cast('const int32_t *', b)[0]
+    return x < y and -1 or (x > y and 1 or 0)
+  end)
+local arr = ffi.new('int32_t[?]', N)
+math.randomseed(42)
+for i = 0, N - 1 do arr[i] = math.random(0, 2^30) end
+local t = clock()
+ffi.C.qsort(arr, N, 4, cmp)
+report('qsort', ncmp, clock() - t)
+cmp:free()
+
+-- Scalar arguments and result, called back-to-back from a loop.
+local acc = ffi.cast('double (*)(int, double, float, uint8_t)',
+  function(i, d, f, b) return i + d + f + b end)
+local s = 0
+t = clock()
+for i = 1, N do s = s + acc(i, 0.5, 0.25, 7) end
+report('scalars', N, clock() - t)
+acc:free()
+assert(s > 0)
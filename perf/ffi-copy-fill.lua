@@ -0,0 +1,36 @@
+-- Throughput of ffi.copy() and ffi.fill() with constant lengths
+-- above the recorder unrolling limit on compiled traces.
+--
+-- Usage: luajit perf/ffi-copy-fill.lua [iterations]
+
+local ffi = require('ffi')
+
+local N = tonumber(arg and arg[1]) or 5e7
+local clock = os.clock
+
+local src = ffi.new('uint8_t[512]')
+local dst = ffi.new('uint8_t[512]')
+
+local function report(name, t)
+  io.write(('%-10s %8.3f s %7.2f ns/op\n'):format(name, t, t / N * 1e9))
+end
+
+local function bench(name, f)
+  f(100)
+  local t0 = clock()
+  f(N)
+  report(name, clock() - t0)
+end
+
+bench('copy 144', function(n)
+  for _ = 1, n do ffi.copy(dst, src, 144) end
+end)
+bench('copy 160', function(n)
+  for _ = 1, n do ffi.copy(dst + 1, src + 3, 160) end
+end)
+bench('fill 150', function(n)
+  for i = 1, n do ffi.fill(dst, 150, i) end
+end)
+bench('zero 160', function(n)
+  for _ = 1, n do ffi.fill(dst, 160) end
+end)
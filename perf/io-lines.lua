@@ -0,0 +1,58 @@
+-- Reading a file line by line with io.lines(), file:lines() and
+-- file:read('*l'), on a generated file with lines of a given length.
+--
+-- Usage: luajit perf/io-lines.lua [line length] [megabytes]
+
+local LEN = tonumber(arg and arg[1]) or 80
+local MB = tonumber(arg and arg[2]) or 64
+local NLINES = math.floor(MB * 1024 * 1024 / (LEN + 1))
+local clock = os.clock
+
+local fname = os.tmpname()
+
+local function report(name, t, n)
+  assert(n == NLINES, name)
+  io.write(('%-10s %8.3f s %7.2f ns/line\n'):format(name, t, t / n * 1e9))
+end
+
+local function gen()
+  local f = assert(io.open(fname, 'w'))
+  local line = ('x'):rep(LEN - 1)
+  local buf = {}
+  for i = 1, NLINES do
+    buf[#buf + 1] = line
+    buf[#buf + 1] = i % 10
+    buf[#buf + 1] = '\n'
+    if #buf >= 3000 then f:write(table.concat(buf)); buf = {} end
+  end
+  f:write(table.concat(buf))
+  f:close()
+end
+
+local function iolines()
+  local t0, n = clock(), 0
+  for _ in io.lines(fname) do n = n + 1 end
+  report('io.lines', clock() - t0, n)
+end
+
+local function filelines()
+  local f = assert(io.open(fname))
+  local t0, n = clock(), 0
+  for l in f:lines() do n = n + #l - LEN + 1 end
+  report('f:lines', clock() - t0, n)
+  f:close()
+end
+
+local function read()
+  local f = assert(io.open(fname))
+  local t0, n = clock(), 0
+  while f:read('*l') do n = n + 1 end
+  report('f:read', clock() - t0, n)
+  f:close()
+end
+
+gen()
+iolines()
+filelines()
+read()
+os.remove(fname)
@@ -0,0 +1,72 @@
+-- file:readinto() and file:writefrom() compared to file:read(n) plus
+-- ffi.copy() and ffi.string() plus file:write(), with chunks of a
+-- given size.
+--
+-- Usage: luajit perf/io-readinto.lua [chunk size] [megabytes]
+
+local ffi = require('ffi')
+
+local SIZE = tonumber(arg and arg[1]) or 4096
+local MB = tonumber(arg and arg[2]) or 256
+local NCHUNKS = math.floor(MB * 1024 * 1024 / SIZE)
+local clock = os.clock
+
+local fname = os.tmpname()
+local buf = ffi.new('uint8_t[?]', SIZE)
+
+local function report(name, t)
+  io.write(('%-10s %8.3f s %7.2f GB/s\n'):format(name, t,
+                 NCHUNKS * SIZE / t / 2^30))
+end
+
+local function writestr()
+  local f = assert(io.open(fname, 'wb'))
+  local t0 = clock()
+  for i = 1, NCHUNKS do
+    ffi.fill(buf, SIZE, i)
+    f:write(ffi.string(buf, SIZE))
+  end
+  f:close()
+  report('write', clock() - t0)
+end
+
+local function writefrom()
+  local f = assert(io.open(fname, 'wb'))
+  local t0 = clock()
+  for i = 1, NCHUNKS do
+    ffi.fill(buf, SIZE, i)
+    f:writefrom(buf, SIZE)
+  end
+  f:close()
+  report('writefrom', clock() - t0)
+end
+
+local function readstr()
+  local f = assert(io.open(fname, 'rb'))
+  local t0, n = clock(), 0
+  while true do
+    local s = f:read(SIZE)
+    if not s then break end
+    ffi.copy(buf, s, #s)
+    n = n + buf[0]
+  end
+  f:close()
+  report('read', clock() - t0)
+  return n
+end
+
+local function readinto()
+  local f = assert(io.open(fname, 'rb'))
+  local t0, n = clock(), 0
+  while f:readinto(buf, SIZE) > 0 do
+    n = n + buf[0]
+  end
+  f:close()
+  report('readinto', clock() - t0)
+  return n
+end
+
+writestr()
+writefrom()
+assert(readstr() == readinto())
+os.remove(fname)
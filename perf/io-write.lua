@@ -0,0 +1,50 @@
+-- io.write() and file:write() with many arguments, e.g. for access
+-- logs, compared to a single concatenated string.
+--
+-- Usage: luajit perf/io-write.lua [lines]
+
+local N = tonumber(arg and arg[1]) or 2e6
+local clock = os.clock
+
+local fname = os.tmpname()
+
+local function report(name, t)
+  io.stderr:write(('%-10s %8.3f s %7.2f ns/line\n'):format(name, t,
+                  t / N * 1e9))
+end
+
+local function filewrite()
+  local f = assert(io.open(fname, 'w'))
+  local t0 = clock()
+  for i = 1, N do
+    f:write('GET /index.html ', i, ' ', i * 0.25, ' 200\n')
+  end
+  f:close()
+  report('f:write', clock() - t0)
+end
+
+local function iowrite()
+  io.output(fname)
+  local t0 = clock()
+  for i = 1, N do
+    io.write('GET /index.html ', i, ' ', i * 0.25, ' 200\n')
+  end
+  io.close()
+  io.output(io.stdout)
+  report('io.write', clock() - t0)
+end
+
+local function concat()
+  local f = assert(io.open(fname, 'w'))
+  local t0 = clock()
+  for i = 1, N do
+    f:write('GET /index.html ' .. i .. ' ' .. i * 0.25 .. ' 200\n')
+  end
+  f:close()
+  report('concat', clock() - t0)
+end
+
+filewrite()
+iowrite()
+concat()
+os.remove(fname)
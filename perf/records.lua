@@ -0,0 +1,54 @@
+-- Creation, field access and memory footprint of many small
+-- record-like tables (e.g. { id = ..., name = ..., ts = ... }).
+--
+-- Usage: luajit perf/records.lua [records]
+
+local N = tonumber(arg and arg[1]) or 1e6
+local clock = os.clock
+
+-- Resident set size in bytes, or nil if unknown.
+local function rss()
+  local f = io.open('/proc/self/statm')
+  if not f then return nil end
+  local _, pages = f:read('*n', '*n')
+  f:close()
+  return pages and pages * 4096
+end
+
+local function fullgc()
+  collectgarbage()
+  collectgarbage()
+end
+
+fullgc()
+local rss0, mem0 = rss(), collectgarbage('count')
+
+local t = clock()
+local recs = {}
+for i = 1, N do recs[i] = { id = i, name = 'x', ts = i * 0.5 } end
+local tcreate = clock() - t
+
+fullgc()
+local rss1, mem1 = rss(), collectgarbage('count')
+
+t = clock()
+local s = 0
+for _ = 1, 10 do
+  for i = 1, N do
+    local r = recs[i]
+    s = s + r.id + r.ts
+  end
+end
+local taccess = clock() - t
+assert(s > 0)
+
+io.write(('create     %8.3f s %7.2f ns/record\n'):format(
+  tcreate, tcreate / N * 1e9))
+io.write(('access     %8.3f s %7.2f ns/record\n'):format(
+  taccess, taccess / (10 * N) * 1e9))
+-- Subtract the slot in the array holding the records.
+io.write(('gc-bytes   %8.1f bytes/record\n'):format(
+  (mem1 - mem0) * 1024 / N - 8))
+if rss0 and rss1 then
+  io.write(('rss-bytes  %8.1f bytes/record\n'):format((rss1 - rss0) / N - 8))
+end
@@ -0,0 +1,42 @@
+-- Throughput of number to string conversions: "%.14g" and "%.17g"
+-- (big-number rescaling in lj_strfmt_putfnum) vs "%r" (shortest
+-- round-trip representation).
+--
+-- Usage: luajit perf/strfmt-num.lua [iterations]
+
+local N = tonumber(arg and arg[1]) or 1e6
+local format = string.format
+local clock = os.clock
+local band = bit.band
+
+-- Metric-like samples: durations, ratios, counters and a few
+-- values with large and small exponents.
+local samples = {}
+math.randomseed(42)
+for i = 1, 1024 do
+  local r = math.random()
+  if i % 4 == 0 then
+    samples[i] = r * 1e3
+  elseif i % 4 == 1 then
+    samples[i] = r
+  elseif i % 4 == 2 then
+    samples[i] = math.floor(r * 1e9)
+  else
+    samples[i] = r * 10^math.random(-300, 300)
+  end
+end
+
+local function bench(name, fmt)
+  local len = 0
+  local t = clock()
+  for i = 1, N do
+    len = len + #format(fmt, samples[band(i, 1023) + 1])
+  end
+  t = clock() - t
+  io.write(('%-8s %8.3f s %8.2f Mconv/s %6.2f chars/conv\n'):format(
+    name, t, N / t / 1e6, len / N))
+end
+
+bench('%.14g', '%.14g')
+bench('%.17g', '%.17g')
+bench('%r', '%r')
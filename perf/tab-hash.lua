@@ -0,0 +1,59 @@
+-- Hash part lookups of present (hit) and absent (miss) keys and
+-- insertion/deletion churn at various numbers of live keys.
+--
+-- Usage: luajit perf/tab-hash.lua [rounds]
+
+local N = tonumber(arg and arg[1]) or 10
+local clock = os.clock
+
+local NKEYS = 100000
+local keys, absent = {}, {}
+for i = 1, NKEYS do
+  keys[i] = 'k' .. i
+  absent[i] = 'a' .. i
+end
+
+local function report(name, nops, t)
+  io.write(('%-12s %8.3f s %7.2f ns/op\n'):format(name, t, t / nops * 1e9))
+end
+
+local function lookup(name, size, probe)
+  local t = {}
+  for i = 1, size do t[keys[i]] = i end
+  local nrep = math.floor(NKEYS * N / size)
+  local s = 0
+  local t0 = clock()
+  for _ = 1, nrep do
+    for i = 1, size do
+      if t[probe[i]] then s = s + 1 end
+    end
+  end
+  report(name .. '-' .. size, nrep * size, clock() - t0)
+end
+
+-- Replace one live key with a new one each step, keeping the number
+-- of live keys constant.
+local function churn(live)
+  local t = {}
+  for i = 1, live do t[keys[i]] = i end
+  local nops = 0
+  local t0 = clock()
+  for _ = 1, N do
+    for i = live + 1, NKEYS do
+      t[keys[i - live]] = nil
+      t[keys[i]] = i
+    end
+    for i = NKEYS - live + 1, NKEYS do t[keys[i]] = nil end
+    for i = 1, live do t[keys[i]] = i end
+    nops = nops + NKEYS
+  end
+  report('churn-' .. live, nops, clock() - t0)
+end
+
+for _, size in ipairs({ 64, 1000, 50000 }) do
+  lookup('hit', size, keys)
+  lookup('miss', size, absent)
+end
+for _, live in ipairs({ 100, 127, 1000, 1023, 1500, 2047 }) do
+  churn(live)
+end
@@ -0,0 +1,61 @@
+-- Length operator (#t) on arrays grown by appending, shrunk by
+-- removing the last element and on unchanged arrays.
+-- The last boundary is only remembered in GC64 builds, so the other
+-- builds aren't expected to gain here.
+--
+-- Usage: luajit perf/tab-len.lua [elements]
+
+local N = tonumber(arg and arg[1]) or 1e6
+local clock = os.clock
+local NREP = 10
+
+local function report(name, nops, t)
+  io.write(('%-10s %8.3f s %7.2f ns/op\n'):format(name, t, t / nops * 1e9))
+end
+
+local function append()
+  local t0 = clock()
+  for _ = 1, NREP do
+    local t = {}
+    for i = 1, N do t[#t + 1] = i end
+  end
+  report('append', NREP * N, clock() - t0)
+end
+
+local function insert()
+  local tinsert = table.insert
+  local t0 = clock()
+  for _ = 1, NREP do
+    local t = {}
+    for i = 1, N do tinsert(t, i) end
+  end
+  report('insert', NREP * N, clock() - t0)
+end
+
+local function pop()
+  local t = {}
+  for i = 1, N do t[i] = i end
+  local t0 = clock()
+  for _ = 1, NREP do
+    for _ = 1, N do t[#t] = nil end
+    for i = 1, N do t[i] = i end
+  end
+  report('pop', NREP * N, clock() - t0)
+end
+
+local function stable()
+  local t = {}
+  for i = 1, N - 1 do t[i] = i end
+  local s = 0
+  local t0 = clock()
+  for _ = 1, NREP do
+    for _ = 1, N do s = s + #t end
+  end
+  assert(s > 0)
+  report('stable', NREP * N, clock() - t0)
+end
+
+append()
+insert()
+pop()
+stable()
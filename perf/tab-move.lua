@@ -0,0 +1,71 @@
+-- table.move() and table.clone() compared to the equivalent Lua
+-- loops, on arrays of a given size.
+--
+-- Usage: luajit perf/tab-move.lua [elements]
+
+local N = tonumber(arg and arg[1]) or 100
+local NOPS = math.floor(1e8 / N)
+local clock = os.clock
+local has_clone, table_clone = pcall(require, 'table.clone')
+
+local function report(name, t)
+  io.write(('%-10s %8.3f s %7.2f ns/elem\n'):format(name, t, t / NOPS / N * 1e9))
+end
+
+local s = {}
+for i = 1, N do s[i] = i end
+
+local function loopmove()
+  local d = {}
+  local t0 = clock()
+  for _ = 1, NOPS do
+    for i = 1, N do d[i] = s[i] end
+  end
+  report('loop-move', clock() - t0)
+end
+
+local function move()
+  local tmove = table.move
+  local d = {}
+  local t0 = clock()
+  for _ = 1, NOPS do tmove(s, 1, N, 1, d) end
+  report('move', clock() - t0)
+end
+
+local function shift()
+  local tmove = table.move
+  local d = {}
+  for i = 1, N + 1 do d[i] = i end
+  local t0 = clock()
+  for _ = 1, NOPS do
+    tmove(d, 1, N, 2)
+    tmove(d, 2, N + 1, 1)
+  end
+  report('shift', (clock() - t0) / 2)
+end
+
+local function loopclone()
+  local x = 0
+  local t0 = clock()
+  for _ = 1, NOPS do
+    local d = {}
+    for i = 1, N do d[i] = s[i] end
+    x = x + d[N]
+  end
+  assert(x == NOPS * N)
+  report('loop-clone', clock() - t0)
+end
+
+local function clone()
+  local t0 = clock()
+  local x = 0
+  for _ = 1, NOPS do x = x + table_clone(s)[N] end
+  assert(x == NOPS * N)
+  report('clone', clock() - t0)
+end
+
+loopmove()
+move()
+shift()
+loopclone()
+if has_clone then clone() end
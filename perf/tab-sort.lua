@@ -0,0 +1,39 @@
+-- table.sort() on arrays of numbers, strings and records, with and
+-- without a comparison function, on random and sorted input.
+--
+-- Usage: luajit perf/tab-sort.lua [elements]
+
+local N = tonumber(arg and arg[1]) or 1e6
+local clock = os.clock
+
+local function report(name, t)
+  io.write(('%-12s %8.3f s %7.2f ns/elem\n'):format(name, t, t / N * 1e9))
+end
+
+local function bench(name, gen, cmp)
+  math.randomseed(42)
+  local t = {}
+  for i = 1, N do t[i] = gen(i) end
+  local t0 = clock()
+  table.sort(t, cmp)
+  report(name, clock() - t0)
+end
+
+local random = math.random
+local function rnd() return random() end
+local function id(i) return i end
+local function rev(i) return N - i end
+local function str() return tostring(random(1, N)) end
+local function rec() return { id = random(1, N) } end
+
+local function gt(a, b) return a > b end
+local function lt(a, b) return a < b end
+local function byid(a, b) return a.id < b.id end
+
+bench('num', rnd)
+bench('num-sorted', id)
+bench('num-rev', rev)
+bench('num-cmp', rnd, gt)
+bench('str', str)
+bench('str-cmp', str, lt)
+bench('rec-cmp', rec, byid)
@@ -0,0 +1,54 @@
+-- Interpreter throughput of table accesses with constant string
+-- keys (TGETS/TSETS/GGET) on a big module-like table.
+--
+-- Usage: luajit -joff perf/tgets.lua [iterations]
+
+local N = tonumber(arg and arg[1]) or 1e6
+local clock = os.clock
+
+local NKEYS = 200
+-- Keys found 2-4 nodes down their hash chain with the current
+-- string hash function.
+local DEEP = {
+  'fn_175', 'fn_53', 'fn_166', 'fn_163', 'fn_141', 'fn_139', 'fn_26',
+  'fn_90', 'fn_4', 'fn_75', 'fn_30', 'fn_107', 'fn_85',
+}
+
+local m = {}
+for i = 1, NKEYS do m['fn_' .. i] = i end
+
+local all = {}
+for i = 1, NKEYS do all[i] = 'fn_' .. i end
+
+local function report(name, nacc, t)
+  io.write(('%-10s %8.3f s %7.2f ns/access\n'):format(
+    name, t, t / nacc * 1e9))
+end
+
+-- Generate a loop with one access per key, either as a table field
+-- of the upvalue m or as a global with m as the environment.
+local function bench(name, keys, fmt, sep)
+  local acc = {}
+  for i = 1, #keys do acc[i] = fmt:format(keys[i]) end
+  local f = assert(loadstring(([[
+    local m = ...
+    return function(n)
+      local m, s = m, 0
+      for i = 1, n do %s end
+      return s
+    end
+  ]]):format(table.concat(acc, sep))))(m)
+  setfenv(f, m)
+  -- Same number of accesses for all key sets.
+  local n = math.floor(N * NKEYS / #keys)
+  local t0 = clock()
+  f(n)
+  report(name, n * #keys, clock() - t0)
+end
+
+bench('tgets', all, 's = s + m.%s', '; ')
+bench('tgets-deep', DEEP, 's = s + m.%s', '; ')
+bench('tsets', all, 'm.%s = i', '; ')
+bench('tsets-deep', DEEP, 'm.%s = i', '; ')
+bench('gget', all, 's = s + %s', '; ')
+bench('gget-deep', DEEP, 's = s + %s', '; ')
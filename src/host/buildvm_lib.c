@@ -195,12 +195,13 @@ static void libdef_lua(BuildCtx *ctx, char *p, int arg)
       if (!strcmp(libbc_map[i].name, p)) {
 	int ofs = libbc_map[i].ofs;
 	int len = libbc_map[i+1].ofs - ofs;
-	obuf[2]++;  /* Bump hash table size. */
+	if (regfunc != REGFUNC_NOREGUV) obuf[2]++;  /* Bump hash table size. */
 	*optr++ = LIBINIT_LUA;
-	libdef_name(p, 0);
+	libdef_name(p, regfunc == REGFUNC_NOREGUV ? LIBINIT_LUAUV : 0);
 	memcpy(optr, libbc_code + ofs, len);
 	libdef_fixupbc(optr);
 	optr += len;
+	regfunc = REGFUNC_OK;
 	return;
       }
     }
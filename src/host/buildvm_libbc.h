@@ -15,12 +15,81 @@ static const uint8_t libbc_code[] = {
 8,2,0,0,88,3,23,128,59,3,2,0,43,4,0,0,64,4,2,0,76,3,2,0,88,3,18,128,16,1,14,
 0,41,3,1,0,3,3,1,0,88,3,14,128,3,1,2,0,88,3,12,128,59,3,1,0,22,4,1,1,18,5,2,
 0,41,6,1,0,77,4,4,128,23,8,1,7,59,9,7,0,64,9,8,0,79,4,252,127,43,4,0,0,64,4,
-2,0,76,3,2,0,75,0,1,0,0,2,0,5,12,0,0,0,35,16,0,12,0,16,1,14,0,16,2,14,0,16,
-3,14,0,11,4,0,0,88,5,1,128,18,4,0,0,16,4,12,0,3,1,2,0,88,5,24,128,33,5,1,3,
-0,2,3,0,88,6,4,128,2,3,1,0,88,6,2,128,4,4,0,0,88,6,9,128,18,6,1,0,18,7,2,0,
-41,8,1,0,77,6,4,128,32,10,5,9,59,11,9,0,64,11,10,4,79,6,252,127,88,6,8,128,
-18,6,2,0,18,7,1,0,41,8,255,255,77,6,4,128,32,10,5,9,59,11,9,0,64,11,10,4,79,
-6,252,127,76,4,2,0,0
+2,0,76,3,2,0,75,0,1,0,0,2,0,2,3,0,0,0,6,0,0,1,0,88,2,2,128,43,2,1,0,88,3,1,
+128,43,2,2,0,76,2,2,0,0,3,31,0,0,6,251,3,16,0,12,0,52,3,0,0,41,4,0,0,41,5,1,
+0,22,6,0,2,43,7,2,0,41,8,0,0,41,9,1,0,1,9,2,0,88,9,6,128,85,9,5,128,26,9,1,
+2,33,9,9,2,25,2,1,9,22,8,0,8,88,9,247,127,85,9,232,129,33,2,5,6,41,9,24,0,3,
+2,9,0,88,9,38,128,22,9,0,5,23,10,0,6,41,11,1,0,77,9,32,128,59,13,12,0,18,14,
+12,0,1,5,14,0,88,15,13,128,18,15,1,0,18,17,13,0,23,18,0,14,59,18,18,0,66,15,
+3,2,15,0,15,0,88,16,6,128,85,15,5,128,23,15,0,14,59,15,15,0,64,15,14,0,23,14,
+0,14,88,15,241,127,4,14,12,0,88,15,12,128,64,13,14,0,5,14,5,0,88,15,9,128,18,
+15,1,0,22,17,0,5,59,17,17,0,18,18,13,0,66,15,3,2,15,0,15,0,88,16,2,128,43,15,
+1,0,76,15,2,0,79,9,224,127,18,6,5,0,88,9,172,129,26,9,1,2,33,9,9,2,25,9,1,9,
+32,9,9,5,18,10,1,0,59,12,5,0,59,13,9,0,66,10,3,2,15,0,10,0,88,11,4,128,59,10,
+5,0,59,11,9,0,64,11,5,0,64,10,9,0,18,10,1,0,23,12,0,6,59,12,12,0,59,13,5,0,
+66,10,3,2,15,0,10,0,88,11,16,128,23,10,0,6,23,11,0,6,59,11,11,0,59,12,5,0,64,
+12,10,0,64,11,5,0,18,10,1,0,59,12,5,0,59,13,9,0,66,10,3,2,15,0,10,0,88,11,4,
+128,59,10,5,0,59,11,9,0,64,11,5,0,64,10,9,0,59,10,5,0,18,11,5,0,18,12,6,0,14,
+0,7,0,88,13,84,128,18,13,1,0,23,15,0,5,59,15,15,0,18,16,10,0,66,13,3,2,14,0,
+13,0,88,13,77,128,85,13,11,128,23,12,0,12,1,12,5,0,88,13,2,128,43,13,1,0,76,
+13,2,0,18,13,1,0,18,15,10,0,59,16,12,0,66,13,3,2,14,0,13,0,88,13,244,127,22,
+13,0,12,5,13,6,0,88,13,13,128,1,11,12,0,88,13,23,128,85,13,9,128,22,11,0,11,
+18,13,1,0,18,15,10,0,59,16,11,0,66,13,3,2,15,0,13,0,88,14,246,127,88,13,14,
+128,88,13,244,127,88,13,12,128,85,13,11,128,22,11,0,11,5,11,6,0,88,13,2,128,
+43,13,1,0,76,13,2,0,18,13,1,0,18,15,10,0,59,16,11,0,66,13,3,2,15,0,13,0,88,
+14,244,127,1,11,12,0,88,13,30,128,85,13,29,128,59,13,12,0,59,14,11,0,64,14,
+12,0,64,13,11,0,85,13,11,128,23,12,0,12,1,12,5,0,88,13,2,128,43,13,1,0,76,13,
+2,0,18,13,1,0,18,15,10,0,59,16,12,0,66,13,3,2,14,0,13,0,88,13,244,127,85,13,
+11,128,22,11,0,11,5,11,6,0,88,13,2,128,43,13,1,0,76,13,2,0,18,13,1,0,18,15,
+10,0,59,16,11,0,66,13,3,2,15,0,13,0,88,14,244,127,88,13,224,127,59,13,12,0,
+64,13,5,0,64,10,12,0,22,5,0,12,88,13,46,129,85,13,11,128,22,11,0,11,5,11,6,
+0,88,13,2,128,43,13,1,0,76,13,2,0,18,13,1,0,59,15,11,0,18,16,10,0,66,13,3,2,
+14,0,13,0,88,13,244,127,22,13,0,5,5,11,13,0,88,13,13,128,1,11,12,0,88,13,23,
+128,85,13,9,128,23,12,0,12,18,13,1,0,59,15,12,0,18,16,10,0,66,13,3,2,15,0,13,
+0,88,14,246,127,88,13,14,128,88,13,244,127,88,13,12,128,85,13,11,128,23,12,
+0,12,5,12,5,0,88,13,2,128,43,13,1,0,76,13,2,0,18,13,1,0,59,15,12,0,18,16,10,
+0,66,13,3,2,15,0,13,0,88,14,244,127,2,12,11,0,88,13,2,128,43,13,1,0,88,14,1,
+128,43,13,2,0,1,11,12,0,88,14,30,128,85,14,29,128,59,14,12,0,59,15,11,0,64,
+15,12,0,64,14,11,0,85,14,11,128,22,11,0,11,5,11,6,0,88,14,2,128,43,14,1,0,76,
+14,2,0,18,14,1,0,59,16,11,0,18,17,10,0,66,14,3,2,14,0,14,0,88,14,244,127,85,
+14,11,128,23,12,0,12,5,12,5,0,88,14,2,128,43,14,1,0,76,14,2,0,18,14,1,0,59,
+16,12,0,18,17,10,0,66,14,3,2,15,0,14,0,88,15,244,127,88,14,224,127,23,14,0,
+11,59,15,14,0,64,15,5,0,64,10,14,0,33,15,5,14,33,16,14,6,23,16,0,16,26,17,2,
+2,33,17,17,2,25,17,2,17,0,15,17,0,88,18,2,128,1,16,17,0,88,18,110,128,23,8,
+0,8,9,8,3,0,88,18,62,128,26,18,1,2,33,18,18,2,25,18,1,18,41,19,1,0,1,19,2,0,
+88,19,54,128,85,19,53,128,43,19,0,0,41,20,0,0,1,20,18,0,88,20,3,128,23,18,0,
+18,18,19,18,0,88,20,8,128,23,2,0,2,32,20,2,5,32,21,2,5,59,21,21,0,59,22,5,0,
+64,22,20,0,64,21,5,0,41,19,0,0,32,20,19,5,59,20,20,0,85,21,32,128,29,21,1,19,
+22,21,0,21,3,2,21,0,88,22,1,128,88,21,27,128,22,22,0,21,1,22,2,0,88,22,10,128,
+18,22,1,0,32,24,21,5,59,24,24,0,32,25,21,5,22,25,0,25,59,25,25,0,66,22,3,2,
+15,0,22,0,88,23,1,128,22,21,0,21,18,22,1,0,18,24,20,0,32,25,21,5,59,25,25,0,
+66,22,3,2,14,0,22,0,88,22,1,128,88,21,6,128,32,22,19,5,32,23,21,5,59,23,23,
+0,64,23,22,0,18,19,21,0,88,21,223,127,32,21,19,5,64,20,21,0,88,19,199,127,18,
+6,5,0,88,18,113,128,41,18,24,0,3,18,15,0,88,18,17,128,26,18,4,15,33,18,18,15,
+25,18,4,18,32,19,18,5,32,20,18,5,59,20,20,0,59,21,5,0,64,21,19,0,64,20,5,0,
+23,19,0,14,33,20,18,14,33,21,18,14,59,21,21,0,23,22,0,14,59,22,22,0,64,22,20,
+0,64,21,19,0,41,18,24,0,3,18,16,0,88,18,90,128,26,18,4,16,33,18,18,16,25,18,
+4,18,22,19,0,14,22,20,0,14,32,20,18,20,22,21,0,14,32,21,18,21,59,21,21,0,22,
+22,0,14,59,22,22,0,64,22,20,0,64,21,19,0,23,19,0,6,33,20,18,6,33,21,18,6,59,
+21,21,0,23,22,0,6,59,22,22,0,64,22,20,0,64,21,19,0,88,18,68,128,15,0,13,0,88,
+18,66,128,18,18,5,0,18,19,14,0,41,20,0,0,41,21,8,0,3,20,21,0,88,21,60,128,85,
+21,59,128,22,21,0,18,23,22,0,19,41,23,1,0,77,21,42,128,59,25,24,0,18,26,1,0,
+18,28,25,0,23,29,0,24,59,29,29,0,66,26,3,2,15,0,26,0,88,27,33,128,18,26,24,
+0,85,27,13,128,23,27,0,26,59,27,27,0,64,27,26,0,23,26,0,26,4,26,18,0,88,27,
+7,128,18,27,1,0,18,29,25,0,23,30,0,26,59,30,30,0,66,27,3,2,14,0,27,0,88,27,
+242,127,64,25,26,0,5,26,18,0,88,27,9,128,18,27,1,0,22,29,0,18,59,29,29,0,18,
+30,25,0,66,27,3,2,15,0,27,0,88,28,2,128,43,27,1,0,76,27,2,0,32,27,24,20,33,
+20,26,27,41,27,8,0,1,27,20,0,88,27,1,128,88,21,1,128,79,21,214,127,41,21,8,
+0,3,20,21,0,88,21,203,127,5,19,6,0,88,21,2,128,18,6,5,0,88,21,6,128,22,21,0,
+14,18,22,6,0,41,20,0,0,18,19,22,0,18,18,21,0,88,21,193,127,1,5,6,0,88,18,31,
+128,1,15,16,0,88,18,14,128,22,18,0,4,22,19,1,4,22,20,5,4,22,21,4,4,22,22,0,
+14,18,23,6,0,18,24,8,0,43,25,1,0,60,25,21,3,60,24,20,3,60,23,19,3,60,22,18,
+3,18,6,14,0,88,18,14,128,22,18,0,4,22,19,1,4,22,20,5,4,22,21,4,4,18,22,5,0,
+18,23,14,0,18,24,8,0,60,7,21,3,60,24,20,3,60,23,19,3,60,22,18,3,22,18,0,14,
+43,7,1,0,18,5,18,0,22,4,4,4,3,6,5,0,88,9,14,128,41,9,0,0,1,9,4,0,88,9,11,128,
+23,9,5,4,56,9,9,3,23,10,1,4,56,10,10,3,23,11,0,4,56,11,11,3,56,7,4,3,18,8,11,
+0,18,6,10,0,18,5,9,0,23,4,4,4,3,6,5,0,88,9,23,126,43,9,2,0,76,9,2,0,2,4,16,
+0,8,6,0
 #else
 0,1,2,0,0,1,2,24,1,0,0,76,1,2,0,241,135,158,166,3,220,203,178,130,4,0,1,2,0,
 0,1,2,24,1,0,0,76,1,2,0,243,244,148,165,20,198,190,199,252,3,0,1,2,0,0,0,3,
@@ -33,12 +102,81 @@ static const uint8_t libbc_code[] = {
 8,2,0,0,88,3,23,128,59,3,2,0,43,4,0,0,64,4,2,0,76,3,2,0,88,3,18,128,16,1,14,
 0,41,3,1,0,3,3,1,0,88,3,14,128,3,1,2,0,88,3,12,128,59,3,1,0,22,4,1,1,18,5,2,
 0,41,6,1,0,77,4,4,128,23,8,1,7,59,9,7,0,64,9,8,0,79,4,252,127,43,4,0,0,64,4,
-2,0,76,3,2,0,75,0,1,0,0,2,0,5,12,0,0,0,35,16,0,12,0,16,1,14,0,16,2,14,0,16,
-3,14,0,11,4,0,0,88,5,1,128,18,4,0,0,16,4,12,0,3,1,2,0,88,5,24,128,33,5,1,3,
-0,2,3,0,88,6,4,128,2,3,1,0,88,6,2,128,4,4,0,0,88,6,9,128,18,6,1,0,18,7,2,0,
-41,8,1,0,77,6,4,128,32,10,5,9,59,11,9,0,64,11,10,4,79,6,252,127,88,6,8,128,
-18,6,2,0,18,7,1,0,41,8,255,255,77,6,4,128,32,10,5,9,59,11,9,0,64,11,10,4,79,
-6,252,127,76,4,2,0,0
+2,0,76,3,2,0,75,0,1,0,0,2,0,2,3,0,0,0,6,0,0,1,0,88,2,2,128,43,2,1,0,88,3,1,
+128,43,2,2,0,76,2,2,0,0,3,30,0,0,6,251,3,16,0,12,0,52,3,0,0,41,4,0,0,41,5,1,
+0,22,6,0,2,43,7,2,0,41,8,0,0,41,9,1,0,1,9,2,0,88,9,6,128,85,9,5,128,26,9,1,
+2,33,9,9,2,25,2,1,9,22,8,0,8,88,9,247,127,85,9,232,129,33,2,5,6,41,9,24,0,3,
+2,9,0,88,9,38,128,22,9,0,5,23,10,0,6,41,11,1,0,77,9,32,128,59,13,12,0,18,14,
+12,0,1,5,14,0,88,15,13,128,18,15,1,0,18,16,13,0,23,17,0,14,59,17,17,0,66,15,
+3,2,15,0,15,0,88,16,6,128,85,15,5,128,23,15,0,14,59,15,15,0,64,15,14,0,23,14,
+0,14,88,15,241,127,4,14,12,0,88,15,12,128,64,13,14,0,5,14,5,0,88,15,9,128,18,
+15,1,0,22,16,0,5,59,16,16,0,18,17,13,0,66,15,3,2,15,0,15,0,88,16,2,128,43,15,
+1,0,76,15,2,0,79,9,224,127,18,6,5,0,88,9,172,129,26,9,1,2,33,9,9,2,25,9,1,9,
+32,9,9,5,18,10,1,0,59,11,5,0,59,12,9,0,66,10,3,2,15,0,10,0,88,11,4,128,59,10,
+5,0,59,11,9,0,64,11,5,0,64,10,9,0,18,10,1,0,23,11,0,6,59,11,11,0,59,12,5,0,
+66,10,3,2,15,0,10,0,88,11,16,128,23,10,0,6,23,11,0,6,59,11,11,0,59,12,5,0,64,
+12,10,0,64,11,5,0,18,10,1,0,59,11,5,0,59,12,9,0,66,10,3,2,15,0,10,0,88,11,4,
+128,59,10,5,0,59,11,9,0,64,11,5,0,64,10,9,0,59,10,5,0,18,11,5,0,18,12,6,0,14,
+0,7,0,88,13,84,128,18,13,1,0,23,14,0,5,59,14,14,0,18,15,10,0,66,13,3,2,14,0,
+13,0,88,13,77,128,85,13,11,128,23,12,0,12,1,12,5,0,88,13,2,128,43,13,1,0,76,
+13,2,0,18,13,1,0,18,14,10,0,59,15,12,0,66,13,3,2,14,0,13,0,88,13,244,127,22,
+13,0,12,5,13,6,0,88,13,13,128,1,11,12,0,88,13,23,128,85,13,9,128,22,11,0,11,
+18,13,1,0,18,14,10,0,59,15,11,0,66,13,3,2,15,0,13,0,88,14,246,127,88,13,14,
+128,88,13,244,127,88,13,12,128,85,13,11,128,22,11,0,11,5,11,6,0,88,13,2,128,
+43,13,1,0,76,13,2,0,18,13,1,0,18,14,10,0,59,15,11,0,66,13,3,2,15,0,13,0,88,
+14,244,127,1,11,12,0,88,13,30,128,85,13,29,128,59,13,12,0,59,14,11,0,64,14,
+12,0,64,13,11,0,85,13,11,128,23,12,0,12,1,12,5,0,88,13,2,128,43,13,1,0,76,13,
+2,0,18,13,1,0,18,14,10,0,59,15,12,0,66,13,3,2,14,0,13,0,88,13,244,127,85,13,
+11,128,22,11,0,11,5,11,6,0,88,13,2,128,43,13,1,0,76,13,2,0,18,13,1,0,18,14,
+10,0,59,15,11,0,66,13,3,2,15,0,13,0,88,14,244,127,88,13,224,127,59,13,12,0,
+64,13,5,0,64,10,12,0,22,5,0,12,88,13,46,129,85,13,11,128,22,11,0,11,5,11,6,
+0,88,13,2,128,43,13,1,0,76,13,2,0,18,13,1,0,59,14,11,0,18,15,10,0,66,13,3,2,
+14,0,13,0,88,13,244,127,22,13,0,5,5,11,13,0,88,13,13,128,1,11,12,0,88,13,23,
+128,85,13,9,128,23,12,0,12,18,13,1,0,59,14,12,0,18,15,10,0,66,13,3,2,15,0,13,
+0,88,14,246,127,88,13,14,128,88,13,244,127,88,13,12,128,85,13,11,128,23,12,
+0,12,5,12,5,0,88,13,2,128,43,13,1,0,76,13,2,0,18,13,1,0,59,14,12,0,18,15,10,
+0,66,13,3,2,15,0,13,0,88,14,244,127,2,12,11,0,88,13,2,128,43,13,1,0,88,14,1,
+128,43,13,2,0,1,11,12,0,88,14,30,128,85,14,29,128,59,14,12,0,59,15,11,0,64,
+15,12,0,64,14,11,0,85,14,11,128,22,11,0,11,5,11,6,0,88,14,2,128,43,14,1,0,76,
+14,2,0,18,14,1,0,59,15,11,0,18,16,10,0,66,14,3,2,14,0,14,0,88,14,244,127,85,
+14,11,128,23,12,0,12,5,12,5,0,88,14,2,128,43,14,1,0,76,14,2,0,18,14,1,0,59,
+15,12,0,18,16,10,0,66,14,3,2,15,0,14,0,88,15,244,127,88,14,224,127,23,14,0,
+11,59,15,14,0,64,15,5,0,64,10,14,0,33,15,5,14,33,16,14,6,23,16,0,16,26,17,2,
+2,33,17,17,2,25,17,2,17,0,15,17,0,88,18,2,128,1,16,17,0,88,18,110,128,23,8,
+0,8,9,8,3,0,88,18,62,128,26,18,1,2,33,18,18,2,25,18,1,18,41,19,1,0,1,19,2,0,
+88,19,54,128,85,19,53,128,43,19,0,0,41,20,0,0,1,20,18,0,88,20,3,128,23,18,0,
+18,18,19,18,0,88,20,8,128,23,2,0,2,32,20,2,5,32,21,2,5,59,21,21,0,59,22,5,0,
+64,22,20,0,64,21,5,0,41,19,0,0,32,20,19,5,59,20,20,0,85,21,32,128,29,21,1,19,
+22,21,0,21,3,2,21,0,88,22,1,128,88,21,27,128,22,22,0,21,1,22,2,0,88,22,10,128,
+18,22,1,0,32,23,21,5,59,23,23,0,32,24,21,5,22,24,0,24,59,24,24,0,66,22,3,2,
+15,0,22,0,88,23,1,128,22,21,0,21,18,22,1,0,18,23,20,0,32,24,21,5,59,24,24,0,
+66,22,3,2,14,0,22,0,88,22,1,128,88,21,6,128,32,22,19,5,32,23,21,5,59,23,23,
+0,64,23,22,0,18,19,21,0,88,21,223,127,32,21,19,5,64,20,21,0,88,19,199,127,18,
+6,5,0,88,18,113,128,41,18,24,0,3,18,15,0,88,18,17,128,26,18,4,15,33,18,18,15,
+25,18,4,18,32,19,18,5,32,20,18,5,59,20,20,0,59,21,5,0,64,21,19,0,64,20,5,0,
+23,19,0,14,33,20,18,14,33,21,18,14,59,21,21,0,23,22,0,14,59,22,22,0,64,22,20,
+0,64,21,19,0,41,18,24,0,3,18,16,0,88,18,90,128,26,18,4,16,33,18,18,16,25,18,
+4,18,22,19,0,14,22,20,0,14,32,20,18,20,22,21,0,14,32,21,18,21,59,21,21,0,22,
+22,0,14,59,22,22,0,64,22,20,0,64,21,19,0,23,19,0,6,33,20,18,6,33,21,18,6,59,
+21,21,0,23,22,0,6,59,22,22,0,64,22,20,0,64,21,19,0,88,18,68,128,15,0,13,0,88,
+18,66,128,18,18,5,0,18,19,14,0,41,20,0,0,41,21,8,0,3,20,21,0,88,21,60,128,85,
+21,59,128,22,21,0,18,23,22,0,19,41,23,1,0,77,21,42,128,59,25,24,0,18,26,1,0,
+18,27,25,0,23,28,0,24,59,28,28,0,66,26,3,2,15,0,26,0,88,27,33,128,18,26,24,
+0,85,27,13,128,23,27,0,26,59,27,27,0,64,27,26,0,23,26,0,26,4,26,18,0,88,27,
+7,128,18,27,1,0,18,28,25,0,23,29,0,26,59,29,29,0,66,27,3,2,14,0,27,0,88,27,
+242,127,64,25,26,0,5,26,18,0,88,27,9,128,18,27,1,0,22,28,0,18,59,28,28,0,18,
+29,25,0,66,27,3,2,15,0,27,0,88,28,2,128,43,27,1,0,76,27,2,0,32,27,24,20,33,
+20,26,27,41,27,8,0,1,27,20,0,88,27,1,128,88,21,1,128,79,21,214,127,41,21,8,
+0,3,20,21,0,88,21,203,127,5,19,6,0,88,21,2,128,18,6,5,0,88,21,6,128,22,21,0,
+14,18,22,6,0,41,20,0,0,18,19,22,0,18,18,21,0,88,21,193,127,1,5,6,0,88,18,31,
+128,1,15,16,0,88,18,14,128,22,18,0,4,22,19,1,4,22,20,5,4,22,21,4,4,22,22,0,
+14,18,23,6,0,18,24,8,0,43,25,1,0,60,25,21,3,60,24,20,3,60,23,19,3,60,22,18,
+3,18,6,14,0,88,18,14,128,22,18,0,4,22,19,1,4,22,20,5,4,22,21,4,4,18,22,5,0,
+18,23,14,0,18,24,8,0,60,7,21,3,60,24,20,3,60,23,19,3,60,22,18,3,22,18,0,14,
+43,7,1,0,18,5,18,0,22,4,4,4,3,6,5,0,88,9,14,128,41,9,0,0,1,9,4,0,88,9,11,128,
+23,9,5,4,56,9,9,3,23,10,1,4,56,10,10,3,23,11,0,4,56,11,11,3,56,7,4,3,18,8,11,
+0,18,6,10,0,18,5,9,0,23,4,4,4,3,6,5,0,88,9,23,126,43,9,2,0,76,9,2,0,2,4,16,
+0,8,6,0
 #endif
 };
 
@@ -50,7 +188,8 @@ static const struct { const char *name; int ofs; } libbc_map[] = {
 {"table_foreach",136},
 {"table_getn",207},
 {"table_remove",226},
-{"table_move",355},
-{NULL,502}
+{"table_sort_lt",355},
+{"table_sort_aux",386},
+{NULL,2428}
 };
 
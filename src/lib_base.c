@@ -14,6 +14,7 @@
 #include "lua.h"
 #include "lauxlib.h"
 #include "lualib.h"
+#include "luajit.h"
 
 #include "lj_obj.h"
 #include "lj_gc.h"
@@ -409,6 +410,38 @@ LJLIB_CF(load)
   return load_aux(L, status, 4);
 }
 
+static const char *reader_str(lua_State *L, void *ud, size_t *size)
+{
+  GCstr **sp = (GCstr **)ud;
+  GCstr *s = *sp;
+  UNUSED(L);
+  if (s == NULL) return NULL;
+  *sp = NULL;
+  *size = s->len;
+  return strdata(s);
+}
+
+LJLIB_CF(loaddata)
+{
+  GCstr *name = lj_lib_optstr(L, 2);
+  int status;
+  if (L->base < L->top && (tvisstr(L->base) || tvisnumber(L->base))) {
+    GCstr *s = lj_lib_checkstr(L, 1);
+    lua_settop(L, 2);
+    status = luaJIT_loaddata(L, reader_str, &s,
+			     name ? strdata(name) : "=(data)");
+  } else {
+    lj_lib_checkfunc(L, 1);
+    lua_settop(L, 5);  /* Reserve a slot for the string from the reader. */
+    status = luaJIT_loaddata(L, reader_func, NULL,
+			     name ? strdata(name) : "=(data)");
+  }
+  if (status == LUA_OK)
+    return 1;
+  setnilV(L->top-2);
+  return 2;
+}
+
 LJLIB_CF(loadstring)
 {
   return lj_cf_load(L);
@@ -545,7 +578,7 @@ LJLIB_CF(coroutine_status)
   return 1;
 }
 
-LJLIB_CF(coroutine_running)
+LJLIB_CF(coroutine_running)	LJLIB_REC(.)
 {
 #if LJ_52
   int ismain = lua_pushthread(L);
@@ -574,7 +607,7 @@ LJLIB_CF(coroutine_create)
   return 1;
 }
 
-LJLIB_ASM(coroutine_yield)
+LJLIB_ASM(coroutine_yield)	LJLIB_REC(coroutine_switch)
 {
   lj_err_caller(L, LJ_ERR_CYIELD);
   return FFH_UNREACHABLE;
@@ -594,14 +627,14 @@ static int ffh_resume(lua_State *L, lua_State *co, int wrap)
   return FFH_RETRY;
 }
 
-LJLIB_ASM(coroutine_resume)
+LJLIB_ASM(coroutine_resume)	LJLIB_REC(coroutine_switch)
 {
   if (!(L->top > L->base && tvisthread(L->base)))
     lj_err_arg(L, 1, LJ_ERR_NOCORO);
   return ffh_resume(L, threadV(L->base), 0);
 }
 
-LJLIB_NOREG LJLIB_ASM(coroutine_wrap_aux)
+LJLIB_NOREG LJLIB_ASM(coroutine_wrap_aux)	LJLIB_REC(coroutine_switch)
 {
   return ffh_resume(L, threadV(lj_lib_upvalue(L, 1)), 1);
 }
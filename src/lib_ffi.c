@@ -45,8 +45,12 @@ static CTypeID ffi_checkctype(lua_State *L, CTState *cts, TValue *param)
   }
   if (tvisstr(o)) {  /* Parse an abstract C type declaration. */
     GCstr *s = strV(o);
+    cTValue *tv = lj_tab_getstr(cts->typecache, s);
+    CTypeID id, oldtop = cts->top;
     CPState cp;
     int errcode;
+    if (tv && !tvisnil(tv))
+      return (CTypeID)numberVint(tv);
     cp.L = L;
     cp.cts = cts;
     cp.srcname = strdata(s);
@@ -55,6 +59,23 @@ static CTypeID ffi_checkctype(lua_State *L, CTState *cts, TValue *param)
     cp.mode = CPARSE_MODE_ABSTRACT|CPARSE_MODE_NOIMPLICIT;
     errcode = lj_cparse(&cp);
     if (errcode) lj_err_throw(L, errcode);  /* Propagate errors. */
+    /*
+    ** Cache the result, unless it depends on parameters or new struct,
+    ** union or enum types have been declared. These are anonymous or
+    ** incomplete and each parse must give a new type for the former.
+    */
+    if (memchr(strdata(s), '$', s->len))
+      return cp.val.id;
+    for (id = oldtop; id < cts->top; id++)
+      if (ctype_isstruct(ctype_get(cts, id)->info) ||
+	  ctype_isenum(ctype_get(cts, id)->info))
+	return cp.val.id;
+    if (++cts->ntypecache > CTCACHE_MAX) {
+      lj_tab_clear(cts->typecache);
+      cts->ntypecache = 1;
+    }
+    /* NOBARRIER: lj_tab_newkey() handles the barrier. */
+    setintV(lj_tab_setstr(L, cts->typecache, s), (int32_t)cp.val.id);
     return cp.val.id;
   } else {
     GCcdata *cd;
@@ -484,6 +505,8 @@ LJLIB_CF(ffi_cdef)
   cp.p = strdata(s);
   cp.param = L->base+1;
   cp.mode = CPARSE_MODE_MULTI|CPARSE_MODE_DIRECT;
+  lj_tab_clear(cp.cts->typecache);  /* New declarations flush the cache. */
+  cp.cts->ntypecache = 0;
   errcode = lj_cparse(&cp);
   if (errcode) lj_err_throw(L, errcode);  /* Propagate errors. */
   lj_gc_check(L);
@@ -808,8 +831,18 @@ LJLIB_PUSH(top-5) LJLIB_SET(!)  /* Store clib metatable in func environment. */
 LJLIB_CF(ffi_load)
 {
   GCstr *name = lj_lib_checkstr(L, 1);
-  int global = (L->base+1 < L->top && tvistruecond(L->base+1));
-  lj_clib_load(L, tabref(curr_func(L)->c.env), name, global);
+  TValue *o = L->base+1;
+  int global = 0, preload = 0;
+  if (o < L->top && tvistab(o)) {  /* Options table. */
+    cTValue *tv = lj_tab_getstr(tabV(o), lj_str_newlit(L, "global"));
+    global = tv && tvistruecond(tv);
+    tv = lj_tab_getstr(tabV(o), lj_str_newlit(L, "preload"));
+    preload = tv && tvistruecond(tv);
+  } else {
+    global = (o < L->top && tvistruecond(o));
+  }
+  lj_clib_load(L, tabref(curr_func(L)->c.env), name, global, preload);
+  lj_gc_check(L);
   return 1;
 }
 
@@ -858,6 +891,10 @@ LUALIB_API int luaopen_ffi(lua_State *L)
   /* NOBARRIER: the key is new and lj_tab_newkey() handles the barrier. */
   settabV(L, lj_tab_setstr(L, cts->miscmap, &cts->g->strempty), tabV(L->top-1));
   L->top--;
+  /* NOBARRIER: the key is new and lj_tab_newkey() handles the barrier. */
+  settabV(L, lj_tab_setstr(L, cts->miscmap, lj_str_newlit(L, "typecache")),
+	  (cts->typecache = lj_tab_new(L, 0, 0)));
+  cts->ntypecache = 0;
   lj_clib_default(L, tabV(L->top-1));  /* Create ffi.C default namespace. */
   lua_pushliteral(L, LJ_OS_NAME);
   lua_pushliteral(L, LJ_ARCH_NAME);
@@ -26,10 +26,18 @@
 #include "lj_ff.h"
 #include "lj_lib.h"
 
+#if LJ_HASFFI
+#include "lj_ctype.h"
+#include "lj_cconv.h"
+#endif
+
 /* Userdata payload for I/O file. */
 typedef struct IOFileUD {
   FILE *fp;		/* File handle. */
   uint32_t type;	/* File type. */
+  int rerrno;		/* errno of a read error in a trace. */
+  char *lbuf;		/* Line buffer for getdelim() or NULL. */
+  size_t lsize;		/* Size of line buffer. */
 } IOFileUD;
 
 #define IOFILE_TYPE_FILE	0	/* Regular file. */
@@ -38,6 +46,15 @@ typedef struct IOFileUD {
 #define IOFILE_TYPE_MASK	3
 
 #define IOFILE_FLAG_CLOSE	4	/* Close after io.lines() iterator. */
+#define IOFILE_FLAG_RERR	8	/* Pending read error from a trace. */
+
+/* Lines are split inside the stdio buffer with getdelim(), if available. */
+#ifndef LJ_IO_GETDELIM
+#define LJ_IO_GETDELIM		LJ_TARGET_POSIX
+#endif
+
+/* Line buffers above this size are freed after each line. */
+#define IO_LBUF_MAX		(LUAL_BUFFERSIZE*16)
 
 #define IOSTDF_UD(L, id)	(&gcref(G(L)->gcroot[(id)])->ud)
 #define IOSTDF_IOF(L, id)	((IOFileUD *)uddata(IOSTDF_UD(L, (id))))
@@ -60,12 +77,12 @@ static IOFileUD *io_tofile(lua_State *L)
   return iof;
 }
 
-static FILE *io_stdfile(lua_State *L, ptrdiff_t id)
+static IOFileUD *io_stdfile(lua_State *L, ptrdiff_t id)
 {
   IOFileUD *iof = IOSTDF_IOF(L, id);
   if (iof->fp == NULL)
     lj_err_caller(L, LJ_ERR_IOSTDCL);
-  return iof->fp;
+  return iof;
 }
 
 static IOFileUD *io_file_new(lua_State *L)
@@ -77,9 +94,22 @@ static IOFileUD *io_file_new(lua_State *L)
   setgcrefr(ud->metatable, curr_func(L)->c.env);
   iof->fp = NULL;
   iof->type = IOFILE_TYPE_FILE;
+  iof->rerrno = 0;
+  iof->lbuf = NULL;
+  iof->lsize = 0;
   return iof;
 }
 
+/* Free the line buffer. It's allocated by getdelim() with malloc(). */
+static void io_file_freelbuf(IOFileUD *iof)
+{
+  if (iof->lbuf) {
+    free(iof->lbuf);
+    iof->lbuf = NULL;
+    iof->lsize = 0;
+  }
+}
+
 static IOFileUD *io_file_open(lua_State *L, const char *mode)
 {
   const char *fname = strdata(lj_lib_checkstr(L, 1));
@@ -94,9 +124,11 @@ static int io_file_close(lua_State *L, IOFileUD *iof)
 {
   int ok;
   if ((iof->type & IOFILE_TYPE_MASK) == IOFILE_TYPE_FILE) {
+    io_file_freelbuf(iof);
     ok = (fclose(iof->fp) == 0);
   } else if ((iof->type & IOFILE_TYPE_MASK) == IOFILE_TYPE_PIPE) {
     int stat = -1;
+    io_file_freelbuf(iof);
 #if LJ_TARGET_POSIX
     stat = pclose(iof->fp);
 #elif LJ_TARGET_WINDOWS && !LJ_TARGET_XBOXONE
@@ -142,21 +174,45 @@ static int io_file_readnum(lua_State *L, FILE *fp)
   }
 }
 
-static int io_file_readline(lua_State *L, FILE *fp, MSize chop)
+/* Read a line. The result is only valid, if anything was read (*ok). */
+static GCstr *io_file_line(lua_State *L, IOFileUD *iof, MSize chop, int *ok)
 {
-  MSize m = LUAL_BUFFERSIZE, n = 0, ok = 0;
+#if LJ_IO_GETDELIM
+  /* Doesn't read ahead of the FILE and handles embedded '\0', too. */
+  ssize_t n = getdelim(&iof->lbuf, &iof->lsize, '\n', iof->fp);
+  if (n <= 0) {
+    *ok = 0;
+    return &G(L)->strempty;
+  }
+  GCstr *s;
+  *ok = 1;
+  if (iof->lbuf[n-1] == '\n') n -= chop;
+  s = lj_str_new(L, iof->lbuf, (size_t)n);
+  if (iof->lsize > IO_LBUF_MAX)  /* Don't hold on to oversized buffers. */
+    io_file_freelbuf(iof);
+  return s;
+#else
+  MSize m = LUAL_BUFFERSIZE, n = 0, got = 0;
   char *buf;
   for (;;) {
     buf = lj_buf_tmp(L, m);
-    if (fgets(buf+n, m-n, fp) == NULL) break;
+    if (fgets(buf+n, m-n, iof->fp) == NULL) break;
     n += (MSize)strlen(buf+n);
-    ok |= n;
+    got |= n;
     if (n && buf[n-1] == '\n') { n -= chop; break; }
     if (n >= m - 64) m += m;
   }
-  setstrV(L, L->top++, lj_str_new(L, buf, (size_t)n));
+  *ok = (got != 0);
+  return lj_str_new(L, buf, (size_t)n);
+#endif
+}
+
+static int io_file_readline(lua_State *L, IOFileUD *iof, MSize chop)
+{
+  int ok;
+  setstrV(L, L->top++, io_file_line(L, iof, chop, &ok));
   lj_gc_check(L);
-  return (int)ok;
+  return ok;
 }
 
 static void io_file_readall(lua_State *L, FILE *fp)
@@ -189,12 +245,18 @@ static int io_file_readlen(lua_State *L, FILE *fp, MSize m)
   }
 }
 
-static int io_file_read(lua_State *L, FILE *fp, int start)
+static int io_file_read(lua_State *L, IOFileUD *iof, int start)
 {
+  FILE *fp = iof->fp;
   int ok, n, nargs = (int)(L->top - L->base) - start;
+  if ((iof->type & IOFILE_FLAG_RERR)) {  /* Report read error of a trace. */
+    iof->type &= ~IOFILE_FLAG_RERR;
+    errno = iof->rerrno;
+    return luaL_fileresult(L, 0, NULL);
+  }
   clearerr(fp);
   if (nargs == 0) {
-    ok = io_file_readline(L, fp, 1);
+    ok = io_file_readline(L, iof, 1);
     n = start+1;  /* Return 1 result. */
   } else {
     /* The results plus the buffers go on top of the args. */
@@ -207,7 +269,7 @@ static int io_file_read(lua_State *L, FILE *fp, int start)
 	if (p[0] == 'n')
 	  ok = io_file_readnum(L, fp);
 	else if ((p[0] & ~0x20) == 'L')
-	  ok = io_file_readline(L, fp, (p[0] == 'l'));
+	  ok = io_file_readline(L, iof, (p[0] == 'l'));
 	else if (p[0] == 'a')
 	  io_file_readall(L, fp);
 	else
@@ -226,16 +288,36 @@ static int io_file_read(lua_State *L, FILE *fp, int start)
   return n - start;
 }
 
+/* Write the contents of a buffer. */
+static int io_file_writebuf(SBuf *sb, FILE *fp)
+{
+  MSize len = sbuflen(sb);
+  return (fwrite(sbufB(sb), 1, len, fp) == len);
+}
+
 static int io_file_write(lua_State *L, FILE *fp, int start)
 {
-  cTValue *tv;
-  int status = 1;
-  for (tv = L->base+start; tv < L->top; tv++) {
+  cTValue *tv = L->base+start;
+  int status;
+  if (L->top - tv == 1) {  /* Write a single argument directly. */
     MSize len;
     const char *p = lj_strfmt_wstrnum(L, tv, &len);
     if (!p)
-      lj_err_argt(L, (int)(tv - L->base) + 1, LUA_TSTRING);
-    status = status && (fwrite(p, 1, len, fp) == len);
+      lj_err_argt(L, start+1, LUA_TSTRING);
+    status = (fwrite(p, 1, len, fp) == len);
+  } else {  /* Gather all arguments and write them with a single fwrite(). */
+    SBuf *sb = lj_buf_tmp_(L);
+    for (; tv < L->top; tv++) {
+      if (tvisstr(tv))
+	lj_buf_putstr(sb, strV(tv));
+      else if (tvisint(tv))
+	lj_strfmt_putint(sb, intV(tv));
+      else if (tvisnum(tv))
+	lj_strfmt_putfnum(sb, STRFMT_NUMDEF, tv->n);
+      else
+	lj_err_argt(L, (int)(tv - L->base) + 1, LUA_TSTRING);
+    }
+    status = io_file_writebuf(sb, fp);
   }
   if (LJ_52 && status) {
     L->top = L->base+1;
@@ -246,7 +328,11 @@ static int io_file_write(lua_State *L, FILE *fp, int start)
   return luaL_fileresult(L, status, NULL);
 }
 
-static int io_file_iter(lua_State *L)
+/* -- I/O file methods ---------------------------------------------------- */
+
+#define LJLIB_MODULE_io_method
+
+LJLIB_NOREG LJLIB_CF(io_file_iter)	LJLIB_REC(.)
 {
   GCfunc *fn = curr_func(L);
   IOFileUD *iof = uddata(udataV(&fn->c.upvalue[0]));
@@ -261,7 +347,7 @@ static int io_file_iter(lua_State *L)
     memcpy(L->top, &fn->c.upvalue[1], n*sizeof(TValue));
     L->top += n;
   }
-  n = io_file_read(L, iof->fp, 0);
+  n = io_file_read(L, iof, 0);
   if (ferror(iof->fp))
     lj_err_callermsg(L, strVdata(L->top-2));
   if (tvisnil(L->base) && (iof->type & IOFILE_FLAG_CLOSE)) {
@@ -276,14 +362,10 @@ static int io_file_lines(lua_State *L)
   int n = (int)(L->top - L->base);
   if (n > LJ_MAX_UPVAL)
     lj_err_caller(L, LJ_ERR_UNPACK);
-  lua_pushcclosure(L, io_file_iter, n);
+  lj_lib_pushcc(L, lj_cf_io_file_iter, FF_io_file_iter, n);
   return 1;
 }
 
-/* -- I/O file methods ---------------------------------------------------- */
-
-#define LJLIB_MODULE_io_method
-
 LJLIB_CF(io_method_close)
 {
   IOFileUD *iof = L->base < L->top ? io_tofile(L) :
@@ -291,9 +373,9 @@ LJLIB_CF(io_method_close)
   return io_file_close(L, iof);
 }
 
-LJLIB_CF(io_method_read)
+LJLIB_CF(io_method_read)		LJLIB_REC(io_read 0)
 {
-  return io_file_read(L, io_tofile(L)->fp, 1);
+  return io_file_read(L, io_tofile(L), 1);
 }
 
 LJLIB_CF(io_method_write)		LJLIB_REC(io_write 0)
@@ -306,6 +388,67 @@ LJLIB_CF(io_method_flush)		LJLIB_REC(io_flush 0)
   return luaL_fileresult(L, fflush(io_tofile(L)->fp) == 0, NULL);
 }
 
+#if LJ_HASFFI
+/* Read up to len bytes into a C buffer. */
+static MSize io_file_readbuf(IOFileUD *iof, char *p, MSize len)
+{
+  clearerr(iof->fp);
+  return (MSize)fread(p, 1, len, iof->fp);
+}
+
+/* Convert argument to a C pointer. */
+static void *io_checkptr(lua_State *L, int narg, CTypeID id)
+{
+  TValue *o = L->base + narg-1;
+  CTState *cts;
+  void *p;
+  if (!(o < L->top && tviscdata(o)))
+    lj_err_argt(L, narg, LUA_TCDATA);
+  cts = ctype_cts(L);
+  lj_cconv_ct_tv(cts, ctype_get(cts, id), (uint8_t *)&p, o, CCF_ARG(narg));
+  return p;
+}
+
+/* Get the length argument for a C buffer. */
+static MSize io_checklen(lua_State *L, int narg)
+{
+  int32_t len = lj_lib_checkint(L, narg);
+  if (len < 0)
+    lj_err_arg(L, narg, LJ_ERR_IDXRNG);
+  return (MSize)len;
+}
+
+LJLIB_CF(io_method_readinto)	LJLIB_REC(io_readinto)
+{
+  IOFileUD *iof = io_tofile(L);
+  void *p = io_checkptr(L, 2, CTID_P_VOID);
+  MSize n;
+  if ((iof->type & IOFILE_FLAG_RERR)) {  /* Report read error of a trace. */
+    iof->type &= ~IOFILE_FLAG_RERR;
+    errno = iof->rerrno;
+    return luaL_fileresult(L, 0, NULL);
+  }
+  n = io_file_readbuf(iof, (char *)p, io_checklen(L, 3));
+  if (ferror(iof->fp))
+    return luaL_fileresult(L, 0, NULL);
+  setintV(L->top++, (int32_t)n);
+  return 1;
+}
+
+LJLIB_CF(io_method_writefrom)	LJLIB_REC(io_writefrom)
+{
+  IOFileUD *iof = io_tofile(L);
+  const void *p = io_checkptr(L, 2, CTID_P_CVOID);
+  MSize len = io_checklen(L, 3);
+  int status = (fwrite(p, 1, len, iof->fp) == len);
+  if (LJ_52 && status) {
+    L->top = L->base+1;
+    return 1;
+  }
+  return luaL_fileresult(L, status, NULL);
+}
+#endif
+
 LJLIB_CF(io_method_seek)
 {
   FILE *fp = io_tofile(L)->fp;
@@ -371,6 +514,7 @@ LJLIB_CF(io_method___gc)
   IOFileUD *iof = io_tofilep(L);
   if (iof->fp != NULL && (iof->type & IOFILE_TYPE_MASK) != IOFILE_TYPE_STDF)
     io_file_close(L, iof);
+  io_file_freelbuf(iof);
   return 0;
 }
 
@@ -440,19 +584,20 @@ LJLIB_CF(io_close)
   return lj_cf_io_method_close(L);
 }
 
-LJLIB_CF(io_read)
+LJLIB_CF(io_read)		LJLIB_REC(io_read GCROOT_IO_INPUT)
 {
   return io_file_read(L, io_stdfile(L, GCROOT_IO_INPUT), 0);
 }
 
 LJLIB_CF(io_write)		LJLIB_REC(io_write GCROOT_IO_OUTPUT)
 {
-  return io_file_write(L, io_stdfile(L, GCROOT_IO_OUTPUT), 0);
+  return io_file_write(L, io_stdfile(L, GCROOT_IO_OUTPUT)->fp, 0);
 }
 
 LJLIB_CF(io_flush)		LJLIB_REC(io_flush GCROOT_IO_OUTPUT)
 {
-  return luaL_fileresult(L, fflush(io_stdfile(L, GCROOT_IO_OUTPUT)) == 0, NULL);
+  FILE *fp = io_stdfile(L, GCROOT_IO_OUTPUT)->fp;
+  return luaL_fileresult(L, fflush(fp) == 0, NULL);
 }
 
 static int io_std_getset(lua_State *L, ptrdiff_t id, const char *mode)
@@ -487,7 +632,7 @@ LJLIB_CF(io_lines)
   if (L->base == L->top) setnilV(L->top++);
   if (!tvisnil(L->base)) {  /* io.lines(fname) */
     IOFileUD *iof = io_file_open(L, "r");
-    iof->type = IOFILE_TYPE_FILE|IOFILE_FLAG_CLOSE;
+    iof->type |= IOFILE_FLAG_CLOSE;
     L->top--;
     setudataV(L, L->base, udataV(L->top));
   } else {  /* io.lines() iterates over stdin. */
@@ -510,6 +655,69 @@ LJLIB_CF(io_type)
 
 #include "lj_libdef.h"
 
+/* -- JIT compiler helpers ------------------------------------------------ */
+
+#if LJ_HASJIT
+/* Keep a read error of a trace for the interpreter. It must not retry
+** the read, since part of the data may have been consumed already.
+*/
+static void io_file_setrerr(IOFileUD *iof)
+{
+  iof->rerrno = errno;
+  iof->type |= IOFILE_FLAG_RERR;
+}
+
+/* Read a line for a trace. Returns NULL, if the interpreter should take
+** over, i.e. on EOF, on an error, for a closed file or a pending error.
+*/
+GCstr *lj_lib_io_readline(lua_State *L, GCudata *ud, int32_t chop)
+{
+  IOFileUD *iof = (IOFileUD *)uddata(ud);
+  GCstr *s;
+  int ok;
+  if (iof->fp == NULL || (iof->type & IOFILE_FLAG_RERR))
+    return NULL;
+  clearerr(iof->fp);
+  s = io_file_line(L, iof, (MSize)chop, &ok);
+  if (ferror(iof->fp)) {
+    io_file_setrerr(iof);
+    return NULL;
+  }
+  return ok ? s : NULL;
+}
+
+/* Read a line for the io.lines() iterator without read formats. */
+GCstr *lj_lib_io_iterline(lua_State *L, GCfunc *fn)
+{
+  if (fn->c.nupvalues != 1)
+    return NULL;
+  return lj_lib_io_readline(L, udataV(&fn->c.upvalue[0]), 1);
+}
+
+/* Write the buffer with the gathered arguments of io.write() for a trace. */
+int32_t lj_lib_io_writebuf(SBuf *sb, void *fp)
+{
+  return io_file_writebuf(sb, (FILE *)fp);
+}
+
+#if LJ_HASFFI
+/* Read into a C buffer for a trace. Returns -1 on an error. */
+int32_t lj_lib_io_readinto(GCudata *ud, void *p, int32_t len)
+{
+  IOFileUD *iof = (IOFileUD *)uddata(ud);
+  MSize n;
+  if ((iof->type & IOFILE_FLAG_RERR))
+    return -1;
+  n = io_file_readbuf(iof, (char *)p, (MSize)len);
+  if (ferror(iof->fp)) {
+    io_file_setrerr(iof);
+    return -1;
+  }
+  return (int32_t)n;
+}
+#endif
+#endif
+
 /* ------------------------------------------------------------------------ */
 
 static GCobj *io_std_new(lua_State *L, FILE *fp, const char *name)
@@ -521,6 +729,9 @@ static GCobj *io_std_new(lua_State *L, FILE *fp, const char *name)
   setgcref(ud->metatable, gcV(L->top-3));
   iof->fp = fp;
   iof->type = IOFILE_TYPE_STDF;
+  iof->rerrno = 0;
+  iof->lbuf = NULL;
+  iof->lsize = 0;
   lua_setfield(L, -2, name);
   return obj2gco(ud);
 }
@@ -18,6 +18,7 @@
 #include "lj_tab.h"
 #include "lj_state.h"
 #include "lj_bc.h"
+#include "lj_bcdump.h"
 #if LJ_HASFFI
 #include "lj_ctype.h"
 #endif
@@ -249,6 +250,8 @@ LJLIB_CF(jit_util_funck)
   } else {
     if (~idx < (ptrdiff_t)pt->sizekgc) {
       GCobj *gc = proto_kgc(pt, idx);
+      if (gc->gch.gct == ~LJ_TPROTO && proto_islazy(gco2pt(gc)))
+	gc = obj2gco(lj_bcread_lazy(L, pt, gco2pt(gc)));
       setgcV(L, L->top-1, gc, ~gc->gch.gct);
       return 1;
     }
@@ -499,7 +502,7 @@ static int jitopt_param(jit_State *J, const char *str)
 	n = n*10 + (*p++ - '0');
       if (*p) return 0;  /* Malformed number. */
       J->param[i] = n;
-      if (i == JIT_P_hotloop)
+      if (i == JIT_P_hotloop || i == JIT_P_hotverify)
 	lj_dispatch_init_hotcount(J2G(J));
       return 1;  /* Ok. */
     }
@@ -39,7 +39,7 @@ LJLIB_CF(misc_getmetrics)
   struct luam_Metrics metrics;
   GCtab *m;
 
-  lua_createtable(L, 0, 19);
+  lua_createtable(L, 0, 22);
   m = tabV(L->top - 1);
 
   luaM_metrics(L, &metrics);
@@ -51,6 +51,8 @@ LJLIB_CF(misc_getmetrics)
   setnumfield(L, m, "gc_tabnum", metrics.gc_tabnum);
   setnumfield(L, m, "gc_udatanum", metrics.gc_udatanum);
   setnumfield(L, m, "gc_cdatanum", metrics.gc_cdatanum);
+  setnumfield(L, m, "gc_cdatapool_hit", metrics.gc_cdatapool_hit);
+  setnumfield(L, m, "gc_cdatapool_miss", metrics.gc_cdatapool_miss);
 
   setnumfield(L, m, "gc_total", metrics.gc_total);
   setnumfield(L, m, "gc_freed", metrics.gc_freed);
@@ -67,6 +69,8 @@ LJLIB_CF(misc_getmetrics)
   setnumfield(L, m, "jit_trace_abort", metrics.jit_trace_abort);
   setnumfield(L, m, "jit_mcode_size", metrics.jit_mcode_size);
   setnumfield(L, m, "jit_trace_num", metrics.jit_trace_num);
+  setnumfield(L, m, "jit_hotcount_collisions",
+	      metrics.jit_hotcount_collisions);
 
   return 1;
 }
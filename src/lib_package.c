@@ -12,10 +12,21 @@
 #include "lua.h"
 #include "lauxlib.h"
 #include "lualib.h"
+#include "luajit.h"
 
 #include "lj_obj.h"
 #include "lj_err.h"
 #include "lj_lib.h"
+#include "lj_bc.h"
+
+#if LJ_TARGET_POSIX
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <time.h>
+#endif
 
 /* ------------------------------------------------------------------------ */
 
@@ -265,11 +276,147 @@ static int lj_cf_package_unloadlib(lua_State *L)
   return 0;
 }
 
+/* -- Directory listing cache --------------------------------------------- */
+
+#if LJ_TARGET_POSIX
+
+/*
+** If enabled with package.dircache(), the search for a module file does
+** not probe each template with fopen(). Instead each directory is listed
+** once and the listing is kept in the registry table _DIRCACHE, keyed by
+** the directory name. The listing maps file names to true and holds the
+** directory mtime at index 0. In "on" mode the listings are trusted
+** until package.dircache("flush"). In "mtime" mode ([0] of _DIRCACHE is
+** true) a listing is revalidated with a single stat() of the directory.
+** Listings of directories modified within the current second are used
+** for the current lookup only, in either mode.
+*/
+
+#define DIRCACHE_KEY	"_DIRCACHE"
+
+/* Get directory mtime. Returns -1 if it may change within this second. */
+static lua_Number dircache_mtime(const char *dir)
+{
+  struct stat st;
+  if (stat(dir, &st) != 0) return 0;  /* Missing directories are cached. */
+  return st.st_mtime < time(NULL) ? (lua_Number)st.st_mtime : -1;
+}
+
+/* List directory, push the listing and return its mtime. */
+static lua_Number dircache_scan(lua_State *L, const char *dir)
+{
+  lua_Number mtime = dircache_mtime(dir);  /* Before reading entries. */
+  DIR *dp = opendir(dir);
+  lua_newtable(L);
+  if (dp != NULL) {
+    struct dirent *de;
+    while ((de = readdir(dp)) != NULL) {
+      lua_pushboolean(L, 1);
+      lua_setfield(L, -2, de->d_name);
+    }
+    closedir(dp);
+  }
+  lua_pushnumber(L, mtime);
+  lua_rawseti(L, -2, 0);
+  return mtime;
+}
+
+/* Lookup file in the cached listing. Returns -1 if the cache is disabled. */
+static int dircache_lookup(lua_State *L, const char *filename)
+{
+  const char *base = strrchr(filename, *LUA_DIRSEP);
+  int found;
+  lua_getfield(L, LUA_REGISTRYINDEX, DIRCACHE_KEY);
+  if (!lua_istable(L, -1)) {
+    lua_pop(L, 1);
+    return -1;
+  }
+  if (base != NULL) {
+    lua_pushlstring(L, filename, base == filename ? 1 : (size_t)(base-filename));
+    base++;
+  } else {
+    lua_pushliteral(L, ".");
+    base = filename;
+  }
+  lua_pushvalue(L, -1);
+  lua_rawget(L, -3);
+  if (lua_istable(L, -1)) {
+    lua_rawgeti(L, -3, 0);
+    if (lua_toboolean(L, -1)) {  /* Revalidate listing? */
+      lua_rawgeti(L, -2, 0);
+      if (lua_tonumber(L, -1) != dircache_mtime(lua_tostring(L, -4))) {
+	lua_pushnil(L);
+	lua_replace(L, -4);
+      }
+      lua_pop(L, 1);
+    }
+    lua_pop(L, 1);
+  }
+  if (lua_isnil(L, -1)) {
+    const char *dir = lua_tostring(L, -2);
+    size_t len = (size_t)(base - filename) - 1;
+    lua_Number mtime;
+    /*
+    ** Don't list directories which are missing in the parent listing,
+    ** e.g. the ones generated by "?/init.lua" templates.
+    */
+    if (base - 1 > filename && dir[len-1] != *LUA_DIRSEP &&
+	dircache_lookup(L, dir) == 0) {
+      lua_pop(L, 3);
+      return 0;
+    }
+    lua_pop(L, 1);
+    mtime = dircache_scan(L, dir);
+    lua_pushvalue(L, -2);
+    if (mtime != -1)
+      lua_pushvalue(L, -2);
+    else
+      lua_pushnil(L);  /* Don't cache recent listings, drop stale ones. */
+    lua_rawset(L, -5);  /* _DIRCACHE[dir] = listing */
+  }
+  lua_getfield(L, -1, base);
+  found = lua_toboolean(L, -1);
+  lua_pop(L, 4);
+  return found;
+}
+
+static int lj_cf_package_dircache(lua_State *L)
+{
+  static const char *const modes[] = { "off", "on", "mtime", "flush", NULL };
+  int mode = luaL_checkoption(L, 1, NULL, modes);
+  int validate = 0;
+  lua_getfield(L, LUA_REGISTRYINDEX, DIRCACHE_KEY);
+  if (lua_istable(L, -1)) {
+    lua_rawgeti(L, -1, 0);
+    validate = lua_toboolean(L, -1);
+  } else if (mode == 3) {
+    return 0;  /* Nothing to flush. */
+  }
+  if (mode == 0) {
+    lua_pushnil(L);
+  } else {
+    lua_createtable(L, 0, 16);
+    lua_pushboolean(L, mode == 3 ? validate : mode == 2);
+    lua_rawseti(L, -2, 0);
+  }
+  lua_setfield(L, LUA_REGISTRYINDEX, DIRCACHE_KEY);
+  return 0;
+}
+
+#endif
+
 /* ------------------------------------------------------------------------ */
 
-static int readable(const char *filename)
+static int readable(lua_State *L, const char *filename)
 {
-  FILE *f = fopen(filename, "r");  /* try to open file */
+  FILE *f;
+#if LJ_TARGET_POSIX
+  int found = dircache_lookup(L, filename);
+  if (found >= 0) return found;
+#else
+  UNUSED(L);
+#endif
+  f = fopen(filename, "r");  /* try to open file */
   if (f == NULL) return 0;  /* open failed */
   fclose(f);
   return 1;
@@ -300,7 +447,7 @@ static const char *searchpath (lua_State *L, const char *name,
     lua_remove(L, -2);  /* remove path template */
     goto check_readable; /* suppress "unused label" warning */
 check_readable:
-    if (readable(filename))  /* does file exist and is readable? */
+    if (readable(L, filename))  /* does file exist and is readable? */
       return filename;  /* return that file name */
     lua_pushfstring(L, "\n\tno file " LUA_QS, filename);
 #if LJ_TARGET_OSX || LJ_TARGET_IOS
@@ -354,12 +501,159 @@ static void loaderror(lua_State *L, const char *filename)
 	     lua_tostring(L, 1), filename, lua_tostring(L, -1));
 }
 
+/* -- Bytecode cache ------------------------------------------------------ */
+
+#if LJ_TARGET_POSIX
+
+/*
+** If package.bccache is set to a directory, the Lua loader stores the
+** bytecode of each loaded module there and loads it on subsequent runs
+** instead of parsing the source again. Each cache file starts with a
+** text header line holding the key: the VM build ID, the size, mtime
+** and inode of the source file and its canonical path. A cache file is
+** only used if the whole key matches, otherwise it's overwritten. Like
+** for the directory cache, a source file modified within the current
+** second bypasses the cache, since another change within the same second
+** wouldn't alter its mtime.
+*/
+
+#define BCCACHE_MAGIC	"LJBCCACHE"
+
+/* Build ID. Changes whenever the bytecode set or the dump format do. */
+#define BCNAME(name, ma, mb, mc, mt)	#name #ma #mb #mc #mt
+static const char bccache_build[] =
+  LUAJIT_VERSION BCDEF(BCNAME);
+#undef BCNAME
+
+/* FNV-1a hash. */
+static uint64_t bccache_hash(const char *s, size_t len)
+{
+  uint64_t h = U64x(cbf29ce4,84222325);
+  while (len--) h = (h ^ (uint8_t)*s++) * U64x(00000100,000001b3);
+  return h;
+}
+
+/* Push cache file name and the expected header. Returns 0 if disabled. */
+static int bccache_key(lua_State *L, const char *filename)
+{
+  const char *dir;
+  char *path;
+  struct stat st;
+  char buf[80];
+  lua_getfield(L, LUA_ENVIRONINDEX, "bccache");
+  dir = lua_tostring(L, -1);
+  if (dir == NULL || *dir == '\0' || (path = realpath(filename, NULL)) == NULL) {
+    lua_pop(L, 1);
+    return 0;
+  }
+  if (stat(path, &st) != 0 || !S_ISREG(st.st_mode) ||
+      st.st_mtime >= time(NULL)) {
+    free(path);
+    lua_pop(L, 1);
+    return 0;
+  }
+  sprintf(buf, "%016llx.bc",
+	  (unsigned long long)bccache_hash(path, strlen(path)));
+  lua_pushfstring(L, "%s" LUA_DIRSEP "%s", dir, buf);
+  sprintf(buf, " %08x %llu %lld %llu ",
+	  (uint32_t)bccache_hash(bccache_build, sizeof(bccache_build)-1),
+	  (unsigned long long)st.st_size, (long long)st.st_mtime,
+	  (unsigned long long)st.st_ino);
+  lua_pushfstring(L, BCCACHE_MAGIC "%s%s\n", buf, path);
+  free(path);
+  lua_remove(L, -3);  /* Remove directory. */
+  return 1;
+}
+
+typedef struct BCCacheReaderCtx {
+  FILE *fp;
+  char buf[LUAL_BUFFERSIZE];
+} BCCacheReaderCtx;
+
+static const char *bccache_reader(lua_State *L, void *ud, size_t *size)
+{
+  BCCacheReaderCtx *ctx = (BCCacheReaderCtx *)ud;
+  UNUSED(L);
+  if (feof(ctx->fp)) return NULL;
+  *size = fread(ctx->buf, 1, sizeof(ctx->buf), ctx->fp);
+  return *size > 0 ? ctx->buf : NULL;
+}
+
+/* Load a cached module. Cache file name and header are at the top. */
+static int bccache_load(lua_State *L, const char *filename)
+{
+  size_t len;
+  const char *hdr = lua_tolstring(L, -1, &len);
+  BCCacheReaderCtx ctx;
+  int status = -1;
+  ctx.fp = fopen(lua_tostring(L, -2), "rb");
+  if (ctx.fp == NULL) return 0;
+  if (len <= sizeof(ctx.buf) && fread(ctx.buf, 1, len, ctx.fp) == len &&
+      memcmp(ctx.buf, hdr, len) == 0) {
+    status = lua_loadx(L, bccache_reader, &ctx,
+		       lua_pushfstring(L, "@%s", filename), "b");
+    lua_remove(L, -2);  /* Remove chunkname. */
+    if (status != 0) lua_pop(L, 1);  /* Drop error and load the source. */
+  }
+  fclose(ctx.fp);
+  return status == 0;
+}
+
+static int bccache_writer(lua_State *L, const void *p, size_t sz, void *ud)
+{
+  UNUSED(L);
+  return fwrite(p, 1, sz, (FILE *)ud) != sz;
+}
+
+/* Store the loaded module. Cache file name and header are below it. */
+static void bccache_store(lua_State *L)
+{
+  size_t len;
+  const char *hdr = lua_tolstring(L, -2, &len);
+  size_t sz;
+  const char *name = lua_tolstring(L, -3, &sz);
+  char *tmp = (char *)lua_newuserdata(L, sz + sizeof(".XXXXXX"));
+  int fd;
+  memcpy(tmp, name, sz);
+  memcpy(tmp + sz, ".XXXXXX", sizeof(".XXXXXX"));
+  fd = mkstemp(tmp);
+  if (fd >= 0) {
+    FILE *fp = fdopen(fd, "wb");
+    int ok = 0;
+    if (fp) {
+      lua_pushvalue(L, -2);
+      ok = fwrite(hdr, 1, len, fp) == len &&
+	   lua_dump(L, bccache_writer, fp) == 0;
+      lua_pop(L, 1);
+      ok = (fclose(fp) == 0) && ok;
+    } else {
+      close(fd);
+    }
+    /* Atomically replace the cache file, so readers never see a partial one. */
+    if (!(ok && rename(tmp, lua_tostring(L, -4)) == 0))
+      remove(tmp);
+  }
+  lua_pop(L, 1);
+}
+
+#endif
+
 static int lj_cf_package_loader_lua(lua_State *L)
 {
   const char *filename;
   const char *name = luaL_checkstring(L, 1);
   filename = findfile(L, name, "path");
   if (filename == NULL) return 1;  /* library not found in this path */
+#if LJ_TARGET_POSIX
+  if (bccache_key(L, filename)) {
+    if (bccache_load(L, filename))
+      return 1;  /* library loaded from the cache */
+    if (luaL_loadfile(L, filename) != 0)
+      loaderror(L, filename);
+    bccache_store(L);
+    return 1;  /* library loaded successfully */
+  }
+#endif
   if (luaL_loadfile(L, filename) != 0)
     loaderror(L, filename);
   return 1;  /* library loaded successfully */
@@ -558,6 +852,9 @@ static void setpath(lua_State *L, const char *fieldname, const char *envname,
 static const luaL_Reg package_lib[] = {
   { "loadlib",	lj_cf_package_loadlib },
   { "searchpath",  lj_cf_package_searchpath },
+#if LJ_TARGET_POSIX
+  { "dircache",	lj_cf_package_dircache },
+#endif
   { "seeall",	lj_cf_package_seeall },
   { NULL, NULL }
 };
@@ -601,6 +898,15 @@ LUALIB_API int luaopen_package(lua_State *L)
   lua_pop(L, 1);
   setpath(L, "path", LUA_PATH, LUA_PATH_DEFAULT, noenv);
   setpath(L, "cpath", LUA_CPATH, LUA_CPATH_DEFAULT, noenv);
+#if LJ_TARGET_POSIX
+  if (!noenv) {  /* Bytecode cache is disabled by default. */
+    const char *dir = getenv(LUA_BCCACHE);
+    if (dir != NULL) {
+      lua_pushstring(L, dir);
+      lua_setfield(L, -2, "bccache");
+    }
+  }
+#endif
   lua_pushliteral(L, LUA_PATH_CONFIG);
   lua_setfield(L, -2, "config");
   luaL_findtable(L, LUA_REGISTRYINDEX, "_LOADED", 16);
@@ -17,7 +17,9 @@
 #include "lj_gc.h"
 #include "lj_err.h"
 #include "lj_buf.h"
+#include "lj_str.h"
 #include "lj_tab.h"
+#include "lj_meta.h"
 #include "lj_ff.h"
 #include "lj_lib.h"
 
@@ -129,25 +131,42 @@ LJLIB_LUA(table_remove) /*
   end
 */
 
-LJLIB_LUA(table_move) /*
-  function(a1, f, e, t, a2)
-    CHECK_tab(a1)
-    CHECK_int(f)
-    CHECK_int(e)
-    CHECK_int(t)
-    if a2 == nil then a2 = a1 end
-    CHECK_tab(a2)
-    if e >= f then
-      local d = t - f
-      if t > e or t <= f or a2 ~= a1 then
-	for i=f,e do a2[i+d] = a1[i] end
-      else
-	for i=e,f,-1 do a2[i+d] = a1[i] end
-      end
-    end
-    return a2
-  end
-*/
+LJLIB_CF(table_move)		LJLIB_REC(.)
+{
+  GCtab *a1 = lj_lib_checktab(L, 1);
+  int32_t f = lj_lib_checkint(L, 2);
+  int32_t e = lj_lib_checkint(L, 3);
+  int32_t t = lj_lib_checkint(L, 4);
+  int narg2 = (L->base+4 < L->top && !tvisnil(L->base+4)) ? 5 : 1;
+  GCtab *a2 = narg2 == 5 ? lj_lib_checktab(L, 5) : a1;
+  if (e >= f) {
+    int32_t n = e - f, i;
+    if (!(f > 0 || e < INT_MAX + f))
+      lj_err_arg(L, 3, LJ_ERR_TABMOVE);
+    if (t > INT_MAX - n)
+      lj_err_arg(L, 4, LJ_ERR_TABWRAP);
+    if (!lj_meta_fast(L, tabref(a1->metatable), MM_index) &&
+	!lj_meta_fast(L, tabref(a2->metatable), MM_newindex)) {
+      lj_tab_move(L, a2, a1, f, e, t);  /* Raw bulk move. */
+    } else if (t > e || t <= f || a2 != a1) {
+      for (i = 0; i <= n; i++) {
+	lua_pushinteger(L, t + i);
+	lua_pushinteger(L, f + i);
+	lua_gettable(L, 1);
+	lua_settable(L, narg2);
+      }
+    } else {
+      for (i = n; i >= 0; i--) {
+	lua_pushinteger(L, t + i);
+	lua_pushinteger(L, f + i);
+	lua_gettable(L, 1);
+	lua_settable(L, narg2);
+      }
+    }
+  }
+  lua_pushvalue(L, narg2);
+  return 1;
+}
 
 LJLIB_CF(table_concat)		LJLIB_REC(.)
 {
@@ -169,93 +188,409 @@ LJLIB_CF(table_concat)		LJLIB_REC(.)
   return 1;
 }
 
-/* ------------------------------------------------------------------------ */
+/* -- Sorting ------------------------------------------------------------- */
+
+/*
+** Pattern-defeating quicksort (pdqsort). Small ranges are sorted with an
+** insertion sort. Ranges with many elements equal to the pivot are split
+** off. Highly unbalanced partitions shuffle some elements and fall back
+** to heapsort, once too many of them happen. This gives O(n log n) worst
+** case and O(n) for sorted input.
+**
+** The C version below is used for arrays of numbers or strings without a
+** comparison function. table_sort_aux is the same algorithm written in
+** Lua, so it can be traced and the calls to the comparison function can
+** be inlined. The latter has to detect invalid order functions, too.
+*/
+
+#define SORT_INSMAX	24	/* Insertion sort up to this size. */
+#define SORT_NINTHER	128	/* Tukey's ninther above this size. */
+#define SORT_PARTMAX	8	/* Max. moves for partial insertion sort. */
+
+/* Compare numbers or strings. */
+static LJ_AINLINE int sort_lt(cTValue *a, cTValue *b, int isstr)
+{
+  if (isstr)
+    return strV(a) != strV(b) && lj_str_cmp(strV(a), strV(b)) < 0;
+  else
+    return numberVnum(a) < numberVnum(b);
+}
 
-static void set2(lua_State *L, int i, int j)
+static LJ_AINLINE void sort_swap(TValue *a, TValue *b)
 {
-  lua_rawseti(L, 1, i);
-  lua_rawseti(L, 1, j);
+  TValue tmp = *a; *a = *b; *b = tmp;
 }
 
-static int sort_comp(lua_State *L, int a, int b)
+static LJ_AINLINE void sort_3(TValue *a, TValue *b, TValue *c, int isstr)
 {
-  if (!lua_isnil(L, 2)) {  /* function? */
-    int res;
-    lua_pushvalue(L, 2);
-    lua_pushvalue(L, a-1);  /* -1 to compensate function */
-    lua_pushvalue(L, b-2);  /* -2 to compensate function and `a' */
-    lua_call(L, 2, 1);
-    res = lua_toboolean(L, -1);
-    lua_pop(L, 1);
-    return res;
-  } else {  /* a < b? */
-    return lua_lessthan(L, a, b);
+  if (sort_lt(b, a, isstr)) sort_swap(a, b);
+  if (sort_lt(c, b, isstr)) {
+    sort_swap(b, c);
+    if (sort_lt(b, a, isstr)) sort_swap(a, b);
   }
 }
 
-static void auxsort(lua_State *L, int l, int u)
+static void sort_ins(TValue *b, TValue *e, int isstr)
 {
-  while (l < u) {  /* for tail recursion */
-    int i, j;
-    /* sort elements a[l], a[(l+u)/2] and a[u] */
-    lua_rawgeti(L, 1, l);
-    lua_rawgeti(L, 1, u);
-    if (sort_comp(L, -1, -2))  /* a[u] < a[l]? */
-      set2(L, l, u);  /* swap a[l] - a[u] */
-    else
-      lua_pop(L, 2);
-    if (u-l == 1) break;  /* only 2 elements */
-    i = (l+u)/2;
-    lua_rawgeti(L, 1, i);
-    lua_rawgeti(L, 1, l);
-    if (sort_comp(L, -2, -1)) {  /* a[i]<a[l]? */
-      set2(L, i, l);
+  TValue *i;
+  for (i = b+1; i < e; i++) {
+    TValue x = *i, *j = i;
+    while (j > b && sort_lt(&x, j-1, isstr)) { *j = j[-1]; j--; }
+    *j = x;
+  }
+}
+
+/* Insertion sort which gives up after too many moves. */
+static int sort_partins(TValue *b, TValue *e, int isstr)
+{
+  MSize moves = 0;
+  TValue *i;
+  for (i = b+1; i < e; i++) {
+    if (sort_lt(i, i-1, isstr)) {
+      TValue x = *i, *j = i;
+      do { *j = j[-1]; j--; } while (j > b && sort_lt(&x, j-1, isstr));
+      *j = x;
+      moves += (MSize)(i - j);
+      if (moves > SORT_PARTMAX) return 0;
+    }
+  }
+  return 1;
+}
+
+static void sort_heap(TValue *b, TValue *e, int isstr)
+{
+  ptrdiff_t n = e - b, k = n/2;
+  while (n > 1) {
+    ptrdiff_t i;
+    TValue x;
+    if (k > 0) {  /* Build the heap. */
+      i = --k;
+    } else {  /* Move the maximum to the end. */
+      sort_swap(b, b + --n);
+      i = 0;
+    }
+    x = b[i];
+    for (;;) {  /* Sift down. */
+      ptrdiff_t c = 2*i+1;
+      if (c >= n) break;
+      if (c+1 < n && sort_lt(&b[c], &b[c+1], isstr)) c++;
+      if (!sort_lt(&x, &b[c], isstr)) break;
+      b[i] = b[c];
+      i = c;
+    }
+    b[i] = x;
+  }
+}
+
+/* Partition around the pivot at b. Elements equal to it go to the right. */
+static TValue *sort_partright(TValue *b, TValue *e, int *done, int isstr)
+{
+  TValue pivot = *b, *f = b, *l = e;
+  while (sort_lt(++f, &pivot, isstr)) ;
+  if (f-1 == b)
+    while (f < l && !sort_lt(--l, &pivot, isstr)) ;
+  else
+    while (!sort_lt(--l, &pivot, isstr)) ;
+  *done = f >= l;  /* Already partitioned? */
+  while (f < l) {
+    sort_swap(f, l);
+    while (sort_lt(++f, &pivot, isstr)) ;
+    while (!sort_lt(--l, &pivot, isstr)) ;
+  }
+  f--;
+  *b = *f; *f = pivot;
+  return f;
+}
+
+/* Partition around the pivot at b. Elements equal to it go to the left. */
+static TValue *sort_partleft(TValue *b, TValue *e, int isstr)
+{
+  TValue pivot = *b, *f = b, *l = e;
+  while (sort_lt(&pivot, --l, isstr)) ;
+  if (l+1 == e)
+    while (f < l && !sort_lt(&pivot, ++f, isstr)) ;
+  else
+    while (!sort_lt(&pivot, ++f, isstr)) ;
+  while (f < l) {
+    sort_swap(f, l);
+    while (sort_lt(&pivot, --l, isstr)) ;
+    while (!sort_lt(&pivot, ++f, isstr)) ;
+  }
+  *b = *l; *l = pivot;
+  return l;
+}
+
+static void sort_pdq(TValue *b, TValue *e, int bad, int leftmost, int isstr)
+{
+  for (;;) {
+    ptrdiff_t n = e - b, s2 = n/2, ln, rn;
+    TValue *p;
+    int done;
+    if (n <= SORT_INSMAX) {
+      sort_ins(b, e, isstr);
+      return;
+    }
+    if (n > SORT_NINTHER) {
+      sort_3(b, b+s2, e-1, isstr);
+      sort_3(b+1, b+s2-1, e-2, isstr);
+      sort_3(b+2, b+s2+1, e-3, isstr);
+      sort_3(b+s2-1, b+s2, b+s2+1, isstr);
+      sort_swap(b, b+s2);
     } else {
-      lua_pop(L, 1);  /* remove a[l] */
-      lua_rawgeti(L, 1, u);
-      if (sort_comp(L, -1, -2))  /* a[u]<a[i]? */
-	set2(L, i, u);
-      else
-	lua_pop(L, 2);
+      sort_3(b+s2, b, e-1, isstr);
+    }
+    /* Pivot equal to the preceding element: split off all equal ones. */
+    if (!leftmost && !sort_lt(b-1, b, isstr)) {
+      b = sort_partleft(b, e, isstr) + 1;
+      continue;
     }
-    if (u-l == 2) break;  /* only 3 elements */
-    lua_rawgeti(L, 1, i);  /* Pivot */
-    lua_pushvalue(L, -1);
-    lua_rawgeti(L, 1, u-1);
-    set2(L, i, u-1);
-    /* a[l] <= P == a[u-1] <= a[u], only need to sort from l+1 to u-2 */
-    i = l; j = u-1;
-    for (;;) {  /* invariant: a[l..i] <= P <= a[j..u] */
-      /* repeat ++i until a[i] >= P */
-      while (lua_rawgeti(L, 1, ++i), sort_comp(L, -1, -2)) {
-	if (i>=u) lj_err_caller(L, LJ_ERR_TABSORT);
-	lua_pop(L, 1);  /* remove a[i] */
+    p = sort_partright(b, e, &done, isstr);
+    ln = p - b; rn = e - (p+1);
+    if (ln < n/8 || rn < n/8) {  /* Highly unbalanced partition. */
+      if (--bad == 0) {
+	sort_heap(b, e, isstr);
+	return;
       }
-      /* repeat --j until a[j] <= P */
-      while (lua_rawgeti(L, 1, --j), sort_comp(L, -3, -1)) {
-	if (j<=l) lj_err_caller(L, LJ_ERR_TABSORT);
-	lua_pop(L, 1);  /* remove a[j] */
+      if (ln >= SORT_INSMAX) {  /* Break up patterns. */
+	sort_swap(b, b + ln/4);
+	sort_swap(p-1, p - ln/4);
+	if (ln > SORT_NINTHER) {
+	  sort_swap(b+1, b + (ln/4+1));
+	  sort_swap(b+2, b + (ln/4+2));
+	  sort_swap(p-2, p - (ln/4+1));
+	  sort_swap(p-3, p - (ln/4+2));
+	}
       }
-      if (j<i) {
-	lua_pop(L, 3);  /* pop pivot, a[i], a[j] */
-	break;
+      if (rn >= SORT_INSMAX) {
+	sort_swap(p+1, p + (1+rn/4));
+	sort_swap(e-1, e - rn/4);
+	if (rn > SORT_NINTHER) {
+	  sort_swap(p+2, p + (2+rn/4));
+	  sort_swap(p+3, p + (3+rn/4));
+	  sort_swap(e-2, e - (1+rn/4));
+	  sort_swap(e-3, e - (2+rn/4));
+	}
       }
-      set2(L, i, j);
+    } else if (done && sort_partins(b, p, isstr) &&
+	       sort_partins(p+1, e, isstr)) {
+      return;  /* Mostly sorted input. */
     }
-    lua_rawgeti(L, 1, u-1);
-    lua_rawgeti(L, 1, i);
-    set2(L, u-1, i);  /* swap pivot (a[u-1]) with a[i] */
-    /* a[l..i-1] <= a[i] == P <= a[i+1..u] */
-    /* adjust so that smaller half is in [j..i] and larger one in [l..u] */
-    if (i-l < u-i) {
-      j=l; i=i-1; l=i+2;
+    /* Recurse into the smaller part and loop on the larger one. */
+    if (ln < rn) {
+      sort_pdq(b, p, bad, leftmost, isstr);
+      b = p+1; leftmost = 0;
     } else {
-      j=i+1; i=u; u=j-2;
+      sort_pdq(p+1, e, bad, 0, isstr);
+      e = p;
     }
-    auxsort(L, j, i);  /* call recursively the smaller one */
-  }  /* repeat the routine for the larger one */
+  }
+}
+
+/* Sort arrays of only numbers or only strings. Returns 0 for others. */
+static int sort_fast(GCtab *t, int32_t n)
+{
+  TValue *array = tvref(t->array);
+  int32_t i;
+  int isstr;
+  lua_assert(n > 1);
+  if ((uint32_t)n >= t->asize)
+    return 0;  /* Not all elements are in the array part. */
+  isstr = tvisstr(&array[1]);
+  for (i = 1; i <= n; i++) {
+    cTValue *o = &array[i];
+    if (isstr ? !tvisstr(o) : !(tvisint(o) || (tvisnum(o) && !tvisnan(o))))
+      return 0;
+  }
+  /* NOBARRIER: Only the order of the elements changes. */
+  sort_pdq(array+1, array+n+1, (int)lj_fls((uint32_t)n), 1, isstr);
+  return 1;
 }
 
+LJLIB_NOREGUV LJLIB_LUA(table_sort_lt) /*
+  function(a, b)
+    return a < b
+  end
+*/
+
+LJLIB_NOREGUV LJLIB_LUA(table_sort_aux) /*
+  function(t, lt, n)
+    CHECK_tab(t)
+    local stk, sp = {}, 0
+    local b, e, leftmost, bad = 1, n + 1, true, 0
+    while n > 1 do
+      n = (n - n % 2) / 2
+      bad = bad + 1
+    end
+    repeat
+      n = e - b
+      if n <= 24 then
+	for i = b + 1, e - 1 do
+	  local x, j = t[i], i
+	  while j > b and lt(x, t[j - 1]) do
+	    t[j] = t[j - 1]
+	    j = j - 1
+	  end
+	  if j ~= i then
+	    t[j] = x
+	    if j == b and lt(t[b + 1], x) then return false end
+	  end
+	end
+	e = b
+      else
+	local m = b + (n - n % 2) / 2
+	if lt(t[b], t[m]) then t[m], t[b] = t[b], t[m] end
+	if lt(t[e - 1], t[b]) then
+	  t[b], t[e - 1] = t[e - 1], t[b]
+	  if lt(t[b], t[m]) then t[m], t[b] = t[b], t[m] end
+	end
+	local pv, f, l = t[b], b, e
+	if not leftmost and not lt(t[b - 1], pv) then
+	  repeat
+	    l = l - 1
+	    if l < b then return false end
+	  until not lt(pv, t[l])
+	  if l + 1 == e then
+	    while f < l do
+	      f = f + 1
+	      if lt(pv, t[f]) then break end
+	    end
+	  else
+	    repeat
+	      f = f + 1
+	      if f == e then return false end
+	    until lt(pv, t[f])
+	  end
+	  while f < l do
+	    t[f], t[l] = t[l], t[f]
+	    repeat
+	      l = l - 1
+	      if l < b then return false end
+	    until not lt(pv, t[l])
+	    repeat
+	      f = f + 1
+	      if f == e then return false end
+	    until lt(pv, t[f])
+	  end
+	  t[b] = t[l]
+	  t[l] = pv
+	  b = l + 1
+	else
+	  repeat
+	    f = f + 1
+	    if f == e then return false end
+	  until not lt(t[f], pv)
+	  if f == b + 1 then
+	    while f < l do
+	      l = l - 1
+	      if lt(t[l], pv) then break end
+	    end
+	  else
+	    repeat
+	      l = l - 1
+	      if l == b then return false end
+	    until lt(t[l], pv)
+	  end
+	  local done = f >= l
+	  while f < l do
+	    t[f], t[l] = t[l], t[f]
+	    repeat
+	      f = f + 1
+	      if f == e then return false end
+	    until not lt(t[f], pv)
+	    repeat
+	      l = l - 1
+	      if l == b then return false end
+	    until lt(t[l], pv)
+	  end
+	  local p = f - 1
+	  t[b] = t[p]
+	  t[p] = pv
+	  local ln, rn, n8 = p - b, e - p - 1, (n - n % 8) / 8
+	  if ln < n8 or rn < n8 then
+	    bad = bad - 1
+	    if bad == 0 then
+	      local k = (n - n % 2) / 2
+	      while n > 1 do
+		local i
+		if k > 0 then
+		  k = k - 1
+		  i = k
+		else
+		  n = n - 1
+		  t[b], t[b + n] = t[b + n], t[b]
+		  i = 0
+		end
+		local x = t[b + i]
+		while true do
+		  local c = 2 * i + 1
+		  if c >= n then break end
+		  if c + 1 < n and lt(t[b + c], t[b + c + 1]) then c = c + 1 end
+		  if not lt(x, t[b + c]) then break end
+		  t[b + i] = t[b + c]
+		  i = c
+		end
+		t[b + i] = x
+	      end
+	      e = b
+	    else
+	      if ln >= 24 then
+		local q = (ln - ln % 4) / 4
+		t[b], t[b + q] = t[b + q], t[b]
+		t[p - 1], t[p - q] = t[p - q], t[p - 1]
+	      end
+	      if rn >= 24 then
+		local q = (rn - rn % 4) / 4
+		t[p + 1], t[p + 1 + q] = t[p + 1 + q], t[p + 1]
+		t[e - 1], t[e - q] = t[e - q], t[e - 1]
+	      end
+	    end
+	  elseif done then
+	    local lo, hi, moves = b, p, 0
+	    while moves <= 8 do
+	      for i = lo + 1, hi - 1 do
+		local x = t[i]
+		if lt(x, t[i - 1]) then
+		  local j = i
+		  repeat
+		    t[j] = t[j - 1]
+		    j = j - 1
+		  until j == lo or not lt(x, t[j - 1])
+		  t[j] = x
+		  if j == lo and lt(t[lo + 1], x) then return false end
+		  moves = moves + i - j
+		  if moves > 8 then break end
+		end
+	      end
+	      if moves <= 8 then
+		if hi == e then
+		  e = b
+		  break
+		end
+		lo, hi, moves = p + 1, e, 0
+	      end
+	    end
+	  end
+	  if e > b then
+	    if ln < rn then
+	      stk[sp + 1], stk[sp + 2], stk[sp + 3], stk[sp + 4] = p + 1, e, bad, false
+	      e = p
+	    else
+	      stk[sp + 1], stk[sp + 2], stk[sp + 3], stk[sp + 4] = b, p, bad, leftmost
+	      b, leftmost = p + 1, false
+	    end
+	    sp = sp + 4
+	  end
+	end
+      end
+      if e <= b and sp > 0 then
+	b, e, bad, leftmost = stk[sp - 3], stk[sp - 2], stk[sp - 1], stk[sp]
+	sp = sp - 4
+      end
+    until e <= b
+    return true
+  end
+*/
+
 LJLIB_CF(table_sort)
 {
   GCtab *t = lj_lib_checktab(L, 1);
@@ -263,7 +598,18 @@ LJLIB_CF(table_sort)
   lua_settop(L, 2);
   if (!tvisnil(L->base+1))
     lj_lib_checkfunc(L, 2);
-  auxsort(L, 1, n);
+  if (n < 2)
+    return 0;  /* Nothing to sort. */
+  if (tvisnil(L->base+1) && sort_fast(t, n))
+    return 0;
+  /* Call table_sort_aux(t, f or table_sort_lt, n). */
+  copyTV(L, L->top++, lj_lib_upvalue(L, 2));
+  copyTV(L, L->top++, L->base);
+  copyTV(L, L->top++, tvisnil(L->base+1) ? lj_lib_upvalue(L, 1) : L->base+1);
+  setintV(L->top++, n);
+  lua_call(L, 3, 1);
+  if (!tvistruecond(L->top-1))
+    lj_err_caller(L, LJ_ERR_TABSORT);
   return 0;
 }
 
@@ -299,6 +645,15 @@ LJLIB_NOREG LJLIB_CF(table_clear)	LJLIB_REC(.)
   return 0;
 }
 
+LJLIB_NOREG LJLIB_CF(table_clone)	LJLIB_REC(.)
+{
+  GCtab *t = lj_tab_dup(L, lj_lib_checktab(L, 1));
+  settabV(L, L->base, t);
+  L->top = L->base+1;
+  lj_gc_check(L);
+  return 1;
+}
+
 static int luaopen_table_new(lua_State *L)
 {
   return lj_lib_postreg(L, lj_cf_table_new, FF_table_new, "new");
@@ -309,6 +664,11 @@ static int luaopen_table_clear(lua_State *L)
   return lj_lib_postreg(L, lj_cf_table_clear, FF_table_clear, "clear");
 }
 
+static int luaopen_table_clone(lua_State *L)
+{
+  return lj_lib_postreg(L, lj_cf_table_clone, FF_table_clone, "clone");
+}
+
 /* ------------------------------------------------------------------------ */
 
 #include "lj_libdef.h"
@@ -322,6 +682,7 @@ LUALIB_API int luaopen_table(lua_State *L)
 #endif
   lj_lib_prereg(L, LUA_TABLIBNAME ".new", luaopen_table_new, tabV(L->top-1));
   lj_lib_prereg(L, LUA_TABLIBNAME ".clear", luaopen_table_clear, tabV(L->top-1));
+  lj_lib_prereg(L, LUA_TABLIBNAME ".clone", luaopen_table_clone, tabV(L->top-1));
   return 1;
 }
 
@@ -1025,6 +1025,9 @@ static uint32_t ir_khash(IRIns *ir)
 
 static void asm_gencall(ASMState *as, const CCallInfo *ci, IRRef *args);
 static void asm_setupresult(ASMState *as, IRIns *ir, const CCallInfo *ci);
+#if LJ_HASFFI && LJ_TARGET_X86ORX64
+static int asm_memop(ASMState *as, IRIns *ir, IRRef *args);
+#endif
 
 static void asm_snew(ASMState *as, IRIns *ir)
 {
@@ -1300,6 +1303,11 @@ static void asm_call(ASMState *as, IRIns *ir)
   IRRef args[CCI_NARGS_MAX];
   const CCallInfo *ci = &lj_ir_callinfo[ir->op2];
   asm_collectargs(as, ir, ci, args);
+#if LJ_HASFFI && LJ_TARGET_X86ORX64
+  if ((ir->op2 == IRCALL_memcpy || ir->op2 == IRCALL_memset) &&
+      asm_memop(as, ir, args))
+    return;
+#endif
   asm_setupresult(as, ir, ci);
   asm_gencall(as, ci, args);
 }
@@ -750,6 +750,57 @@ static void asm_callx(ASMState *as, IRIns *ir)
   asm_gencall(as, &ci, args);
 }
 
+#if LJ_HASFFI
+/* Max. constant length of memcpy/memset calls that are inlined. */
+#define ASM_MEMOP_MAXLEN	160
+
+/* Inline memcpy/memset with a constant length as unaligned 16 byte moves. */
+static int asm_memop(ASMState *as, IRIns *ir, IRRef *args)
+{
+  IRIns *irl = IR(args[2]);
+  int32_t len, ofs;
+  Reg dest, tmp;
+  if (ra_used(ir) || !irref_isk(args[2]) || irl->o != IR_KINT)
+    return 0;
+  len = irl->i;
+  if (len < 16 || len > ASM_MEMOP_MAXLEN)
+    return 0;
+  dest = ra_alloc1(as, args[0], RSET_GPR);
+  tmp = ra_scratch(as, RSET_FPR);
+  if (ir->op2 == IRCALL_memcpy) {
+    Reg src = ra_alloc1(as, args[1], rset_exclude(RSET_GPR, dest));
+    if ((len & 15)) {  /* Overlapping move for the tail. */
+      emit_rmro(as, XO_MOVUPSto, tmp, dest, len-16);
+      emit_rmro(as, XO_MOVUPS, tmp, src, len-16);
+    }
+    for (ofs = (len & ~15) - 16; ofs >= 0; ofs -= 16) {
+      checkmclim(as);
+      emit_rmro(as, XO_MOVUPSto, tmp, dest, ofs);
+      emit_rmro(as, XO_MOVUPS, tmp, src, ofs);
+    }
+  } else {
+    IRIns *irf = IR(args[1]);
+    if ((len & 15))
+      emit_rmro(as, XO_MOVUPSto, tmp, dest, len-16);
+    for (ofs = (len & ~15) - 16; ofs >= 0; ofs -= 16) {
+      checkmclim(as);
+      emit_rmro(as, XO_MOVUPSto, tmp, dest, ofs);
+    }
+    if (irref_isk(args[1]) && (uint8_t)irf->i == 0) {
+      emit_rr(as, XO_XORPS, tmp, tmp);
+    } else {  /* Broadcast the fill byte to all 16 bytes. */
+      Reg r = ra_alloc1(as, args[1], rset_exclude(RSET_GPR, dest));
+      emit_rr(as, XO_PUNPCKLQDQ, tmp, tmp);
+      emit_i8(as, 0);
+      emit_rr(as, XO_PSHUFLW, tmp, tmp);
+      emit_rr(as, XO_PUNPCKLBW, tmp, tmp);
+      emit_rr(as, XO_MOVD, tmp, r);
+    }
+  }
+  return 1;
+}
+#endif
+
 /* -- Returns ------------------------------------------------------------- */
 
 /* Return to lower frame. Guard that it goes to the right spot. */
@@ -253,11 +253,15 @@ static void bcread_kgc(LexState *ls, GCproto *pt, MSize sizekgc)
 #endif
     } else {
       lua_State *L = ls->L;
+      GCproto *cpt;
       lua_assert(tp == BCDUMP_KGC_CHILD);
       if (L->top <= bcread_oldtop(L, ls))  /* Stack underflow? */
 	bcread_error(ls, LJ_ERR_BCBAD);
       L->top--;
-      setgcref(*kr, obj2gco(protoV(L->top)));
+      cpt = protoV(L->top);
+      if (proto_islazy(cpt))  /* Remember the slot for lj_bcread_lazy(). */
+	cpt->sizekn = sizekgc - i;
+      setgcref(*kr, obj2gco(cpt));
     }
   }
 }
@@ -393,6 +397,154 @@ GCproto *lj_bcread_proto(LexState *ls)
   return pt;
 }
 
+/* -- Lazy prototypes ----------------------------------------------------- */
+
+/*
+** A prototype loaded in lazy mode is a stub GCproto with sizebc == 0.
+** Its kgc part holds only the (possibly lazy) child prototypes in the
+** same order as the real prototype has them, k points to the raw copy
+** of the prototype record from the dump and numparams holds the dump
+** flags. Once the parent is materialized, sizekn holds the distance from
+** the parent's k to the constant slot referencing the stub. The stub is
+** replaced with the real prototype on the first closure creation, so the
+** functions which are never instantiated don't cost more than a memcpy
+** of their bytecode dump.
+*/
+
+/* Skip a single constant key/value of a template table. */
+static void bcread_skip_ktabk(LexState *ls)
+{
+  MSize tp = bcread_uleb128(ls);
+  if (tp >= BCDUMP_KTAB_STR) {
+    ls->p += tp - BCDUMP_KTAB_STR;
+  } else if (tp == BCDUMP_KTAB_INT) {
+    bcread_uleb128(ls);
+  } else if (tp == BCDUMP_KTAB_NUM) {
+    bcread_uleb128(ls);
+    bcread_uleb128(ls);
+  }
+}
+
+/* Create a stub for the prototype record of the given length. */
+static GCproto *bcread_lazy_proto(LexState *ls, MSize len)
+{
+  lua_State *L = ls->L;
+  const char *startp = ls->p;
+  GCproto *pt;
+  GCRef *kr;
+  MSize flags, sizeuv, sizekgc, sizebc, sizept, i, nchild = 0;
+  BCLine firstline = 0, numline = 0;
+
+  /* Read prototype header. */
+  flags = bcread_byte(ls);
+  ls->p += 2;  /* numparams, framesize */
+  sizeuv = bcread_byte(ls);
+  sizekgc = bcread_uleb128(ls);
+  bcread_uleb128(ls);  /* sizekn */
+  sizebc = bcread_uleb128(ls) + 1;
+  if (!(bcread_flags(ls) & BCDUMP_F_STRIP) && bcread_uleb128(ls)) {
+    firstline = bcread_uleb128(ls);
+    numline = bcread_uleb128(ls);
+  }
+
+  /* Count child prototypes. */
+  ls->p += (sizebc-1)*(MSize)sizeof(BCIns) + sizeuv*2;
+  for (i = 0; i < sizekgc && ls->p < startp + len; i++) {
+    MSize tp = bcread_uleb128(ls);
+    if (tp >= BCDUMP_KGC_STR) {
+      ls->p += tp - BCDUMP_KGC_STR;
+    } else if (tp == BCDUMP_KGC_TAB) {
+      MSize narray = bcread_uleb128(ls);
+      MSize nhash = bcread_uleb128(ls);
+      for (; narray; narray--) bcread_skip_ktabk(ls);
+      for (nhash *= 2; nhash; nhash--) bcread_skip_ktabk(ls);
+    } else if (tp == BCDUMP_KGC_CHILD) {
+      nchild++;
+    } else {
+      MSize n = tp == BCDUMP_KGC_COMPLEX ? 4 : 2;
+      for (; n; n--) bcread_uleb128(ls);
+    }
+  }
+  if (i != sizekgc || ls->p > startp + len)
+    bcread_error(ls, LJ_ERR_BCBAD);
+
+  /* Allocate stub and copy the record. */
+  sizept = (MSize)sizeof(GCproto) + nchild*(MSize)sizeof(GCRef) + len;
+  pt = (GCproto *)lj_mem_newgco(L, sizept);
+  pt->gct = ~LJ_TPROTO;
+  pt->numparams = (uint8_t)bcread_flags(ls);
+  pt->framesize = 0;
+  pt->sizebc = 0;
+  setmref(pt->k, (char *)pt + sizept - len);
+  setmref(pt->uv, NULL);
+  pt->sizekgc = 0;  /* Set to zero until fully initialized. */
+  pt->sizekn = 0;
+  pt->sizept = sizept;
+  pt->sizeuv = (uint8_t)sizeuv;
+  pt->flags = (uint8_t)(flags & (PROTO_CHILD|PROTO_VARARG|PROTO_FFI));
+  pt->trace = 0;
+  setgcref(pt->chunkname, obj2gco(ls->chunkname));
+  pt->firstline = firstline;
+  pt->numline = numline;
+  setmref(pt->lineinfo, NULL);
+  setmref(pt->uvinfo, NULL);
+  setmref(pt->varinfo, NULL);
+  memcpy(mref(pt->k, char), startp, len);
+
+  /* Pop children in the same order as bcread_kgc() does. */
+  kr = mref(pt->k, GCRef) - (ptrdiff_t)nchild;
+  for (i = 0; i < nchild; i++, kr++) {
+    if (L->top <= bcread_oldtop(L, ls))  /* Stack underflow? */
+      bcread_error(ls, LJ_ERR_BCBAD);
+    L->top--;
+    setgcref(*kr, obj2gco(protoV(L->top)));
+  }
+  pt->sizekgc = nchild;
+  ls->p = startp + len;
+  return pt;
+}
+
+/* Read the real prototype from the raw record of the stub. */
+static GCproto *bcread_unstub(LexState *ls, GCproto *pt)
+{
+  lua_State *L = ls->L;
+  MSize i, n = pt->sizekgc;
+  ls->p = mref(pt->k, const char);
+  ls->pe = (const char *)pt + pt->sizept;
+  ls->c = -1;  /* Never call the reader. */
+  lj_state_checkstack(L, n);
+  bcread_savetop(L, ls, L->top);
+  /* Push children, so the first one is popped first. */
+  for (i = 0; i < n; i++)
+    setprotoV(L, L->top++, gco2pt(gcref(mref(pt->k, GCRef)[-(ptrdiff_t)i-1])));
+  pt = lj_bcread_proto(ls);
+  if (ls->p != ls->pe || L->top != bcread_oldtop(L, ls))
+    bcread_error(ls, LJ_ERR_BCBAD);
+  return pt;
+}
+
+/* Replace the lazy child prototype of the parent with the real one. */
+GCproto *lj_bcread_lazy(lua_State *L, GCproto *parent, GCproto *pt)
+{
+  LexState ls;
+  GCproto *npt;
+  GCRef *kr = mref(parent->k, GCRef) - (ptrdiff_t)pt->sizekn;
+  lua_assert(proto_islazy(pt) && !proto_islazy(parent));
+  lua_assert(pt->sizekn && gcref(*kr) == obj2gco(pt));
+  memset(&ls, 0, sizeof(ls));
+  ls.L = L;
+  ls.chunkname = proto_chunkname(pt);
+  ls.chunkarg = strdata(ls.chunkname);
+  ls.level = pt->numparams;  /* Dump flags, see bcread_flags(). */
+  lj_buf_init(L, &ls.sb);  /* Never used, since the reader isn't called. */
+  npt = bcread_unstub(&ls, pt);
+  npt->flags |= (pt->flags & PROTO_NOJIT);
+  /* Patch the parent, so the stub is collected. */
+  setgcref(*kr, obj2gco(npt));
+  lj_gc_objbarrier(L, parent, npt);
+  return npt;
+}
+
 /* Read and check header of bytecode dump. */
 static int bcread_header(LexState *ls)
 {
@@ -450,7 +602,7 @@ GCproto *lj_bcread(LexState *ls)
     if (!len) break;  /* EOF */
     bcread_need(ls, len);
     startp = ls->p;
-    pt = lj_bcread_proto(ls);
+    pt = ls->lazy ? bcread_lazy_proto(ls, len) : lj_bcread_proto(ls);
     if (ls->p != startp + len)
       bcread_error(ls, LJ_ERR_BCBAD);
     setprotoV(L, L->top, pt);
@@ -461,6 +613,8 @@ GCproto *lj_bcread(LexState *ls)
     bcread_error(ls, LJ_ERR_BCBAD);
   /* Pop off last prototype. */
   L->top--;
+  if (proto_islazy(protoV(L->top)))  /* Materialize the main chunk. */
+    return bcread_unstub(ls, protoV(L->top));
   return protoV(L->top);
 }
 
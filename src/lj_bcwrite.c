@@ -242,8 +242,12 @@ static void bcwrite_proto(BCWriteCtx *ctx, GCproto *pt)
     GCRef *kr = mref(pt->k, GCRef) - 1;
     for (i = 0; i < n; i++, kr--) {
       GCobj *o = gcref(*kr);
-      if (o->gch.gct == ~LJ_TPROTO)
-	bcwrite_proto(ctx, gco2pt(o));
+      if (o->gch.gct == ~LJ_TPROTO) {
+	GCproto *cpt = gco2pt(o);
+	if (proto_islazy(cpt))  /* Load the prototype on demand. */
+	  cpt = lj_bcread_lazy(sbufL(&ctx->sb), pt, cpt);
+	bcwrite_proto(ctx, cpt);
+      }
     }
   }
 
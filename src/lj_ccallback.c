@@ -14,6 +14,7 @@
 #include "lj_frame.h"
 #include "lj_ctype.h"
 #include "lj_cconv.h"
+#include "lj_cdata.h"
 #include "lj_ccall.h"
 #include "lj_ccallback.h"
 #include "lj_target.h"
@@ -499,18 +500,63 @@ void lj_ccallback_mcode_free(CTState *cts)
 #error "Missing calling convention definitions for this architecture"
 #endif
 
-/* Convert and push callback arguments to Lua stack. */
-static void callback_conv_args(CTState *cts, lua_State *L)
+/* -- C callback argument conversion plans -------------------------------- */
+
+/* Argument conversion kinds. */
+enum {
+  CBARG_I8, CBARG_U8, CBARG_I16, CBARG_U16, CBARG_I32, CBARG_U32,
+  CBARG_FLOAT, CBARG_DOUBLE, CBARG_BOOL, CBARG_PTR, CBARG_ANY
+};
+
+/* Conversion of a single argument. */
+typedef struct CCallbackArg {
+  uint8_t kind;		/* Conversion kind (CBARG_*). */
+  uint8_t onstack;	/* Passed on the C stack or in cts->cb? */
+  uint16_t ofs;		/* Byte offset of the argument. */
+  CTypeID1 id;		/* Raw argument type. */
+} CCallbackArg;
+
+/* Argument conversions for a callback slot, built on the first call. */
+typedef struct CCallbackPlan {
+  CTypeID1 id;		/* Function type the plan has been built for. */
+  uint8_t narg;		/* Number of arguments. */
+  uint8_t nsp;		/* Number of stack slots used by arguments. */
+  CCallbackArg arg[1];	/* Argument conversions. */
+} CCallbackPlan;
+
+#define callback_plansize(narg) \
+  (offsetof(CCallbackPlan, arg) + (narg)*sizeof(CCallbackArg))
+
+/* Get the conversion kind for a raw argument type. */
+static uint8_t callback_argkind(CType *cta)
 {
-  TValue *o = L->top;
+  CTInfo info = cta->info;
+  if (ctype_isnum(info)) {
+    if (ctype_isbool(info))
+      return CBARG_BOOL;
+    if (ctype_isfp(info))
+      return cta->size == sizeof(float) ? CBARG_FLOAT :
+	     cta->size == sizeof(double) ? CBARG_DOUBLE : CBARG_ANY;
+    switch (cta->size) {
+    case 1: return (info & CTF_UNSIGNED) ? CBARG_U8 : CBARG_I8;
+    case 2: return (info & CTF_UNSIGNED) ? CBARG_U16 : CBARG_I16;
+    case 4: return (info & CTF_UNSIGNED) ? CBARG_U32 : CBARG_I32;
+    default: break;
+    }
+  } else if (ctype_isptr(info) && !ctype_isref(info)) {
+    return CBARG_PTR;
+  }
+  return CBARG_ANY;
+}
+
+/* Build the argument conversion plan for a callback function type. */
+static CCallbackPlan *callback_plan_new(CTState *cts, CType *ct, CTypeID id)
+{
+  CCallbackArg arg[LUA_MINSTACK];
+  CCallbackPlan *plan;
   intptr_t *stack = cts->cb.stack;
-  MSize slot = cts->cb.slot;
-  CTypeID id = 0, rid, fid;
-  int gcsteps = 0;
-  CType *ct;
-  GCfunc *fn;
-  int fntp;
-  MSize ngpr = 0, nsp = 0, maxgpr = CCALL_NARG_GPR;
+  CTypeID fid;
+  MSize narg = 0, ngpr = 0, nsp = 0, maxgpr = CCALL_NARG_GPR;
 #if CCALL_NARG_FPR
   MSize nfpr = 0;
 #if LJ_TARGET_ARM
@@ -518,37 +564,6 @@ static void callback_conv_args(CTState *cts, lua_State *L)
 #endif
 #endif
 
-  if (slot < cts->cb.sizeid && (id = cts->cb.cbid[slot]) != 0) {
-    ct = ctype_get(cts, id);
-    rid = ctype_cid(ct->info);  /* Return type. x86: +(spadj<<16). */
-    fn = funcV(lj_tab_getint(cts->miscmap, (int32_t)slot));
-    fntp = LJ_TFUNC;
-  } else {  /* Must set up frame first, before throwing the error. */
-    ct = NULL;
-    rid = 0;
-    fn = (GCfunc *)L;
-    fntp = LJ_TTHREAD;
-  }
-  /* Continuation returns from callback. */
-  if (LJ_FR2) {
-    (o++)->u64 = LJ_CONT_FFI_CALLBACK;
-    (o++)->u64 = rid;
-    o++;
-  } else {
-    o->u32.lo = LJ_CONT_FFI_CALLBACK;
-    o->u32.hi = rid;
-    o++;
-  }
-  setframe_gc(o, obj2gco(fn), fntp);
-  setframe_ftsz(o, ((char *)(o+1) - (char *)L->base) + FRAME_CONT);
-  L->top = L->base = ++o;
-  if (!ct)
-    lj_err_caller(cts->L, LJ_ERR_FFI_BADCBACK);
-  if (isluafunc(fn))
-    setcframe_pc(L->cframe, proto_bc(funcproto(fn))+1);
-  lj_state_checkstack(L, LUA_MINSTACK);  /* May throw. */
-  o = L->base;  /* Might have been reallocated. */
-
 #if LJ_TARGET_X86
   /* x86 has several different calling conventions. */
   switch (ctype_cconv(ct->info)) {
@@ -565,7 +580,7 @@ static void callback_conv_args(CTState *cts, lua_State *L)
       CType *cta;
       void *sp;
       CTSize sz;
-      int isfp;
+      int isfp, onstack = 0;
       MSize n;
       lua_assert(ctype_isfield(ctf->info));
       cta = ctype_rawchild(cts, ctf);
@@ -580,6 +595,7 @@ static void callback_conv_args(CTState *cts, lua_State *L)
 	nsp = (nsp + 1) & ~1u;  /* Align 64 bit argument on stack. */
       sp = &stack[nsp];
       nsp += n;
+      onstack = 1;
 
     done:
       if (LJ_BE && cta->size < CTSIZE_PTR
@@ -588,18 +604,155 @@ static void callback_conv_args(CTState *cts, lua_State *L)
 #endif
 	 )
 	sp = (void *)((uint8_t *)sp + CTSIZE_PTR-cta->size);
-      gcsteps += lj_cconv_tv_ct(cts, cta, 0, o++, sp);
+      lua_assert(narg < LUA_MINSTACK);
+      arg[narg].kind = callback_argkind(cta);
+      arg[narg].onstack = (uint8_t)onstack;
+      arg[narg].ofs = (uint16_t)((uint8_t *)sp -
+			(onstack ? (uint8_t *)stack : (uint8_t *)&cts->cb));
+      arg[narg].id = (CTypeID1)ctype_typeid(cts, cta);
+      narg++;
     }
     fid = ctf->sib;
   }
+  plan = (CCallbackPlan *)lj_mem_new(cts->L, callback_plansize(narg));
+  plan->id = (CTypeID1)id;
+  plan->narg = (uint8_t)narg;
+  plan->nsp = (uint8_t)nsp;
+  memcpy(plan->arg, arg, narg*sizeof(CCallbackArg));
+  return plan;
+}
+
+/* Get the argument conversion plan for the current callback slot. */
+static CCallbackPlan *callback_plan(CTState *cts, CType *ct, CTypeID id)
+{
+  CCallbackPlan **pp;
+  if (LJ_UNLIKELY(cts->cb.slot >= cts->cb.sizeplan)) {
+    MSize sz = cts->cb.sizeid;
+    cts->cb.plan = (CCallbackPlan **)lj_mem_realloc(cts->L, cts->cb.plan,
+		     cts->cb.sizeplan*sizeof(CCallbackPlan *),
+		     sz*sizeof(CCallbackPlan *));
+    memset(cts->cb.plan + cts->cb.sizeplan, 0,
+	   (sz - cts->cb.sizeplan)*sizeof(CCallbackPlan *));
+    cts->cb.sizeplan = sz;
+  }
+  pp = &cts->cb.plan[cts->cb.slot];
+  if (LJ_UNLIKELY(!*pp || (*pp)->id != id)) {  /* New or reused slot. */
+    CCallbackPlan *plan = callback_plan_new(cts, ct, id);
+    if (*pp)
+      lj_mem_free(cts->g, *pp, callback_plansize((*pp)->narg));
+    *pp = plan;
+  }
+  return *pp;
+}
+
+/* Free all argument conversion plans. */
+void lj_ccallback_plan_free(CTState *cts)
+{
+  MSize i;
+  for (i = 0; i < cts->cb.sizeplan; i++) {
+    CCallbackPlan *plan = cts->cb.plan[i];
+    if (plan)
+      lj_mem_free(cts->g, plan, callback_plansize(plan->narg));
+  }
+  lj_mem_freevec(cts->g, cts->cb.plan, cts->cb.sizeplan, CCallbackPlan *);
+  cts->cb.plan = NULL;
+  cts->cb.sizeplan = 0;
+}
+
+/* Convert and push callback arguments to Lua stack. */
+static void callback_conv_args(CTState *cts, lua_State *L)
+{
+  TValue *o = L->top;
+  MSize slot = cts->cb.slot;
+  CTypeID id = 0, rid;
+  int gcsteps = 0;
+  CType *ct;
+  GCfunc *fn;
+  int fntp;
+  CCallbackPlan *plan;
+  MSize i;
+
+  if (slot < cts->cb.sizeid && (id = cts->cb.cbid[slot]) != 0) {
+    ct = ctype_get(cts, id);
+    rid = ctype_cid(ct->info);  /* Return type. x86: +(spadj<<16). */
+    fn = funcV(lj_tab_getint(cts->miscmap, (int32_t)slot));
+    fntp = LJ_TFUNC;
+  } else {  /* Must set up frame first, before throwing the error. */
+    ct = NULL;
+    rid = 0;
+    fn = (GCfunc *)L;
+    fntp = LJ_TTHREAD;
+  }
+  /* Continuation returns from callback. */
+  if (LJ_FR2) {
+    (o++)->u64 = LJ_CONT_FFI_CALLBACK;
+    (o++)->u64 = rid;
+    o++;
+  } else {
+    o->u32.lo = LJ_CONT_FFI_CALLBACK;
+    o->u32.hi = rid;
+    o++;
+  }
+  setframe_gc(o, obj2gco(fn), fntp);
+  setframe_ftsz(o, ((char *)(o+1) - (char *)L->base) + FRAME_CONT);
+  L->top = L->base = ++o;
+  if (!ct)
+    lj_err_caller(cts->L, LJ_ERR_FFI_BADCBACK);
+  if (isluafunc(fn))
+    setcframe_pc(L->cframe, proto_bc(funcproto(fn))+1);
+  lj_state_checkstack(L, LUA_MINSTACK);  /* May throw. */
+  o = L->base;  /* Might have been reallocated. */
+
+  plan = callback_plan(cts, ct, id);
+  for (i = 0; i < plan->narg; i++) {
+    CCallbackArg *a = &plan->arg[i];
+    uint8_t *sp = (a->onstack ? (uint8_t *)cts->cb.stack :
+				(uint8_t *)&cts->cb) + a->ofs;
+    switch (a->kind) {
+    case CBARG_I8: setintV(o, *(int8_t *)sp); break;
+    case CBARG_U8: setintV(o, *(uint8_t *)sp); break;
+    case CBARG_I16: setintV(o, *(int16_t *)sp); break;
+    case CBARG_U16: setintV(o, *(uint16_t *)sp); break;
+    case CBARG_I32: setintV(o, *(int32_t *)sp); break;
+    case CBARG_U32: {
+      uint32_t u = *(uint32_t *)sp;
+      if (LJ_DUALNUM && (int32_t)u >= 0)
+	setintV(o, (int32_t)u);
+      else
+	setnumV(o, (lua_Number)u);
+      break;
+      }
+    case CBARG_FLOAT: o->n = (lua_Number)*(float *)sp; break;
+    /* Numbers are NOT canonicalized here! Beware of uninitialized data. */
+    case CBARG_DOUBLE: o->n = *(double *)sp; break;
+    case CBARG_BOOL: {
+      uint32_t b = ctype_get(cts, a->id)->size == 1 ? (*sp != 0) :
+						      (*(int *)sp != 0);
+      setboolV(o, b);
+      setboolV(&cts->g->tmptv2, b);  /* Remember for trace recorder. */
+      break;
+      }
+    case CBARG_PTR: {
+      GCcdata *cd = lj_cdata_new(cts, a->id, CTSIZE_PTR);
+      *(void **)cdataptr(cd) = *(void **)sp;
+      setcdataV(L, o, cd);
+      gcsteps++;
+      break;
+      }
+    default:
+      gcsteps += lj_cconv_tv_ct(cts, ctype_get(cts, a->id), 0, o, sp);
+      break;
+    }
+    o++;
+  }
   L->top = o;
 #if LJ_TARGET_X86
   /* Store stack adjustment for returns from non-cdecl callbacks. */
   if (ctype_cconv(ct->info) != CTCC_CDECL) {
 #if LJ_FR2
-    (L->base-3)->u64 |= (nsp << (16+2));
+    (L->base-3)->u64 |= (plan->nsp << (16+2));
 #else
-    (L->base-2)->u32.hi |= (nsp << (16+2));
+    (L->base-2)->u32.hi |= (plan->nsp << (16+2));
 #endif
   }
 #endif
@@ -628,7 +781,14 @@ static void callback_conv_result(CTState *cts, lua_State *L, TValue *o)
     if (ctype_isfp(ctr->info) && ctr->size == sizeof(float))
       dp = (uint8_t *)&cts->cb.fpr[0].f[1];
 #endif
-    lj_cconv_ct_tv(cts, ctr, dp, o, 0);
+    if (tvisnumber(o) && ctype_isinteger(ctr->info) && ctr->size == 4 &&
+	!(ctr->info & CTF_UNSIGNED))  /* Fast path for int results. */
+      *(int32_t *)dp = tvisint(o) ? intV(o) : (int32_t)numV(o);
+    else if (tvisnumber(o) && ctype_isfp(ctr->info) &&
+	     ctr->size == sizeof(double))  /* Fast path for double results. */
+      *(double *)dp = numberVnum(o);
+    else
+      lj_cconv_ct_tv(cts, ctr, dp, o, 0);
 #ifdef CALLBACK_HANDLE_RET
     CALLBACK_HANDLE_RET
 #endif
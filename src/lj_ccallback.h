@@ -19,6 +19,7 @@ LJ_FUNCA lua_State * LJ_FASTCALL lj_ccallback_enter(CTState *cts, void *cf);
 LJ_FUNCA void LJ_FASTCALL lj_ccallback_leave(CTState *cts, TValue *o);
 LJ_FUNC void *lj_ccallback_new(CTState *cts, CType *ct, GCfunc *fn);
 LJ_FUNC void lj_ccallback_mcode_free(CTState *cts);
+LJ_FUNC void lj_ccallback_plan_free(CTState *cts);
 
 #endif
 
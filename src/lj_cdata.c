@@ -14,6 +14,57 @@
 #include "lj_cconv.h"
 #include "lj_cdata.h"
 
+/* -- C data pool --------------------------------------------------------- */
+
+/*
+** Swept fixed-size cdata objects up to LJ_MAX_CDPOOLSZ bytes are kept in
+** per-size free lists and reused by the next allocation of the same size.
+** This saves the allocator round-trip for boxed 64 bit integers, pointers
+** and small structs, which are created and collected at high rates.
+** The pooled memory is still accounted in the GC total. Objects taken
+** from or put into a pool are accounted as allocated or freed, too, so
+** gc.allocated and gc.freed match the allocations seen by Lua code.
+** Only the memory profiler, which hooks the allocator, sees a pooled
+** object as allocated until the pool releases it.
+*/
+
+/* Allocate memory for a fixed-size C data object. */
+GCcdata * LJ_FASTCALL lj_cdata_alloc(lua_State *L, CTSize sz)
+{
+  global_State *g = G(L);
+  if (sz <= LJ_MAX_CDPOOLSZ) {
+    GCobj *o = gcref(g->cdpool[sz]);
+    if (o != NULL) {
+      setgcrefr(g->cdpool[sz], o->gch.nextgc);
+      g->cdpoolnum[sz]--;
+      g->cdpool_hit++;
+      g->gc.allocated += sizeof(GCcdata) + sz;
+      setgcrefr(o->gch.nextgc, g->gc.root);
+      setgcref(g->gc.root, o);
+      newwhite(g, o);
+      return (GCcdata *)o;
+    }
+    g->cdpool_miss++;
+  }
+  return (GCcdata *)lj_mem_newgco(L, sizeof(GCcdata) + sz);
+}
+
+/* Free all pooled C data objects. */
+void lj_cdata_freepool(global_State *g)
+{
+  CTSize sz;
+  for (sz = 0; sz <= LJ_MAX_CDPOOLSZ; sz++) {
+    GCobj *o;
+    while ((o = gcref(g->cdpool[sz])) != NULL) {
+      setgcrefr(g->cdpool[sz], o->gch.nextgc);
+      /* Already accounted as freed when put into the pool. */
+      g->gc.total -= (GCSize)(sizeof(GCcdata) + sz);
+      g->allocf(g->allocd, o, sizeof(GCcdata) + sz, 0);
+    }
+    g->cdpoolnum[sz] = 0;
+  }
+}
+
 /* -- C data allocation --------------------------------------------------- */
 
 /* Allocate a new C data object holding a reference to another object. */
@@ -79,7 +130,14 @@ void LJ_FASTCALL lj_cdata_free(global_State *g, GCcdata *cd)
     CTSize sz = ctype_hassize(ct->info) ? ct->size : CTSIZE_PTR;
     lua_assert(ctype_hassize(ct->info) || ctype_isfunc(ct->info) ||
 	       ctype_isextern(ct->info));
-    lj_mem_free(g, cd, sizeof(GCcdata) + sz);
+    if (sz <= LJ_MAX_CDPOOLSZ && g->cdpoolnum[sz] < LJ_MAX_CDPOOL) {
+      setgcrefr(cd->nextgc, g->cdpool[sz]);
+      setgcref(g->cdpool[sz], obj2gco(cd));
+      g->cdpoolnum[sz]++;
+      g->gc.freed += sizeof(GCcdata) + sz;
+    } else {
+      lj_mem_free(g, cd, sizeof(GCcdata) + sz);
+    }
     g->gc.cdatanum--;
   } else {
     lj_mem_free(g, memcdatav(cd), sizecdatav(cd));
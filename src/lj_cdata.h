@@ -34,6 +34,9 @@ static LJ_AINLINE void cdata_setptr(void *p, CTSize sz, const void *v)
   }
 }
 
+LJ_FUNC GCcdata * LJ_FASTCALL lj_cdata_alloc(lua_State *L, CTSize sz);
+LJ_FUNC void lj_cdata_freepool(global_State *g);
+
 /* Allocate fixed-size C data object. */
 static LJ_AINLINE GCcdata *lj_cdata_new(CTState *cts, CTypeID id, CTSize sz)
 {
@@ -42,7 +45,7 @@ static LJ_AINLINE GCcdata *lj_cdata_new(CTState *cts, CTypeID id, CTSize sz)
   CType *ct = ctype_raw(cts, id);
   lua_assert((ctype_hassize(ct->info) ? ct->size : CTSIZE_PTR) == sz);
 #endif
-  cd = (GCcdata *)lj_mem_newgco(cts->L, sizeof(GCcdata) + sz);
+  cd = lj_cdata_alloc(cts->L, sz);
   cd->gct = ~LJ_TCDATA;
   cd->ctypeid = ctype_check(cts, id);
   G(cts->L)->gc.cdatanum++;
@@ -52,7 +55,7 @@ static LJ_AINLINE GCcdata *lj_cdata_new(CTState *cts, CTypeID id, CTSize sz)
 /* Variant which works without a valid CTState. */
 static LJ_AINLINE GCcdata *lj_cdata_new_(lua_State *L, CTypeID id, CTSize sz)
 {
-  GCcdata *cd = (GCcdata *)lj_mem_newgco(L, sizeof(GCcdata) + sz);
+  GCcdata *cd = lj_cdata_alloc(L, sz);
   cd->gct = ~LJ_TCDATA;
   cd->ctypeid = id;
   G(L)->gc.cdatanum++;
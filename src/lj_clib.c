@@ -3,6 +3,14 @@
 ** Copyright (C) 2005-2017 Mike Pall. See Copyright Notice in luajit.h
 */
 
+/*
+** clib_preload() needs dlinfo() and dl_iterate_phdr(), which are GNU
+** extensions. Must be defined before any system includes.
+*/
+#if defined(__linux__) && !defined(_GNU_SOURCE) && !defined(LUAJIT_DISABLE_FFI)
+#define _GNU_SOURCE
+#endif
+
 #include "lj_obj.h"
 
 #if LJ_HASFFI
@@ -142,6 +150,127 @@ static void *clib_getsym(CLibrary *cl, const char *name)
   return p;
 }
 
+#if LJ_TARGET_LINUX && (defined(__GLIBC__) || defined(RTLD_DI_LINKMAP))
+
+#include <elf.h>
+#include <link.h>
+
+#if defined(__GLIBC__) && !(LJ_TARGET_MIPS || defined(__riscv))
+
+/* Find the PT_DYNAMIC segment of a library. Returns 1 if it's writable. */
+static int clib_dynphdr(struct dl_phdr_info *info, size_t size, void *ld)
+{
+  ElfW(Half) i;
+  UNUSED(size);
+  for (i = 0; i < info->dlpi_phnum; i++) {
+    const ElfW(Phdr) *ph = &info->dlpi_phdr[i];
+    if (ph->p_type == PT_DYNAMIC &&
+	(uintptr_t)info->dlpi_addr + ph->p_vaddr == (uintptr_t)ld)
+      return (ph->p_flags & PF_W) ? 1 : 2;
+  }
+  return 0;
+}
+
+/*
+** Check whether the pointers in the dynamic section are relocated. glibc
+** does this at load time, unless the section is read-only. Returns -1 if
+** the library isn't found.
+*/
+static int clib_dynreloc(struct link_map *lm)
+{
+  int res = dl_iterate_phdr(clib_dynphdr, (void *)lm->l_ld);
+  return res == 0 ? -1 : res == 1;
+}
+
+#else
+/* Other C libraries and glibc on MIPS and RISC-V never relocate them. */
+#define clib_dynreloc(lm)	0
+#endif
+
+/* Get number of symbols from a GNU hash table. */
+static uint32_t clib_gnuhash_size(const uint32_t *gh)
+{
+  uint32_t nbuckets = gh[0], symoffset = gh[1], n = 0, i;
+  const uint32_t *bucket = gh + 4 + gh[2]*(sizeof(ElfW(Addr))/4);
+  const uint32_t *chain = bucket + nbuckets;
+  for (i = 0; i < nbuckets; i++)
+    if (bucket[i] > n) n = bucket[i];
+  if (n < symoffset)
+    return symoffset;
+  while (!(chain[n - symoffset] & 1))  /* Last chain ends with bit 0 set. */
+    n++;
+  return n+1;
+}
+
+/*
+** Import the addresses of all functions and variables defined by a library
+** into its namespace cache with a single pass over the dynamic symbol table.
+** The addresses are stored as plain numbers in a separate table, which is
+** only referenced by the CLibrary and marked by the GC. A symbol is turned
+** into a properly typed cdata on the first access, once the declaration is
+** known. Hidden versions of a symbol are skipped, so this gives the same
+** result as dlsym(). Everything else (e.g. symbols of the dependencies) is
+** still resolved with dlsym().
+*/
+static void clib_preload(lua_State *L, CLibrary *cl)
+{
+  struct link_map *lm;
+  const ElfW(Dyn) *dyn;
+  const ElfW(Sym) *sym = NULL;
+  const ElfW(Half) *versym = NULL;
+  const uint32_t *hash = NULL, *gnuhash = NULL;
+  const char *strtab = NULL;
+  GCtab *t;
+  uintptr_t base;
+  uint32_t i, n;
+  int reloc;
+  if (dlinfo(cl->handle, RTLD_DI_LINKMAP, &lm) != 0 || !lm->l_ld ||
+      (reloc = clib_dynreloc(lm)) < 0)
+    return;
+  base = reloc ? 0 : (uintptr_t)lm->l_addr;
+  for (dyn = lm->l_ld; dyn->d_tag != DT_NULL; dyn++) {
+    uintptr_t p = base + (uintptr_t)dyn->d_un.d_ptr;
+    switch (dyn->d_tag) {
+    case DT_SYMTAB: sym = (const ElfW(Sym) *)p; break;
+    case DT_STRTAB: strtab = (const char *)p; break;
+    case DT_HASH: hash = (const uint32_t *)p; break;
+    case DT_GNU_HASH: gnuhash = (const uint32_t *)p; break;
+    case DT_VERSYM: versym = (const ElfW(Half) *)p; break;
+    default: break;
+    }
+  }
+  if (!sym || !strtab || !(hash || gnuhash))
+    return;
+  n = hash ? hash[1] : clib_gnuhash_size(gnuhash);
+  t = lj_tab_new(L, 0, hsize2hbits(n));
+  cl->preload = t;
+  lj_gc_objbarrier(L, udataV(L->top-1), t);
+  for (i = 0; i < n; i++) {
+    const ElfW(Sym) *s = &sym[i];
+    uint32_t type = ELF32_ST_TYPE(s->st_info);
+    uint32_t vis = ELF32_ST_VISIBILITY(s->st_other);
+    if (s->st_shndx != SHN_UNDEF && s->st_name &&
+	(type == STT_FUNC || type == STT_OBJECT) &&
+	ELF32_ST_BIND(s->st_info) != STB_LOCAL &&
+	(vis == STV_DEFAULT || vis == STV_PROTECTED) &&
+	!(versym && (versym[i] == 0 || (versym[i] & 0x8000)))) {
+      GCstr *name = lj_str_newz(L, strtab + s->st_name);
+      TValue *tv = lj_tab_setstr(L, t, name);
+      if (tvisnil(tv))  /* Addresses are exact in a double (< 2^53). */
+	setnumV(tv, (lua_Number)((uintptr_t)lm->l_addr + s->st_value));
+    }
+  }
+}
+
+#else
+
+static void clib_preload(lua_State *L, CLibrary *cl)
+{
+  UNUSED(L); UNUSED(cl);
+}
+
+#endif
+
 #elif LJ_TARGET_WINDOWS
 
 #define WIN32_LEAN_AND_MEAN
@@ -265,6 +394,11 @@ static void *clib_getsym(CLibrary *cl, const char *name)
   return p;
 }
 
+static void clib_preload(lua_State *L, CLibrary *cl)
+{
+  UNUSED(L); UNUSED(cl);
+}
+
 #else
 
 #define CLIB_DEFHANDLE	NULL
@@ -293,6 +427,11 @@ static void *clib_getsym(CLibrary *cl, const char *name)
   return NULL;
 }
 
+static void clib_preload(lua_State *L, CLibrary *cl)
+{
+  UNUSED(L); UNUSED(cl);
+}
+
 #endif
 
 /* -- C library indexing -------------------------------------------------- */
@@ -347,7 +486,11 @@ TValue *lj_clib_index(lua_State *L, CLibrary *cl, GCstr *name)
 #if LJ_TARGET_WINDOWS
       DWORD oldwerr = GetLastError();
 #endif
-      void *p = clib_getsym(cl, sym);
+      GCtab *pt = cl->preload;
+      cTValue *ptv = (pt && sym == strdata(name)) ?
+		     lj_tab_getstr(pt, name) : NULL;
+      void *p = ptv && tvisnum(ptv) ?  /* Preloaded address? */
+		(void *)(uintptr_t)numV(ptv) : clib_getsym(cl, sym);
       GCcdata *cd;
       lua_assert(ctype_isfunc(ct->info) || ctype_isextern(ct->info));
 #if LJ_TARGET_X86 && LJ_ABI_WIN
@@ -387,6 +530,7 @@ static CLibrary *clib_new(lua_State *L, GCtab *mt)
   GCudata *ud = lj_udata_new(L, sizeof(CLibrary), t);
   CLibrary *cl = (CLibrary *)uddata(ud);
   cl->cache = t;
+  cl->preload = NULL;
   ud->udtype = UDTYPE_FFI_CLIB;
   /* NOBARRIER: The GCudata is new (marked white). */
   setgcref(ud->metatable, obj2gco(mt));
@@ -395,11 +539,14 @@ static CLibrary *clib_new(lua_State *L, GCtab *mt)
 }
 
 /* Load a C library. */
-void lj_clib_load(lua_State *L, GCtab *mt, GCstr *name, int global)
+void lj_clib_load(lua_State *L, GCtab *mt, GCstr *name, int global,
+		  int preload)
 {
   void *handle = clib_loadlib(L, strdata(name), global);
   CLibrary *cl = clib_new(L, mt);
   cl->handle = handle;
+  if (preload)
+    clib_preload(L, cl);
 }
 
 /* Unload a C library. */
@@ -17,10 +17,12 @@
 typedef struct CLibrary {
   void *handle;		/* Opaque handle for dynamic library loader. */
   GCtab *cache;		/* Cache for resolved symbols. Anchored in ud->env. */
+  GCtab *preload;	/* Preloaded symbol addresses or NULL. Marked by GC. */
 } CLibrary;
 
 LJ_FUNC TValue *lj_clib_index(lua_State *L, CLibrary *cl, GCstr *name);
-LJ_FUNC void lj_clib_load(lua_State *L, GCtab *mt, GCstr *name, int global);
+LJ_FUNC void lj_clib_load(lua_State *L, GCtab *mt, GCstr *name, int global,
+			  int preload);
 LJ_FUNC void lj_clib_unload(CLibrary *cl);
 LJ_FUNC void lj_clib_default(lua_State *L, GCtab *mt);
 
@@ -1072,9 +1072,107 @@ static void crec_alloc(jit_State *J, RecordFFData *rd, CTypeID id)
     crec_finalizer(J, trcd, 0, fin);
 }
 
+/* Get the sizes of the FP leaves of an aggregate OR-ed together, 0 if it
+** has any other leaves. Returns CTSIZE_INVALID for unsupported layouts.
+*/
+static CTSize crec_agg_fpsize(CTState *cts, CType *ct)
+{
+  if (ctype_isfp(ct->info)) {
+    return ct->size;
+  } else if (ctype_iscomplex(ct->info)) {
+    return ct->size >> 1;
+  } else if (ctype_isarray(ct->info) && !ctype_isvector(ct->info)) {
+    return crec_agg_fpsize(cts, ctype_rawchild(cts, ct));
+  } else if (ctype_isstruct(ct->info)) {
+    CTSize fsz = 0;
+    int anyint = 0;
+    CTypeID fid = ct->sib;
+    while (fid) {
+      CType *ctf = ctype_get(cts, fid);
+      fid = ctf->sib;
+      if (ctype_isfield(ctf->info)) {
+	CType *cct = ctype_rawchild(cts, ctf);
+	CTSize sz;
+	if ((ctf->size & ((1u << ctype_align(cct->info)) - 1)))
+	  return CTSIZE_INVALID;  /* Unaligned fields need special handling. */
+	sz = crec_agg_fpsize(cts, cct);
+	if (sz == CTSIZE_INVALID)
+	  return CTSIZE_INVALID;
+	if (sz == 0)
+	  anyint = 1;
+	fsz |= sz;
+      } else if (ctype_isbitfield(ctf->info)) {
+	anyint = 1;
+      }
+    }
+    return anyint ? 0 : fsz;
+  } else if (ctype_isvector(ct->info)) {
+    return CTSIZE_INVALID;
+  }
+  return 0;
+}
+
+/*
+** Get the IR type to pass or return an aggregate (struct or complex) by
+** value in a single register. Returns IRT_NIL if it needs any other
+** convention, e.g. a register pair, a copy on the stack or an HFA.
+*/
+static IRType crec_agg2irt(CTState *cts, CType *ct)
+{
+  CTSize sz = ct->size, fsz;
+  if (!(sz == 1 || sz == 2 || sz == 4 || sz == 8))
+    return IRT_NIL;
+  fsz = crec_agg_fpsize(cts, ct);
+  if (fsz == CTSIZE_INVALID)
+    return IRT_NIL;
+#if LJ_TARGET_X64 && !LJ_ABI_WIN
+  if (fsz)  /* SSE class: all FP leaves, even of mixed size, in one XMM reg. */
+    return sz == 4 ? IRT_FLOAT : IRT_NUM;
+#elif LJ_TARGET_ARM64
+  if (fsz && !(fsz & (fsz-1)))  /* HFA needs leaves of a single FP type. */
+    return fsz != sz ? IRT_NIL : sz == 4 ? IRT_FLOAT : IRT_NUM;
+#elif !(LJ_TARGET_X64 && LJ_ABI_WIN)
+  return IRT_NIL;  /* NYI: other targets. */
+#endif
+  /* Everything else is passed like an integer of the same size. */
+  return sz == 1 ? IRT_U8 : sz == 2 ? IRT_U16 : sz == 4 ? IRT_INT : IRT_U64;
+}
+
+/* Check whether an aggregate result is returned via a hidden pointer. */
+static int crec_agg_sret(CType *ct)
+{
+#if LJ_TARGET_X64 && LJ_ABI_WIN
+  return !(ct->size == 1 || ct->size == 2 || ct->size == 4 || ct->size == 8);
+#elif LJ_TARGET_X64
+  return ct->size > 16;  /* MEMORY class. */
+#else
+  UNUSED(ct);
+  return 0;  /* NYI: ARM64 passes the pointer in x8, x86 pops it. */
+#endif
+}
+
+/* Record loading of an aggregate argument passed by value. */
+static TRef crec_call_aggarg(jit_State *J, CTState *cts, CType *d,
+			     TRef sp, cTValue *o)
+{
+  IRType t = crec_agg2irt(cts, d);
+  if (t != IRT_NIL && tref_iscdata(sp) &&
+      ctype_raw(cts, cdataV(o)->ctypeid) == d) {
+    TRef tr;
+    argv2cdata(J, sp, o);
+    sp = emitir(IRT(IR_ADD, IRT_PTR), sp, lj_ir_kintp(J, sizeof(GCcdata)));
+    tr = emitir(IRT(IR_XLOAD, t), sp, 0);
+    if (t == IRT_U8 || t == IRT_U16)
+      tr = emitconv(tr, IRT_INT, t, 0);
+    return tr;
+  }
+  lj_trace_err(J, LJ_TRERR_NYICALL);
+  return 0;
+}
+
 /* Record argument conversions. */
 static TRef crec_call_args(jit_State *J, RecordFFData *rd,
-			   CTState *cts, CType *ct)
+			   CTState *cts, CType *ct, TRef sret)
 {
   TRef args[CCI_NARGS_MAX];
   CTypeID fid;
@@ -1099,10 +1197,12 @@ static TRef crec_call_args(jit_State *J, RecordFFData *rd,
     if (!ctype_isattrib(ctf->info)) break;
     fid = ctf->sib;
   }
-  args[0] = TREF_NIL;
-  for (n = 0, base = J->base+1, o = rd->argv+1; *base; n++, base++, o++) {
+  args[0] = sret ? sret : TREF_NIL;  /* Hidden result pointer comes first. */
+  for (n = sret ? 1 : 0, base = J->base+1, o = rd->argv+1; *base;
+       n++, base++, o++) {
     CTypeID did;
     CType *d;
+    int isva = 0;
 
     if (n >= CCI_NARGS_MAX)
       lj_trace_err(J, LJ_TRERR_NYICALL);
@@ -1116,12 +1216,19 @@ static TRef crec_call_args(jit_State *J, RecordFFData *rd,
       if (!(ct->info & CTF_VARARG))
 	lj_trace_err(J, LJ_TRERR_NYICALL);  /* Too many arguments. */
       did = lj_ccall_ctid_vararg(cts, o);  /* Infer vararg type. */
+      isva = 1;
     }
     d = ctype_raw(cts, did);
-    if (!(ctype_isnum(d->info) || ctype_isptr(d->info) ||
-	  ctype_isenum(d->info)))
+    if (ctype_isstruct(d->info) || ctype_iscomplex(d->info)) {
+      if (isva)  /* NYI: struct and complex varargs. */
+	lj_trace_err(J, LJ_TRERR_NYICALL);
+      tr = crec_call_aggarg(J, cts, d, *base, o);
+    } else if (!(ctype_isnum(d->info) || ctype_isptr(d->info) ||
+		 ctype_isenum(d->info))) {
       lj_trace_err(J, LJ_TRERR_NYICALL);
-    tr = crec_ct_tv(J, d, 0, *base, o);
+    } else {
+      tr = crec_ct_tv(J, d, 0, *base, o);
+    }
     if (ctype_isinteger_or_bool(d->info)) {
       if (d->size < 4) {
 	if ((d->info & CTF_UNSIGNED))
@@ -1205,7 +1312,7 @@ static int crec_call(jit_State *J, RecordFFData *rd, GCcdata *cd)
     TRef func = emitir(IRT(IR_FLOAD, tp), J->base[0], IRFL_CDATA_PTR);
     CType *ctr = ctype_rawchild(cts, ct);
     IRType t = crec_ct2irt(cts, ctr);
-    TRef tr;
+    TRef tr, trcd = 0, trptr = 0, sret = 0;
     TValue tv;
     /* Check for blacklisted C functions that might call a callback. */
     tv.u64 = ((uintptr_t)cdata_getptr(cdataptr(cd), (LJ_64 && tp == IRT_P64) ? 8 : 4) >> 2) | U64x(800000000, 00000000);
@@ -1214,6 +1321,17 @@ static int crec_call(jit_State *J, RecordFFData *rd, GCcdata *cd)
     if (ctype_isvoid(ctr->info)) {
       t = IRT_NIL;
       rd->nres = 0;
+    } else if (ctype_isstruct(ctr->info) || ctype_iscomplex(ctr->info)) {
+      /* Preallocate the aggregate result. */
+      t = crec_agg2irt(cts, ctr);
+      if (t == IRT_NIL && !crec_agg_sret(ctr))
+	lj_trace_err(J, LJ_TRERR_NYICALL);
+      trcd = emitir(IRTG(IR_CNEW, IRT_CDATA),
+		    lj_ir_kint(J, ctype_cid(ct->info)), TREF_NIL);
+      trptr = emitir(IRT(IR_ADD, IRT_PTR), trcd,
+		     lj_ir_kintp(J, sizeof(GCcdata)));
+      if (t == IRT_NIL)  /* Let the callee fill it in via a hidden pointer. */
+	sret = trptr;
     } else if (!(ctype_isnum(ctr->info) || ctype_isptr(ctr->info) ||
 		 ctype_isenum(ctr->info)) || t == IRT_CDATA) {
       lj_trace_err(J, LJ_TRERR_NYICALL);
@@ -1225,8 +1343,12 @@ static int crec_call(jit_State *J, RecordFFData *rd, GCcdata *cd)
 	)
       func = emitir(IRT(IR_CARG, IRT_NIL), func,
 		    lj_ir_kint(J, ctype_typeid(cts, ct)));
-    tr = emitir(IRT(IR_CALLXS, t), crec_call_args(J, rd, cts, ct), func);
-    if (ctype_isbool(ctr->info)) {
+    tr = emitir(IRT(IR_CALLXS, t), crec_call_args(J, rd, cts, ct, sret), func);
+    if (trcd) {
+      if (!sret)  /* Store the result register into the aggregate. */
+	emitir(IRT(IR_XSTORE, t), trptr, tr);
+      tr = trcd;
+    } else if (ctype_isbool(ctr->info)) {
       if (frame_islua(J->L->base-1) && bc_b(frame_pc(J->L->base-1)[-1]) == 1) {
 	/* Don't check result if ignored. */
 	tr = TREF_NIL;
@@ -1864,6 +1986,25 @@ TRef recff_bit64_tohex(jit_State *J, RecordFFData *rd, TRef hdr)
 
 /* -- Miscellaneous library functions ------------------------------------- */
 
+/* Convert a cdata argument of a library function to a C pointer. */
+static TRef crec_toptr(jit_State *J, CTypeID id, TRef tr, cTValue *o)
+{
+  CTState *cts = ctype_ctsG(J2G(J));
+  if (!tref_iscdata(tr))
+    lj_trace_err(J, LJ_TRERR_BADTYPE);
+  return crec_ct_tv(J, ctype_get(cts, id), 0, tr, o);
+}
+
+TRef lj_crecord_topvoid(jit_State *J, TRef tr, cTValue *o)
+{
+  return crec_toptr(J, CTID_P_VOID, tr, o);
+}
+
+TRef lj_crecord_topcvoid(jit_State *J, TRef tr, cTValue *o)
+{
+  return crec_toptr(J, CTID_P_CVOID, tr, o);
+}
+
 void LJ_FASTCALL lj_crecord_tonumber(jit_State *J, RecordFFData *rd)
 {
   CTState *cts = ctype_ctsG(J2G(J));
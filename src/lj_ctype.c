@@ -579,9 +579,9 @@ GCstr *lj_ctype_repr_complex(lua_State *L, void *sp, CTSize size)
   } else {
     re.n = (double)*(float *)sp; im.n = (double)((float *)sp)[1];
   }
-  lj_strfmt_putfnum(sb, STRFMT_G14, re.n);
+  lj_strfmt_putfnum(sb, STRFMT_NUMDEF, re.n);
   if (!(im.u32.hi & 0x80000000u) || im.n != im.n) lj_buf_putchar(sb, '+');
-  lj_strfmt_putfnum(sb, STRFMT_G14, im.n);
+  lj_strfmt_putfnum(sb, STRFMT_NUMDEF, im.n);
   lj_buf_putchar(sb, sbufP(sb)[-1] >= 'a' ? 'I' : 'i');
   return lj_buf_str(L, sb);
 }
@@ -628,6 +628,7 @@ void lj_ctype_freestate(global_State *g)
   CTState *cts = ctype_ctsG(g);
   if (cts) {
     lj_ccallback_mcode_free(cts);
+    lj_ccallback_plan_free(cts);
     lj_mem_freevec(g, cts->tab, cts->sizetab, CType);
     lj_mem_freevec(g, cts->cb.cbid, cts->cb.sizeid, CTypeID1);
     lj_mem_freet(g, cts);
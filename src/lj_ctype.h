@@ -149,6 +149,7 @@ typedef struct CType {
 } CType;
 
 #define CTHASH_SIZE	128	/* Number of hash anchors. */
+#define CTCACHE_MAX	256	/* Max. number of cached type strings. */
 #define CTHASH_MASK	(CTHASH_SIZE-1)
 
 /* Simplify target-specific configuration. Checked in lj_ccall.h. */
@@ -165,7 +166,9 @@ typedef LJ_ALIGN(8) struct CCallback {
   intptr_t *stack;		/* Pointer to arguments on stack. */
   void *mcode;			/* Machine code for callback func. pointers. */
   CTypeID1 *cbid;		/* Callback type table. */
+  struct CCallbackPlan **plan;	/* Argument conversion plans per slot. */
   MSize sizeid;			/* Size of callback type table. */
+  MSize sizeplan;		/* Size of callback plan table. */
   MSize topid;			/* Highest unused callback type table slot. */
   MSize slot;			/* Current callback slot. */
 } CCallback;
@@ -179,6 +182,8 @@ typedef struct CTState {
   global_State *g;	/* Global state. */
   GCtab *finalizer;	/* Map of cdata to finalizer. */
   GCtab *miscmap;	/* Map of -CTypeID to metatable and cb slot to func. */
+  GCtab *typecache;	/* Map of type declaration strings to CTypeID. */
+  MSize ntypecache;	/* Number of cached type declaration strings. */
   CCallback cb;		/* Temporary callback state. */
   CTypeID1 hash[CTHASH_SIZE];  /* Hash anchors for C type table. */
 } CTState;
@@ -60,6 +60,7 @@ typedef unsigned int uintptr_t;
 #define LJ_MAX_ABITS	28		/* Max. bits of array key. */
 #define LJ_MAX_ASIZE	((1<<(LJ_MAX_ABITS-1))+1)  /* Max. array part size. */
 #define LJ_MAX_COLOSIZE	16		/* Max. elems for colocated array. */
+#define LJ_MAX_COLOHBITS 3		/* Max. hash bits for colocated hash. */
 
 #define LJ_MAX_LINE	LJ_MAX_MEM32	/* Max. source code line number. */
 #define LJ_MAX_XLEVEL	200		/* Max. syntactic nesting level. */
@@ -70,6 +71,9 @@ typedef unsigned int uintptr_t;
 
 #define LJ_MAX_IDXCHAIN	100		/* __index/__newindex chain limit. */
 #define LJ_STACK_EXTRA	(5+2*LJ_FR2)	/* Extra stack space (metamethods). */
+#define LJ_MAX_THPOOL	128		/* Max. # of recycled threads. */
+#define LJ_MAX_CDPOOLSZ	32		/* Max. size of pooled cdata objects. */
+#define LJ_MAX_CDPOOL	256		/* Max. # of pooled cdata per size. */
 
 #define LJ_NUM_CBPAGE	1		/* Number of FFI callback pages. */
 
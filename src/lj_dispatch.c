@@ -83,12 +83,14 @@ void lj_dispatch_init(GG_State *GG)
 /* Initialize hotcount table. */
 void lj_dispatch_init_hotcount(global_State *g)
 {
-  int32_t hotloop = G2J(g)->param[JIT_P_hotloop];
-  HotCount start = (HotCount)(hotloop*HOTCOUNT_LOOP - 1);
+  HotCount start = (HotCount)(hotcount_start(G2J(g)) - 1);
   HotCount *hotcount = G2GG(g)->hotcount;
   uint32_t i;
-  for (i = 0; i < HOTCOUNT_SIZE; i++)
+  for (i = 0; i < HOTCOUNT_SIZE; i++) {
     hotcount[i] = start;
+    setmref(G2GG(g)->hotpc[i], NULL);
+    G2GG(g)->hotmiss[i] = 0;
+  }
 }
 #endif
 
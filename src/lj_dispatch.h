@@ -71,9 +71,28 @@ GOTDEF(GOTENUM)
 typedef uint16_t HotCount;
 
 /* Number of hot counter hash table entries (must be a power of two). */
+#ifdef LUAJIT_HOTCOUNT_SIZE
+#define HOTCOUNT_SIZE		LUAJIT_HOTCOUNT_SIZE
+#else
 #define HOTCOUNT_SIZE		64
+#endif
+#if (HOTCOUNT_SIZE & (HOTCOUNT_SIZE-1)) || HOTCOUNT_SIZE > 65536
+#error "LUAJIT_HOTCOUNT_SIZE must be a power of two and at most 65536"
+#endif
+#if HOTCOUNT_SIZE != 64 && !LJ_TARGET_X86ORX64
+/* The other assembler VMs use a hardcoded index mask. */
+#error "LUAJIT_HOTCOUNT_SIZE is only supported on x86/x64"
+#endif
 #define HOTCOUNT_PCMASK		((HOTCOUNT_SIZE-1)*sizeof(HotCount))
 
+/* Number of hash slot cache entries for the interpreter (power of two). */
+#define HSCACHE_SIZE		1024
+#define HSCACHE_PCMASK		((HSCACHE_SIZE-1)*sizeof(uint32_t))
+#if LJ_TARGET_X86ORX64
+/* hscache_set in vm_x86.dasc and vm_x64.dasc divides by sizeof(Node). */
+LJ_STATIC_ASSERT(sizeof(Node) == 24);
+#endif
+
 /* Hotcount decrements. */
 #define HOTCOUNT_LOOP		2
 #define HOTCOUNT_CALL		1
@@ -98,6 +117,13 @@ typedef struct GG_State {
 #endif
   ASMFunction dispatch[GG_LEN_DISP];	/* Instruction dispatch tables. */
   BCIns bcff[GG_NUM_ASMFF];		/* Bytecode for ASM fast functions. */
+#if LJ_TARGET_X86ORX64
+  uint32_t hscache[HSCACHE_SIZE];	/* Hash slot cache for TGETS/TSETS. */
+#endif
+#if LJ_HASJIT
+  MRef hotpc[HOTCOUNT_SIZE];		/* Last bytecode triggering a counter. */
+  uint8_t hotmiss[HOTCOUNT_SIZE];	/* Failed verifications of a counter. */
+#endif
 } GG_State;
 
 #define GG_OFS(field)	((int)offsetof(GG_State, field))
@@ -112,12 +138,27 @@ typedef struct GG_State {
 #define GG_DISP2G	(GG_OFS(g) - GG_OFS(dispatch))
 #define GG_DISP2J	(GG_OFS(J) - GG_OFS(dispatch))
 #define GG_DISP2HOT	(GG_OFS(hotcount) - GG_OFS(dispatch))
+#define GG_DISP2HSC	(GG_OFS(hscache) - GG_OFS(dispatch))
 #define GG_DISP2STATIC	(GG_LEN_DDISP*(int)sizeof(ASMFunction))
 
 #define hotcount_get(gg, pc) \
   (gg)->hotcount[(u32ptr(pc)>>2) & (HOTCOUNT_SIZE-1)]
 #define hotcount_set(gg, pc, val) \
   (hotcount_get((gg), (pc)) = (HotCount)(val))
+#define hotpc_get(gg, pc) \
+  (gg)->hotpc[(u32ptr(pc)>>2) & (HOTCOUNT_SIZE-1)]
+#define hotmiss_get(gg, pc) \
+  (gg)->hotmiss[(u32ptr(pc)>>2) & (HOTCOUNT_SIZE-1)]
+
+/* Failed verifications after which a hot counter trigger is accepted. */
+#define HOTVERIFY_MAXMISS	16
+
+/* Hot counter start value. With hotverify, a trace is only started after
+** two consecutive triggers by the same bytecode, so each one counts half.
+*/
+#define hotcount_start(J) \
+  (((J)->param[JIT_P_hotverify] ? ((J)->param[JIT_P_hotloop]+1) >> 1 : \
+    (J)->param[JIT_P_hotloop]) * HOTCOUNT_LOOP)
 
 /* Dispatch table management. */
 LJ_FUNC void lj_dispatch_init(GG_State *GG);
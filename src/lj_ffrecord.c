@@ -139,34 +139,39 @@ static void recff_stitch(jit_State *J)
   L->top -= 2 + LJ_FR2;
 }
 
-/* Fallback handler for fast functions that are not recorded (yet). */
-static void LJ_FASTCALL recff_nyi(jit_State *J, RecordFFData *rd)
+/* Stitch the trace across the fast function call if possible. */
+static void recff_stitchstop(jit_State *J, RecordFFData *rd)
 {
-  if (J->cur.nins < (IRRef)J->param[JIT_P_minstitch] + REF_BASE) {
-    lj_trace_err_info(J, LJ_TRERR_TRACEUV);
-  } else {
-    /* Can only stitch from Lua call. */
-    if (J->framedepth && frame_islua(J->L->base-1)) {
-      BCOp op = bc_op(*frame_pc(J->L->base-1));
-      /* Stitched trace cannot start with *M op with variable # of args. */
-      if (!(op == BC_CALLM || op == BC_CALLMT ||
-	    op == BC_RETM || op == BC_TSETM)) {
-	switch (J->fn->c.ffid) {
-	case FF_error:
-	case FF_debug_sethook:
-	case FF_jit_flush:
-	  break;  /* Don't stitch across special builtins. */
-	default:
-	  recff_stitch(J);  /* Use trace stitching. */
-	  rd->nres = -1;
-	  return;
-	}
+  /* Can only stitch from Lua call. */
+  if (J->framedepth && frame_islua(J->L->base-1)) {
+    BCOp op = bc_op(*frame_pc(J->L->base-1));
+    /* Stitched trace cannot start with *M op with variable # of args. */
+    if (!(op == BC_CALLM || op == BC_CALLMT ||
+	  op == BC_RETM || op == BC_TSETM)) {
+      switch (J->fn->c.ffid) {
+      case FF_error:
+      case FF_debug_sethook:
+      case FF_jit_flush:
+	break;  /* Don't stitch across special builtins. */
+      default:
+	recff_stitch(J);  /* Use trace stitching. */
+	rd->nres = -1;
+	return;
       }
     }
-    /* Otherwise stop trace and return to interpreter. */
-    lj_record_stop(J, LJ_TRLINK_RETURN, 0);
-    rd->nres = -1;
   }
+  /* Otherwise stop trace and return to interpreter. */
+  lj_record_stop(J, LJ_TRLINK_RETURN, 0);
+  rd->nres = -1;
+}
+
+/* Fallback handler for fast functions that are not recorded (yet). */
+static void LJ_FASTCALL recff_nyi(jit_State *J, RecordFFData *rd)
+{
+  if (J->cur.nins < (IRRef)J->param[JIT_P_minstitch] + REF_BASE)
+    lj_trace_err_info(J, LJ_TRERR_TRACEUV);
+  else
+    recff_stitchstop(J, rd);
 }
 
 /* Fallback handler for unsupported variants of fast functions. */
@@ -505,6 +510,40 @@ static void LJ_FASTCALL recff_getfenv(jit_State *J, RecordFFData *rd)
   recff_nyiu(J, rd);
 }
 
+/* -- Coroutine library fast functions ------------------------------------ */
+
+/*
+** Only coroutine.running() is recorded inline. A coroutine switch by
+** coroutine.resume(), coroutine.yield() or a coroutine.wrap() function
+** replaces the Lua stack under the trace, so it is NYI, too. It ends the
+** trace and is stitched like other NYI fast functions.
+** Unlike recff_nyi() this deliberately ignores the minstitch parameter:
+** aborting a short trace doesn't pay off here, since the only
+** alternative for a producer/consumer loop is the interpreter. With the
+** default minstitch=0 both behave the same.
+*/
+static void LJ_FASTCALL recff_coroutine_switch(jit_State *J, RecordFFData *rd)
+{
+  recff_stitchstop(J, rd);
+}
+
+static void LJ_FASTCALL recff_coroutine_running(jit_State *J, RecordFFData *rd)
+{
+  TRef trl = emitir(IRT(IR_LREF, IRT_THREAD), 0, 0);
+  GCobj *mainth = obj2gco(mainthread(J2G(J)));
+  int ismain = (obj2gco(J->L) == mainth);
+  emitir(IRTG(ismain ? IR_EQ : IR_NE, IRT_THREAD), trl,
+	 lj_ir_kgc(J, mainth, IRT_THREAD));
+#if LJ_52
+  J->base[0] = trl;
+  J->base[1] = ismain ? TREF_TRUE : TREF_FALSE;
+  rd->nres = 2;
+#else
+  J->base[0] = ismain ? TREF_NIL : trl;
+  UNUSED(rd);
+#endif
+}
+
 /* -- Math library fast functions ----------------------------------------- */
 
 static void LJ_FASTCALL recff_math_abs(jit_State *J, RecordFFData *rd)
@@ -1071,6 +1110,37 @@ static void LJ_FASTCALL recff_table_insert(jit_State *J, RecordFFData *rd)
   }  /* else: Interpreter will throw. */
 }
 
+static void LJ_FASTCALL recff_table_move(jit_State *J, RecordFFData *rd)
+{
+  TRef src = J->base[0];
+  TRef dst = (J->base[1] && J->base[2] && J->base[3] && J->base[4] &&
+	      !tref_isnil(J->base[4])) ? J->base[4] : src;
+  if (tref_istab(src) && tref_istab(dst) && J->base[3]) {
+    GCtab *st = tabV(&rd->argv[0]);
+    GCtab *dt = dst == src ? st : tabV(&rd->argv[4]);
+    TRef trf, tre, trt, tr;
+    if (gcref(st->metatable) || gcref(dt->metatable)) {
+      recff_nyiu(J, rd);  /* Metamethods may be called. */
+      return;
+    }
+    /* Guard against metatables, to get a raw bulk move. */
+    tr = emitir(IRT(IR_FLOAD, IRT_TAB), src, IRFL_TAB_META);
+    emitir(IRTG(IR_EQ, IRT_TAB), tr, lj_ir_knull(J, IRT_TAB));
+    if (dst != src) {
+      tr = emitir(IRT(IR_FLOAD, IRT_TAB), dst, IRFL_TAB_META);
+      emitir(IRTG(IR_EQ, IRT_TAB), tr, lj_ir_knull(J, IRT_TAB));
+    }
+    trf = lj_opt_narrow_toint(J, J->base[1]);
+    tre = lj_opt_narrow_toint(J, J->base[2]);
+    trt = lj_opt_narrow_toint(J, J->base[3]);
+    tr = lj_ir_call(J, IRCALL_lj_tab_move, dst, src, trf, tre, trt);
+    /* Invalid ranges: the interpreter throws before anything is moved. */
+    emitir(IRTGI(IR_NE), tr, lj_ir_kint(J, 0));
+    J->base[0] = dst;
+    J->needsnap = 1;
+  }  /* else: Interpreter will throw. */
+}
+
 static void LJ_FASTCALL recff_table_concat(jit_State *J, RecordFFData *rd)
 {
   TRef tab = J->base[0];
@@ -1108,6 +1178,15 @@ static void LJ_FASTCALL recff_table_clear(jit_State *J, RecordFFData *rd)
   }  /* else: Interpreter will throw. */
 }
 
+static void LJ_FASTCALL recff_table_clone(jit_State *J, RecordFFData *rd)
+{
+  TRef tr = J->base[0];
+  if (tref_istab(tr))
+    J->base[0] = lj_ir_call(J, IRCALL_lj_tab_dup, tr);
+  /* else: Interpreter will throw. */
+  UNUSED(rd);
+}
+
 /* -- I/O library fast functions ------------------------------------------ */
 
 /* Get FILE* for I/O function. Any I/O error aborts recording, so there's
@@ -1143,6 +1222,15 @@ static void LJ_FASTCALL recff_io_write(jit_State *J, RecordFFData *rd)
   TRef zero = lj_ir_kint(J, 0);
   TRef one = lj_ir_kint(J, 1);
   ptrdiff_t i = rd->data == 0 ? 1 : 0;
+  if (J->base[i] && J->base[i+1]) {
+    /* Gather all arguments and write them with a single call. */
+    TRef tr = recff_bufhdr(J);
+    for (; J->base[i]; i++)
+      tr = emitir(IRT(IR_BUFPUT, IRT_PGC), tr, lj_ir_tostr(J, J->base[i]));
+    tr = lj_ir_call(J, IRCALL_lj_lib_io_writebuf, tr, fp);
+    if (results_wanted(J) != 0)  /* Check result only if not ignored. */
+      emitir(IRTGI(IR_NE), tr, zero);
+  }
   for (; J->base[i]; i++) {
     TRef str = lj_ir_tostr(J, J->base[i]);
     TRef buf = emitir(IRT(IR_STRREF, IRT_PGC), str, zero);
@@ -1173,6 +1261,88 @@ static void LJ_FASTCALL recff_io_flush(jit_State *J, RecordFFData *rd)
   J->base[0] = TREF_TRUE;
 }
 
+static void LJ_FASTCALL recff_io_read(jit_State *J, RecordFFData *rd)
+{
+  ptrdiff_t i = rd->data == 0 ? 1 : 0;
+  int32_t chop = 1;
+  TRef ud, tr;
+  if (J->base[i]) {  /* Only a single line format is recorded. */
+    GCstr *fmt;
+    const char *p;
+    if (J->base[i+1] || !tref_isstr(J->base[i])) {
+      recff_nyiu(J, rd);
+      return;
+    }
+    fmt = strV(&rd->argv[i]);
+    p = strdata(fmt);
+    if (p[0] == '*') p++;
+    if ((p[0] & ~0x20) != 'L') {
+      recff_nyiu(J, rd);
+      return;
+    }
+    chop = (p[0] == 'l');
+    emitir(IRTG(IR_EQ, IRT_STR), J->base[i], lj_ir_kstr(J, fmt));
+  }
+  recff_io_fp(J, &ud, rd->data);
+  tr = lj_ir_call(J, IRCALL_lj_lib_io_readline, ud, lj_ir_kint(J, chop));
+  /* EOF, errors etc. are handled by the interpreter. */
+  emitir(IRTG(IR_NE, IRT_STR), tr, lj_ir_knull(J, IRT_STR));
+  J->base[0] = tr;
+}
+
+static void LJ_FASTCALL recff_io_file_iter(jit_State *J, RecordFFData *rd)
+{
+  if (J->fn->c.nupvalues == 1) {  /* Only plain lines without formats. */
+    TRef tr = lj_ir_call(J, IRCALL_lj_lib_io_iterline, J->base[-1-LJ_FR2]);
+    emitir(IRTG(IR_NE, IRT_STR), tr, lj_ir_knull(J, IRT_STR));
+    J->base[0] = tr;
+  } else {
+    recff_nyiu(J, rd);
+  }
+}
+
+#if LJ_HASFFI
+/* Get the pointer and length arguments of file:readinto/writefrom. */
+static int recff_io_ptrlen(jit_State *J, RecordFFData *rd, int isconst,
+			   TRef *trp, TRef *trlen)
+{
+  if (J->base[1] && J->base[2] && tvisnumber(&rd->argv[2]) &&
+      numberVint(&rd->argv[2]) >= 0) {
+    *trp = isconst ? lj_crecord_topcvoid(J, J->base[1], &rd->argv[1]) :
+		     lj_crecord_topvoid(J, J->base[1], &rd->argv[1]);
+    *trlen = lj_opt_narrow_toint(J, J->base[2]);
+    emitir(IRTGI(IR_GE), *trlen, lj_ir_kint(J, 0));
+    return 1;
+  }
+  return 0;  /* The interpreter will throw. */
+}
+
+static void LJ_FASTCALL recff_io_readinto(jit_State *J, RecordFFData *rd)
+{
+  TRef ud, trp, trlen, tr;
+  recff_io_fp(J, &ud, 0);
+  if (recff_io_ptrlen(J, rd, 0, &trp, &trlen)) {
+    tr = lj_ir_call(J, IRCALL_lj_lib_io_readinto, ud, trp, trlen);
+    /* Errors are handled by the interpreter. */
+    emitir(IRTGI(IR_GE), tr, lj_ir_kint(J, 0));
+    emitir(IRT(IR_XBAR, IRT_NIL), 0, 0);  /* Disable alias analysis. */
+    J->base[0] = tr;
+  }
+}
+
+static void LJ_FASTCALL recff_io_writefrom(jit_State *J, RecordFFData *rd)
+{
+  TRef ud, fp = recff_io_fp(J, &ud, 0);
+  TRef trp, trlen;
+  if (recff_io_ptrlen(J, rd, 1, &trp, &trlen)) {
+    TRef tr = lj_ir_call(J, IRCALL_fwrite, trp, lj_ir_kint(J, 1), trlen, fp);
+    if (results_wanted(J) != 0)  /* Check result only if not ignored. */
+      emitir(IRTGI(IR_EQ), tr, trlen);
+    J->base[0] = LJ_52 ? ud : TREF_TRUE;
+  }
+}
+#endif
+
 /* -- Debug library fast functions ---------------------------------------- */
 
 static void LJ_FASTCALL recff_debug_getmetatable(jit_State *J, RecordFFData *rd)
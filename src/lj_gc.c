@@ -23,6 +23,7 @@
 #if LJ_HASFFI
 #include "lj_ctype.h"
 #include "lj_cdata.h"
+#include "lj_clib.h"
 #endif
 #include "lj_trace.h"
 #include "lj_vm.h"
@@ -62,6 +63,12 @@ static void gc_mark(global_State *g, GCobj *o)
     gray2black(o);  /* Userdata are never gray. */
     if (mt) gc_markobj(g, mt);
     gc_markobj(g, tabref(gco2ud(o)->env));
+#if LJ_HASFFI
+    if (gco2ud(o)->udtype == UDTYPE_FFI_CLIB) {
+      GCtab *pt = ((CLibrary *)uddata(gco2ud(o)))->preload;
+      if (pt) gc_markobj(g, pt);
+    }
+#endif
   } else if (LJ_UNLIKELY(gct == ~LJ_TUPVAL)) {
     GCupval *uv = gco2uv(o);
     gc_marktv(g, uvval(uv));
@@ -29,6 +29,7 @@ typedef struct CCallInfo {
 #define CCI_CALL_L		(IR_CALLL << CCI_OPSHIFT)
 #define CCI_CALL_S		(IR_CALLS << CCI_OPSHIFT)
 #define CCI_CALL_FN		(CCI_CALL_N|CCI_CC_FASTCALL)
+#define CCI_CALL_FA		(CCI_CALL_A|CCI_CC_FASTCALL)
 #define CCI_CALL_FL		(CCI_CALL_L|CCI_CC_FASTCALL)
 #define CCI_CALL_FS		(CCI_CALL_S|CCI_CC_FASTCALL)
 
@@ -149,10 +150,11 @@ typedef struct CCallInfo {
   _(ANY,	lj_buf_tostr,		1,  FL, STR, 0) \
   _(ANY,	lj_tab_new_ah,		3,   A, TAB, CCI_L) \
   _(ANY,	lj_tab_new1,		2,  FS, TAB, CCI_L) \
-  _(ANY,	lj_tab_dup,		2,  FS, TAB, CCI_L) \
+  _(ANY,	lj_tab_dup,		2,  FA, TAB, CCI_L) \
   _(ANY,	lj_tab_clear,		1,  FS, NIL, 0) \
   _(ANY,	lj_tab_newkey,		3,   S, PGC, CCI_L) \
   _(ANY,	lj_tab_len,		1,  FL, INT, 0) \
+  _(ANY,	lj_tab_move,		6,   S, INT, CCI_L) \
   _(ANY,	lj_gc_step_jit,		2,  FS, NIL, CCI_L) \
   _(ANY,	lj_gc_barrieruv,	2,  FS, NIL, 0) \
   _(ANY,	lj_mem_newgco,		2,  FS, PGC, CCI_L) \
@@ -164,6 +166,10 @@ typedef struct CCallInfo {
   _(ANY,	fputc,			2,   S, INT, 0) \
   _(ANY,	fwrite,			4,   S, INT, 0) \
   _(ANY,	fflush,			1,   S, INT, 0) \
+  _(ANY,	lj_lib_io_readline,	3,   A, STR, CCI_L) \
+  _(ANY,	lj_lib_io_iterline,	2,   A, STR, CCI_L) \
+  _(ANY,	lj_lib_io_writebuf,	2,   S, INT, 0) \
+  _(FFI,	lj_lib_io_readinto,	3,   S, INT, 0) \
   /* ORDER FPM */ \
   _(FPMATH,	lj_vm_floor,		1,   N, NUM, XA_FP) \
   _(FPMATH,	lj_vm_ceil,		1,   N, NUM, XA_FP) \
@@ -105,6 +105,7 @@
   _(\011, minstitch,	0)	/* Min. # of IR ins for a stitched trace. */ \
   \
   _(\007, hotloop,	56)	/* # of iter. to detect a hot loop/call. */ \
+  _(\011, hotverify,	0)	/* Verify hot counter triggers (0/1). */ \
   _(\007, hotexit,	10)	/* # of taken exits to start a side trace. */ \
   _(\007, tryside,	4)	/* # of attempts to compile a side trace. */ \
   \
@@ -477,6 +478,7 @@ typedef struct jit_State {
   size_t tracenum;	/* Overall number of traces. */
   size_t nsnaprestore;	/* Overall number of snap restores. */
   size_t ntraceabort;	/* Overall number of abort traces. */
+  size_t nhotcollide;	/* Overall number of hot counter collisions. */
 
   TValue errinfo;	/* Additional info element for trace errors. */
 
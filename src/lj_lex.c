@@ -83,6 +83,105 @@ static void lex_newline(LexState *ls)
     lj_lex_error(ls, ls->tok, LJ_ERR_XLINES);
 }
 
+/* -- Span scanning ------------------------------------------------------- */
+
+/*
+** The hot loops of the lexer run over long spans of characters which
+** need no further processing: identifiers, whitespace, comment bodies
+** and string contents without escapes. These spans are located in the
+** current input chunk [ls->p, ls->pe) with the helpers below, 16 bytes
+** at a time where SSE2 is available. A span never crosses the end of a
+** chunk, so the callers simply loop back to the per-character path.
+*/
+
+#if LJ_TARGET_X86ORX64 && (defined(__SSE2__) || defined(_M_X64))
+#define LEX_SIMD	1
+#include <emmintrin.h>
+
+#define lex_vec(c)	_mm_set1_epi8((char)(c))
+#define lex_veq(x, c)	_mm_cmpeq_epi8((x), lex_vec(c))
+/* Unsigned range check lo <= x <= hi with signed compares. */
+#define lex_vrange(x, lo, hi) \
+  _mm_cmplt_epi8(_mm_add_epi8((x), lex_vec(0x80-(lo))), \
+		 lex_vec((hi)-(lo)+1-0x80))
+#else
+#define LEX_SIMD	0
+#endif
+
+/* Find end of identifier characters. */
+static const char *lex_spanident(const char *p, const char *pe)
+{
+#if LEX_SIMD
+  while (pe - p >= 16) {
+    __m128i x = _mm_loadu_si128((const __m128i *)p);
+    __m128i m = _mm_or_si128(
+      _mm_or_si128(lex_vrange(_mm_or_si128(x, lex_vec(0x20)), 'a', 'z'),
+		   lex_vrange(x, '0', '9')),
+      _mm_or_si128(lex_veq(x, '_'), _mm_cmplt_epi8(x, _mm_setzero_si128())));
+    uint32_t k = (uint32_t)_mm_movemask_epi8(m) ^ 0xffffu;
+    if (k) return p + lj_ffs(k);
+    p += 16;
+  }
+#endif
+  while (p < pe && lj_char_isident((uint8_t)*p)) p++;
+  return p;
+}
+
+/* Find end of blanks (no line breaks). */
+static const char *lex_spanblank(const char *p, const char *pe)
+{
+#if LEX_SIMD
+  while (pe - p >= 16) {
+    __m128i x = _mm_loadu_si128((const __m128i *)p);
+    __m128i m = _mm_andnot_si128(lex_veq(x, '\n'),
+      _mm_or_si128(lex_veq(x, ' '), lex_vrange(x, '\t', '\f')));
+    uint32_t k = (uint32_t)_mm_movemask_epi8(m) ^ 0xffffu;
+    if (k) return p + lj_ffs(k);
+    p += 16;
+  }
+#endif
+  while (p < pe && (*p == ' ' || (*p >= '\t' && *p <= '\f' && *p != '\n')))
+    p++;
+  return p;
+}
+
+/* Find first line break or one of two stop characters. */
+static const char *lex_spanstop(const char *p, const char *pe, int a, int b)
+{
+#if LEX_SIMD
+  __m128i va = lex_vec(a), vb = lex_vec(b);
+  while (pe - p >= 16) {
+    __m128i x = _mm_loadu_si128((const __m128i *)p);
+    __m128i m = _mm_or_si128(
+      _mm_or_si128(_mm_cmpeq_epi8(x, va), _mm_cmpeq_epi8(x, vb)),
+      _mm_or_si128(lex_veq(x, '\n'), lex_veq(x, '\r')));
+    uint32_t k = (uint32_t)_mm_movemask_epi8(m);
+    if (k) return p + lj_ffs(k);
+    p += 16;
+  }
+#endif
+  while (p < pe && *p != a && *p != b && *p != '\n' && *p != '\r') p++;
+  return p;
+}
+
+/* Save current character plus the span up to q and get next character. */
+static LJ_AINLINE LexChar lex_savespan(LexState *ls, const char *q)
+{
+  MSize n = (MSize)(q - ls->p);
+  char *w = lj_buf_more(&ls->sb, n+1);
+  *w++ = (char)ls->c;
+  setsbufP(&ls->sb, lj_buf_wmem(w, ls->p, n));
+  ls->p = q;
+  return lex_next(ls);
+}
+
+/* Skip current character plus the span up to q and get next character. */
+static LJ_AINLINE LexChar lex_skipspan(LexState *ls, const char *q)
+{
+  ls->p = q;
+  return lex_next(ls);
+}
+
 /* -- Scanner for terminals ----------------------------------------------- */
 
 /* Parse a number literal. */
@@ -166,9 +265,11 @@ static void lex_longstring(LexState *ls, TValue *tv, int sep)
       lex_newline(ls);
       if (!tv) lj_buf_reset(&ls->sb);  /* Don't waste space for comments. */
       break;
-    default:
-      lex_savenext(ls);
+    default: {
+      const char *q = lex_spanstop(ls->p, ls->pe, ']', ']');
+      if (tv) lex_savespan(ls, q); else lex_skipspan(ls, q);
       break;
+      }
     }
   } endloop:
   if (tv) {
@@ -272,7 +373,7 @@ static void lex_string(LexState *ls, TValue *tv)
       continue;
       }
     default:
-      lex_savenext(ls);
+      lex_savespan(ls, lex_spanstop(ls->p, ls->pe, delim, '\\'));
       break;
     }
   }
@@ -296,7 +397,7 @@ static LexToken lex_scan(LexState *ls, TValue *tv)
       }
       /* Identifier or reserved word. */
       do {
-	lex_savenext(ls);
+	lex_savespan(ls, lex_spanident(ls->p, ls->pe));
       } while (lj_char_isident(ls->c));
       s = lj_parse_keepstr(ls, sbufB(&ls->sb), sbuflen(&ls->sb));
       setstrV(ls->L, tv, s);
@@ -313,7 +414,7 @@ static LexToken lex_scan(LexState *ls, TValue *tv)
     case '\t':
     case '\v':
     case '\f':
-      lex_next(ls);
+      lex_skipspan(ls, lex_spanblank(ls->p, ls->pe));
       continue;
     case '-':
       lex_next(ls);
@@ -330,7 +431,7 @@ static LexToken lex_scan(LexState *ls, TValue *tv)
       }
       /* Short comment "--.*\n". */
       while (!lex_iseol(ls) && ls->c != LEX_EOF)
-	lex_next(ls);
+	lex_skipspan(ls, lex_spanstop(ls->p, ls->pe, '\n', '\n'));
       continue;
     case '[': {
       int sep = lex_skipeq(ls);
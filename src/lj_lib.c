@@ -48,7 +48,7 @@ static GCtab *lib_create_table(lua_State *L, const char *libname, int hsize)
 
 static const uint8_t *lib_read_lfunc(lua_State *L, const uint8_t *p, GCtab *tab)
 {
-  int len = *p++;
+  int len = *p & LIBINIT_LENMASK, uv = (*p++ & LIBINIT_LUAUV);
   GCstr *name = lj_str_new(L, (const char *)p, len);
   LexState ls;
   GCproto *pt;
@@ -63,8 +63,10 @@ static const uint8_t *lib_read_lfunc(lua_State *L, const uint8_t *p, GCtab *tab)
   pt = lj_bcread_proto(&ls);
   pt->firstline = ~(BCLine)0;
   fn = lj_func_newL_empty(L, pt, tabref(L->env));
-  /* NOBARRIER: See below for common barrier. */
-  setfuncV(L, lj_tab_setstr(L, tab, name), fn);
+  if (uv)  /* Upvalue for the next C function. */
+    setfuncV(L, L->top++, fn);
+  else  /* NOBARRIER: See below for common barrier. */
+    setfuncV(L, lj_tab_setstr(L, tab, name), fn);
   return (const uint8_t *)ls.p;
 }
 
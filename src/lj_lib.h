@@ -91,6 +91,16 @@ LJ_FUNC void lj_lib_prereg(lua_State *L, const char *name, lua_CFunction f,
 LJ_FUNC int lj_lib_postreg(lua_State *L, lua_CFunction cf, int id,
 			   const char *name);
 
+#if LJ_HASJIT
+/* I/O library helpers for the JIT compiler. */
+LJ_FUNC GCstr *lj_lib_io_readline(lua_State *L, GCudata *ud, int32_t chop);
+LJ_FUNC GCstr *lj_lib_io_iterline(lua_State *L, GCfunc *fn);
+LJ_FUNC int32_t lj_lib_io_writebuf(SBuf *sb, void *fp);
+#if LJ_HASFFI
+LJ_FUNC int32_t lj_lib_io_readinto(GCudata *ud, void *p, int32_t len);
+#endif
+#endif
+
 /* Library init data tags. */
 #define LIBINIT_LENMASK	0x3f
 #define LIBINIT_TAGMASK	0xc0
@@ -100,6 +110,7 @@ LJ_FUNC int lj_lib_postreg(lua_State *L, lua_CFunction cf, int id,
 #define LIBINIT_STRING	0xc0
 #define LIBINIT_MAXSTR	0x38
 #define LIBINIT_LUA	0xf9
+#define LIBINIT_LUAUV	0x40	/* Name tag of unregistered Lua functions. */
 #define LIBINIT_SET	0xfa
 #define LIBINIT_NUMBER	0xfb
 #define LIBINIT_COPY	0xfc
@@ -23,6 +23,12 @@
 #include "lj_bcdump.h"
 #include "lj_parse.h"
 
+#if LJ_TARGET_POSIX
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 /* -- Load Lua source code and bytecode ----------------------------------- */
 
 static TValue *cpparser(lua_State *L, lua_CFunction dummy, void *ud)
@@ -45,8 +51,8 @@ static TValue *cpparser(lua_State *L, lua_CFunction dummy, void *ud)
   return NULL;
 }
 
-LUA_API int lua_loadx(lua_State *L, lua_Reader reader, void *data,
-		      const char *chunkname, const char *mode)
+static int load_reader(lua_State *L, lua_Reader reader, void *data,
+		       const char *chunkname, const char *mode, int lazy)
 {
   LexState ls;
   int status;
@@ -54,6 +60,7 @@ LUA_API int lua_loadx(lua_State *L, lua_Reader reader, void *data,
   ls.rdata = data;
   ls.chunkarg = chunkname ? chunkname : "?";
   ls.mode = mode;
+  ls.lazy = lazy;
   lj_buf_init(L, &ls.sb);
   status = lj_vm_cpcall(L, NULL, &ls, cpparser);
   lj_lex_cleanup(L, &ls);
@@ -61,6 +68,43 @@ LUA_API int lua_loadx(lua_State *L, lua_Reader reader, void *data,
   return status;
 }
 
+static TValue *cpdata(lua_State *L, lua_CFunction dummy, void *ud)
+{
+  LexState *ls = (LexState *)ud;
+  UNUSED(dummy);
+  cframe_errfunc(L->cframe) = -1;  /* Inherit error function. */
+  if (lj_lex_setup(L, ls)) {  /* Bytecode can't be loaded as data. */
+    setstrV(L, L->top++, lj_err_str(L, LJ_ERR_XMODE));
+    lj_err_throw(L, LUA_ERRSYNTAX);
+  }
+  lj_parse_data(ls);
+  return NULL;
+}
+
+/* Load a data chunk and push its value instead of a function. */
+LUA_API int luaJIT_loaddata(lua_State *L, lua_Reader reader, void *data,
+			    const char *chunkname)
+{
+  LexState ls;
+  int status;
+  ls.rfunc = reader;
+  ls.rdata = data;
+  ls.chunkarg = chunkname ? chunkname : "?";
+  ls.mode = NULL;
+  ls.lazy = 0;
+  lj_buf_init(L, &ls.sb);
+  status = lj_vm_cpcall(L, NULL, &ls, cpdata);
+  lj_lex_cleanup(L, &ls);
+  lj_gc_check(L);
+  return status;
+}
+
+LUA_API int lua_loadx(lua_State *L, lua_Reader reader, void *data,
+		      const char *chunkname, const char *mode)
+{
+  return load_reader(L, reader, data, chunkname, mode, 0);
+}
+
 LUA_API int lua_load(lua_State *L, lua_Reader reader, void *data,
 		     const char *chunkname)
 {
@@ -81,6 +125,66 @@ static const char *reader_file(lua_State *L, void *ud, size_t *size)
   return *size > 0 ? ctx->buf : NULL;
 }
 
+#if LJ_TARGET_POSIX
+
+/* Min. size of a bytecode file to be read in a single chunk. */
+#define LOAD_WHOLE_MIN	(16*LUAL_BUFFERSIZE)
+
+typedef struct WholeReaderCtx {
+  const char *p;
+  size_t size;
+} WholeReaderCtx;
+
+static const char *reader_whole(lua_State *L, void *ud, size_t *size)
+{
+  WholeReaderCtx *ctx = (WholeReaderCtx *)ud;
+  UNUSED(L);
+  if (ctx->size == 0) return NULL;
+  *size = ctx->size;
+  ctx->size = 0;
+  return ctx->p;
+}
+
+/*
+** Large bytecode dumps (e.g. precompiled bundles) are read with a single
+** fread() and passed to the bytecode reader as one chunk. This way
+** bcread_fill() never has to glue the chunks of the huge prototypes
+** together in the lexer buffer. Child prototypes of dumps loaded this way
+** are only copied as raw records and materialized on the first closure
+** creation. The file isn't mapped: a concurrent truncation just gives a
+** short read instead of SIGBUS. Source code is read in chunks as usual.
+** Return -1, if the file isn't a large bytecode dump.
+*/
+static int load_whole(lua_State *L, FILE *fp, const char *chunkname,
+		      const char *mode)
+{
+  global_State *g = G(L);
+  struct stat st;
+  WholeReaderCtx ctx;
+  unsigned char head[3];
+  char *p;
+  size_t sz;
+  int status;
+  if (fstat(fileno(fp), &st) != 0 || !S_ISREG(st.st_mode) ||
+      st.st_size < LOAD_WHOLE_MIN || (uint64_t)st.st_size > LJ_MAX_MEM)
+    return -1;
+  /* Check the header without touching the position of the FILE. */
+  if (pread(fileno(fp), head, 3, 0) != 3 || head[0] != BCDUMP_HEAD1 ||
+      head[1] != BCDUMP_HEAD2 || head[2] != BCDUMP_HEAD3)
+    return -1;
+  sz = (size_t)st.st_size;
+  p = (char *)g->allocf(g->allocd, NULL, 0, sz);
+  if (p == NULL)
+    return -1;
+  ctx.p = p;
+  ctx.size = fread(p, 1, sz, fp);
+  status = load_reader(L, reader_whole, &ctx, chunkname, mode, 1);
+  g->allocf(g->allocd, p, sz, 0);
+  return status;
+}
+
+#endif
+
 LUALIB_API int luaL_loadfilex(lua_State *L, const char *filename,
 			      const char *mode)
 {
@@ -98,7 +202,13 @@ LUALIB_API int luaL_loadfilex(lua_State *L, const char *filename,
     ctx.fp = stdin;
     chunkname = "=stdin";
   }
-  status = lua_loadx(L, reader_file, &ctx, chunkname, mode);
+  status = -1;
+#if LJ_TARGET_POSIX
+  if (filename)
+    status = load_whole(L, ctx.fp, chunkname, mode);
+#endif
+  if (status < 0)
+    status = lua_loadx(L, reader_file, &ctx, chunkname, mode);
   if (ferror(ctx.fp)) {
     L->top -= filename ? 2 : 1;
     lua_pushfstring(L, "cannot read %s: %s", chunkname+1, strerror(errno));
@@ -36,8 +36,12 @@ LUAMISC_API void luaM_metrics(lua_State *L, struct luam_Metrics *metrics)
   metrics->gc_udatanum = gc->udatanum;
 #if LJ_HASFFI
   metrics->gc_cdatanum = gc->cdatanum;
+  metrics->gc_cdatapool_hit = g->cdpool_hit;
+  metrics->gc_cdatapool_miss = g->cdpool_miss;
 #else
   metrics->gc_cdatanum = 0;
+  metrics->gc_cdatapool_hit = 0;
+  metrics->gc_cdatapool_miss = 0;
 #endif
 
   metrics->gc_total = gc->total;
@@ -56,10 +60,12 @@ LUAMISC_API void luaM_metrics(lua_State *L, struct luam_Metrics *metrics)
   metrics->jit_trace_abort = J->ntraceabort;
   metrics->jit_mcode_size = J->szallmcarea;
   metrics->jit_trace_num = J->tracenum;
+  metrics->jit_hotcount_collisions = J->nhotcollide;
 #else
   metrics->jit_snap_restore = 0;
   metrics->jit_trace_abort = 0;
   metrics->jit_mcode_size = 0;
   metrics->jit_trace_num = 0;
+  metrics->jit_hotcount_collisions = 0;
 #endif
 }
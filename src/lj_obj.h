@@ -401,6 +401,9 @@ typedef struct GCproto {
 #define PROTO_CLC_BITS		3
 #define PROTO_CLC_POLY		(3*PROTO_CLCOUNT)  /* Polymorphic threshold. */
 
+/* Stub of the prototype to be loaded on demand (see lj_bcread.c). */
+#define proto_islazy(pt)	((pt)->sizebc == 0)
+
 #define PROTO_UV_LOCAL		0x8000	/* Upvalue for local slot. */
 #define PROTO_UV_IMMUTABLE	0x4000	/* Immutable upvalue. */
 
@@ -490,7 +493,10 @@ LJ_STATIC_ASSERT(offsetof(Node, val) == 0);
 typedef struct GCtab {
   GCHeader;
   uint8_t nomm;		/* Negative cache for fast metamethods. */
-  int8_t colo;		/* Array colocation. */
+  int8_t colo;		/* Array and hash part colocation. */
+#if LJ_GC64
+  MSize lenhint;	/* Last border found by lj_tab_len(). Fills padding. */
+#endif
   MRef array;		/* Array part. */
   GCRef gclist;
   GCRef metatable;	/* Must be at same offset in GCudata. */
@@ -502,7 +508,14 @@ typedef struct GCtab {
 #endif
 } GCtab;
 
+/* Layout of t->colo. */
+#define TAB_COLO_AMASK	0x1f	/* Size of colocated array part. */
+#define TAB_COLO_HSHIFT	5	/* Hash bits of colocated hash part. */
+#define TAB_COLO_ASEP	0x80	/* Colocated array part has been separated. */
+
 #define sizetabcolo(n)	((n)*sizeof(TValue) + sizeof(GCtab))
+#define tabcoloa(t)	((uint32_t)(uint8_t)(t)->colo & TAB_COLO_AMASK)
+#define tabcoloh(t)	(((uint32_t)(uint8_t)(t)->colo >> TAB_COLO_HSHIFT) & 3)
 #define tabref(r)	(&gcref((r))->tab)
 #define noderef(r)	(mref((r), Node))
 #define nextnode(n)	(mref((n)->next, Node))
@@ -674,6 +687,14 @@ typedef struct global_State {
   MRef jit_base;	/* Current JIT code L->base or NULL. */
   MRef ctype_state;	/* Pointer to C type state. */
   GCRef gcroot[GCROOT_MAX];  /* GC roots. */
+  GCRef thpool;		/* Free list of recycled threads (linked by nextgc). */
+  MSize thpoolnum;	/* Number of threads in the free list. */
+#if LJ_HASFFI
+  GCRef cdpool[LJ_MAX_CDPOOLSZ+1];  /* Free lists of small cdata by size. */
+  MSize cdpoolnum[LJ_MAX_CDPOOLSZ+1];  /* Number of cdata in free lists. */
+  size_t cdpool_hit;	/* Small cdata allocations served by the pool. */
+  size_t cdpool_miss;	/* Small cdata allocations from the allocator. */
+#endif
 } global_State;
 
 #define mainthread(g)	(&gcref(g->mainthref)->th)
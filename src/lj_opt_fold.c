@@ -889,9 +889,13 @@ LJFOLDF(kfold_strto)
 
 /* -- Constant folding of equality checks --------------------------------- */
 
-/* Don't constant-fold away FLOAD checks against KNULL. */
+/* Don't constant-fold away FLOAD or call result checks against KNULL. */
 LJFOLD(EQ FLOAD KNULL)
 LJFOLD(NE FLOAD KNULL)
+LJFOLD(EQ CALLS KNULL)
+LJFOLD(NE CALLS KNULL)
+LJFOLD(EQ CALLA KNULL)
+LJFOLD(NE CALLA KNULL)
 LJFOLDX(lj_opt_cse)
 
 /* But fold all other KNULL compares, since only KNULL is equal to KNULL. */
@@ -108,7 +108,7 @@ static void sink_mark_ins(jit_State *J)
 #if LJ_HASFFI
     case IR_CALLXS:
 #endif
-    case IR_CALLS:
+    case IR_CALLS: case IR_CALLA:  /* Also marks tables read by the call. */
       irt_setmark(IR(ir->op1)->t);  /* Mark (potentially) stored values. */
       break;
     case IR_PHI: {
@@ -2736,3 +2736,172 @@ GCproto *lj_parse(LexState *ls)
   return pt;
 }
 
+
+/* -- Data parser --------------------------------------------------------- */
+
+/*
+** A data chunk consists of a single (optionally returned) literal: nil,
+** a boolean, a number, a string or a table constructor with literal keys
+** and values. The tables are built directly while parsing, so no bytecode,
+** constants or prototypes are created.
+**
+** The fields of all open constructors are collected as key/value pairs in
+** the array part of a scratch table, which also anchors them for the GC.
+** Once a constructor is closed, its table is allocated with the exact
+** number of array and hash slots and filled from the scratch slots.
+*/
+
+#define DATA_SCRATCH_MIN	64	/* Initial number of scratch slots. */
+#define DATA_KEEP_MAX		1024	/* Max. tokens between anchor flushes. */
+
+/* Data parser state. */
+typedef struct DataState {
+  GCtab *scratch;	/* Key/value pairs of open constructors. */
+  MSize top;		/* Top of scratch slots. */
+  MSize nkeep;		/* Number of tokens since the last anchor flush. */
+} DataState;
+
+/* Push value to the scratch slots. */
+static void data_push(LexState *ls, DataState *ds, cTValue *o)
+{
+  lua_State *L = ls->L;
+  GCtab *t = ds->scratch;
+  if (LJ_UNLIKELY(++ds->top >= t->asize))
+    lj_tab_reasize(L, t, t->asize << 1);
+  copyTV(L, arrayslot(t, ds->top), o);
+  lj_gc_anybarriert(L, t);
+}
+
+/* Push value of the current token and get the next one. */
+static void data_token(LexState *ls, DataState *ds)
+{
+  data_push(ls, ds, &ls->tokval);
+  if (++ds->nkeep >= DATA_KEEP_MAX) {  /* Only the next token needs one. */
+    lj_tab_clear(ls->fs->kt);
+    ds->nkeep = 0;
+  }
+  lj_lex_next(ls);
+}
+
+static void data_table(LexState *ls, DataState *ds);
+
+/* Parse a literal value and push it. */
+static void data_value(LexState *ls, DataState *ds)
+{
+  TValue tv;
+  switch (ls->tok) {
+  case TK_nil: setnilV(&tv); break;
+  case TK_false: setboolV(&tv, 0); break;
+  case TK_true: setboolV(&tv, 1); break;
+  case TK_string: case TK_number: data_token(ls, ds); return;
+  case '{': data_table(ls, ds); return;
+  case '-': {
+    TValue *o = &ls->tokval;
+    lj_lex_next(ls);
+    if (ls->tok != TK_number || !tvisnumber(o))
+      err_syntax(ls, LJ_ERR_XSYMBOL);
+    if (tvisint(o)) {
+      int32_t k = intV(o);
+      if (k == -k)
+	setnumV(o, -(lua_Number)k);
+      else
+	setintV(o, -k);
+    } else {
+      o->u64 ^= U64x(80000000,00000000);
+    }
+    data_token(ls, ds);
+    return;
+    }
+  default:
+    err_syntax(ls, LJ_ERR_XSYMBOL);
+    break;
+  }
+  data_push(ls, ds, &tv);
+  lj_lex_next(ls);
+}
+
+/* Parse a table constructor and push the table. */
+static void data_table(LexState *ls, DataState *ds)
+{
+  lua_State *L = ls->L;
+  BCLine line = ls->linenumber;
+  MSize base = ds->top, i;
+  int32_t narr = 0, nhash = 0;
+  GCtab *t;
+  TValue tv;
+  synlevel_begin(ls);
+  lex_check(ls, '{');
+  while (ls->tok != '}') {
+    if (ls->tok == '[') {
+      cTValue *k;
+      lj_lex_next(ls);
+      data_value(ls, ds);
+      k = arrayslot(ds->scratch, ds->top);
+      if (tvisnil(k))
+	lj_lex_error(ls, 0, LJ_ERR_NILIDX);
+      else if (tvisnum(k) && tvisnan(k))
+	lj_lex_error(ls, 0, LJ_ERR_NANIDX);
+      lex_check(ls, ']');
+      lex_check(ls, '=');
+      nhash++;
+    } else if (ls->tok == TK_name) {
+      data_token(ls, ds);
+      lex_check(ls, '=');
+      nhash++;
+    } else {
+      setintV(&tv, ++narr);
+      data_push(ls, ds, &tv);
+    }
+    data_value(ls, ds);
+    if (!lex_opt(ls, ',') && !lex_opt(ls, ';')) break;
+  }
+  lex_match(ls, '}', '{', line);
+  synlevel_end(ls);
+  t = lj_tab_new_ah(L, narr, nhash);
+  for (i = base+1; i < ds->top; i += 2) {
+    cTValue *k = arrayslot(ds->scratch, i), *v = k+1;
+    if (!tvisnil(v)) {
+      copyTV(L, lj_tab_set(L, t, k), v);
+    } else {  /* Only clear an existing key. */
+      cTValue *o = lj_tab_get(L, t, k);
+      if (!tvisnil(o)) setnilV((TValue *)o);
+    }
+  }
+  ds->top = base;
+  settabV(L, &tv, t);
+  data_push(ls, ds, &tv);
+}
+
+/* Entry point of data parser. Pushes the value of the chunk. */
+void lj_parse_data(LexState *ls)
+{
+  FuncState fs;
+  DataState ds;
+  lua_State *L = ls->L;
+#ifdef LUAJIT_DISABLE_DEBUGINFO
+  ls->chunkname = lj_str_newlit(L, "=");
+#else
+  ls->chunkname = lj_str_newz(L, ls->chunkarg);
+#endif
+  setstrV(L, L->top, ls->chunkname);  /* Anchor chunkname string. */
+  incr_top(L);
+  ls->level = 0;
+  ls->fs = &fs;  /* Only the constant table is used by the lexer. */
+  fs.kt = lj_tab_new(L, 0, 0);
+  settabV(L, L->top, fs.kt);
+  incr_top(L);
+  ds.scratch = lj_tab_new(L, DATA_SCRATCH_MIN, 0);
+  ds.top = ds.nkeep = 0;
+  settabV(L, L->top, ds.scratch);
+  incr_top(L);
+  lj_lex_next(ls);  /* Read-ahead first token. */
+  lex_opt(ls, TK_return);
+  data_value(ls, &ds);
+  lex_opt(ls, ';');
+  if (ls->tok != TK_eof)
+    err_token(ls, TK_eof);
+  ls->fs = NULL;
+  L->top -= 3;  /* Drop chunkname and anchors. */
+  copyTV(L, L->top, arrayslot(ds.scratch, 1));
+  incr_top(L);
+}
@@ -673,7 +673,7 @@ static TRef rec_call_specialize(jit_State *J, GCfunc *fn, TRef tr)
     switch (fn->c.ffid) {
     case FF_coroutine_wrap_aux:
     case FF_string_gmatch_aux:
-      /* NYI: io_file_iter doesn't have an ffid, yet. */
+    case FF_io_file_iter:
       {  /* Specialize to the ffid. */
 	TRef trid = emitir(IRT(IR_FLOAD, IRT_U8), tr, IRFL_FUNC_FFID);
 	emitir(IRTG(IR_EQ, IRT_INT), trid, lj_ir_kint(J, fn->c.ffid));
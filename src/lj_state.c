@@ -21,6 +21,7 @@
 #include "lj_frame.h"
 #if LJ_HASFFI
 #include "lj_ctype.h"
+#include "lj_cdata.h"
 #endif
 #include "lj_trace.h"
 #include "lj_dispatch.h"
@@ -136,11 +137,16 @@ void LJ_FASTCALL lj_state_growstack1(lua_State *L)
   lj_state_growstack(L, 1);
 }
 
-/* Allocate basic stack for new state. */
+/* Allocate basic stack for new state or reset the recycled one. */
 static void stack_init(lua_State *L1, lua_State *L)
 {
-  TValue *stend, *st = lj_mem_newvec(L, LJ_STACK_START+LJ_STACK_EXTRA, TValue);
-  setmref(L1->stack, st);
+  TValue *stend, *st = tvref(L1->stack);
+  if (st == NULL) {
+    st = lj_mem_newvec(L, LJ_STACK_START+LJ_STACK_EXTRA, TValue);
+    setmref(L1->stack, st);
+  }
+  lua_assert(L1->stacksize == 0 ||
+	     L1->stacksize == LJ_STACK_START + LJ_STACK_EXTRA);
   L1->stacksize = LJ_STACK_START + LJ_STACK_EXTRA;
   stend = st + L1->stacksize;
   setmref(L1->maxstack, stend - LJ_STACK_EXTRA - 1);
@@ -151,8 +157,6 @@ static void stack_init(lua_State *L1, lua_State *L)
     setnilV(st++);
 }
 
-/* -- State handling ------------------------------------------------------ */
-
 /* Open parts that may cause memory-allocation errors. */
 static TValue *cpluaopen(lua_State *L, lua_CFunction dummy, void *ud)
 {
@@ -172,15 +176,85 @@ static TValue *cpluaopen(lua_State *L, lua_CFunction dummy, void *ud)
   return NULL;
 }
 
+/* -- Thread pool --------------------------------------------------------- */
+
+/*
+** Dead coroutines are not released to the allocator right away. Instead
+** the lua_State object together with its stack is put to the bounded free
+** list in global_State, so the next coroutine.create() only has to pop it
+** and reinitialize a few fields. Stacks grown beyond the starting size are
+** released, since otherwise a single deep recursion would pin the memory.
+** Pooled threads are accounted as freed and reused ones as allocated, so
+** gc.allocated and gc.freed match the coroutines created by Lua code.
+** Only the memory profiler, which hooks the allocator, sees a pooled
+** thread as allocated until the pool releases it.
+*/
+
+/* Memory held by a pooled thread. */
+#define thpool_size(L)	(sizeof(lua_State) + (L)->stacksize*sizeof(TValue))
+
+/* Put the dead thread to the free list or release it. */
+static void thpool_put(global_State *g, lua_State *L)
+{
+  if (L->stacksize != LJ_STACK_START + LJ_STACK_EXTRA) {
+    lj_mem_freevec(g, tvref(L->stack), L->stacksize, TValue);
+    setmref(L->stack, NULL);
+    L->stacksize = 0;
+  }
+  if (g->thpoolnum < LJ_MAX_THPOOL) {
+    setgcrefr(L->nextgc, g->thpool);
+    setgcref(g->thpool, obj2gco(L));
+    g->thpoolnum++;
+    g->gc.freed += thpool_size(L);
+  } else {
+    if (L->stacksize)
+      lj_mem_freevec(g, tvref(L->stack), L->stacksize, TValue);
+    lj_mem_freet(g, L);
+  }
+}
+
+/* Get the thread from the free list and link it to the root set. */
+static lua_State *thpool_get(global_State *g)
+{
+  lua_State *L = &gcref(g->thpool)->th;
+  lua_assert(g->thpoolnum > 0);
+  setgcrefr(g->thpool, L->nextgc);
+  g->thpoolnum--;
+  g->gc.allocated += thpool_size(L);
+  setgcrefr(L->nextgc, g->gc.root);
+  setgcref(g->gc.root, obj2gco(L));
+  newwhite(g, L);
+  return L;
+}
+
+/* Release all threads in the free list. */
+static void thpool_free(global_State *g)
+{
+  while (gcref(g->thpool) != NULL) {
+    lua_State *L = &gcref(g->thpool)->th;
+    setgcrefr(g->thpool, L->nextgc);
+    /* Already accounted as freed when put into the free list. */
+    g->gc.total -= (GCSize)thpool_size(L);
+    if (L->stacksize)
+      g->allocf(g->allocd, tvref(L->stack), L->stacksize*sizeof(TValue), 0);
+    g->allocf(g->allocd, L, sizeof(lua_State), 0);
+  }
+  g->thpoolnum = 0;
+}
+
+/* -- State handling ------------------------------------------------------ */
+
 static void close_state(lua_State *L)
 {
   global_State *g = G(L);
   lj_func_closeuv(L, tvref(L->stack));
   lj_gc_freeall(g);
+  thpool_free(g);
   lua_assert(gcref(g->gc.root) == obj2gco(L));
   lua_assert(g->strnum == 0);
   lj_trace_freestate(g);
 #if LJ_HASFFI
+  lj_cdata_freepool(g);
   lj_ctype_freestate(g);
 #endif
   lj_mem_freevec(g, g->strhash, g->strmask+1, GCRef);
@@ -295,12 +369,18 @@ LUA_API void lua_close(lua_State *L)
 
 lua_State *lj_state_new(lua_State *L)
 {
-  lua_State *L1 = lj_mem_newobj(L, lua_State);
+  global_State *g = G(L);
+  lua_State *L1;
+  if (gcref(g->thpool) != NULL) {
+    L1 = thpool_get(g);
+  } else {
+    L1 = lj_mem_newobj(L, lua_State);
+    L1->stacksize = 0;
+    setmref(L1->stack, NULL);
+  }
   L1->gct = ~LJ_TTHREAD;
   L1->dummy_ffid = FF_C;
   L1->status = LUA_OK;
-  L1->stacksize = 0;
-  setmref(L1->stack, NULL);
   L1->cframe = NULL;
   /* NOBARRIER: The lua_State is new (marked white). */
   setgcrefnull(L1->openupval);
@@ -318,7 +398,6 @@ void LJ_FASTCALL lj_state_free(global_State *g, lua_State *L)
     setgcrefnull(g->cur_L);
   lj_func_closeuv(L, tvref(L->stack));
   lua_assert(gcref(L->openupval) == NULL);
-  lj_mem_freevec(g, tvref(L->stack), L->stacksize, TValue);
-  lj_mem_freet(g, L);
+  thpool_put(g, L);
 }
 
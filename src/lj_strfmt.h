@@ -31,6 +31,7 @@ typedef enum FormatType {
 #define STRFMT_T_FP_E	0x0010	/* STRFMT_NUM */
 #define STRFMT_T_FP_F	0x0020	/* STRFMT_NUM */
 #define STRFMT_T_FP_G	0x0030	/* STRFMT_NUM */
+#define STRFMT_T_FP_R	0x0040	/* STRFMT_NUM, shortest round-trip */
 #define STRFMT_T_QUOTED	0x0010	/* STRFMT_STR */
 
 /* Format flags. */
@@ -61,17 +62,49 @@ typedef enum FormatType {
 #define STRFMT_O	(STRFMT_UINT|STRFMT_T_OCT)
 #define STRFMT_P	(STRFMT_PTR)
 #define STRFMT_Q	(STRFMT_STR|STRFMT_T_QUOTED)
+#define STRFMT_R	(STRFMT_NUM|STRFMT_T_FP_R)
 #define STRFMT_S	(STRFMT_STR)
 #define STRFMT_U	(STRFMT_UINT)
 #define STRFMT_X	(STRFMT_UINT|STRFMT_T_HEX)
 #define STRFMT_G14	(STRFMT_G | ((14+1) << STRFMT_SH_PREC))
 
+/* Format for number to string conversions. */
+#if LUAJIT_NUMFMT_SHORTEST
+#define STRFMT_NUMDEF	STRFMT_R
+#else
+#define STRFMT_NUMDEF	STRFMT_G14
+#endif
+
 /* Maximum buffer sizes for conversions. */
 #define STRFMT_MAXBUF_XINT	(1+22)  /* '0' prefix + uint64_t in octal. */
 #define STRFMT_MAXBUF_INT	(1+10)  /* Sign + int32_t in decimal. */
-#define STRFMT_MAXBUF_NUM	32  /* Must correspond with STRFMT_G14. */
+#define STRFMT_MAXBUF_NUM	32  /* Must correspond with STRFMT_NUMDEF. */
 #define STRFMT_MAXBUF_PTR	(2+2*sizeof(ptrdiff_t))  /* "0x" + hex ptr. */
 
+/* 128 bit approximations of powers of ten. */
+#define STRFMT_POW10_KMIN	(-292)
+#define STRFMT_POW10_KMAX	324
+#define STRFMT_POW10_N		(STRFMT_POW10_KMAX-STRFMT_POW10_KMIN+1)
+
+LJ_DATA const uint64_t lj_strfmt_pow10[2*STRFMT_POW10_N];
+
+/* Multiply two 64 bit numbers. Returns the high half of the product. */
+static LJ_AINLINE uint64_t lj_strfmt_mul128(uint64_t a, uint64_t b,
+					    uint64_t *lo)
+{
+#if defined(__SIZEOF_INT128__)
+  unsigned __int128 r = (unsigned __int128)a * b;
+  *lo = (uint64_t)r;
+  return (uint64_t)(r >> 64);
+#else
+  uint64_t a0 = (uint32_t)a, a1 = a >> 32, b0 = (uint32_t)b, b1 = b >> 32;
+  uint64_t p00 = a0*b0, p01 = a0*b1, p10 = a1*b0, p11 = a1*b1;
+  uint64_t mid = (p00 >> 32) + (uint32_t)p01 + (uint32_t)p10;
+  *lo = (mid << 32) | (uint32_t)p00;
+  return p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+#endif
+}
+
 /* Format parser. */
 LJ_FUNC SFormat LJ_FASTCALL lj_strfmt_parse(FormatState *fs);
 
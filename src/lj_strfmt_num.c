@@ -263,6 +263,750 @@ static int nd_similar(uint32_t* nd, uint32_t ndhi, uint32_t* ref, MSize hilen,
   return !memcmp(nd9, ref9, prec) && (nd9[prec] < '5') == (ref9[prec] < '5');
 }
 
+/* -- Shortest round-trip conversion -------------------------------------- */
+
+/*
+** This is the Schubfach algorithm by Raffaello Giulietti. It finds the
+** shortest decimal s*10^k which rounds back to the same double. Unlike
+** the "nd" conversion above, it needs only three 64x128 bit multiplies.
+*/
+
+/*
+** 128 bit approximations g of 10^k for k in range STRFMT_POW10_KMIN
+** through STRFMT_POW10_KMAX, i.e. ceil(10^k * 2^-e), where e is chosen
+** such that 2^127 <= g < 2^128. Also used by lj_strscan.c.
+*/
+LJ_DATADEF const uint64_t lj_strfmt_pow10[2*STRFMT_POW10_N] = {
+  U64x(ff77b1fc,bebcdc4f), U64x(25e8e89c,13bb0f7b),
+  U64x(9faacf3d,f73609b1), U64x(77b19161,8c54e9ad),
+  U64x(c795830d,75038c1d), U64x(d59df5b9,ef6a2418),
+  U64x(f97ae3d0,d2446f25), U64x(4b057328,6b44ad1e),
+  U64x(9becce62,836ac577), U64x(4ee367f9,430aec33),
+  U64x(c2e801fb,244576d5), U64x(229c41f7,93cda740),
+  U64x(f3a20279,ed56d48a), U64x(6b435275,78c11110),
+  U64x(9845418c,345644d6), U64x(830a1389,6b78aaaa),
+  U64x(be5691ef,416bd60c), U64x(23cc986b,c656d554),
+  U64x(edec366b,11c6cb8f), U64x(2cbfbe86,b7ec8aa9),
+  U64x(94b3a202,eb1c3f39), U64x(7bf7d714,32f3d6aa),
+  U64x(b9e08a83,a5e34f07), U64x(daf5ccd9,3fb0cc54),
+  U64x(e858ad24,8f5c22c9), U64x(d1b3400f,8f9cff69),
+  U64x(91376c36,d99995be), U64x(23100809,b9c21fa2),
+  U64x(b5854744,8ffffb2d), U64x(abd40a0c,2832a78b),
+  U64x(e2e69915,b3fff9f9), U64x(16c90c8f,323f516d),
+  U64x(8dd01fad,907ffc3b), U64x(ae3da7d9,7f6792e4),
+  U64x(b1442798,f49ffb4a), U64x(99cd11cf,df41779d),
+  U64x(dd95317f,31c7fa1d), U64x(40405643,d711d584),
+  U64x(8a7d3eef,7f1cfc52), U64x(482835ea,666b2573),
+  U64x(ad1c8eab,5ee43b66), U64x(da324365,0005eed0),
+  U64x(d863b256,369d4a40), U64x(90bed43e,40076a83),
+  U64x(873e4f75,e2224e68), U64x(5a7744a6,e804a292),
+  U64x(a90de353,5aaae202), U64x(711515d0,a205cb37),
+  U64x(d3515c28,31559a83), U64x(0d5a5b44,ca873e04),
+  U64x(8412d999,1ed58091), U64x(e858790a,fe9486c3),
+  U64x(a5178fff,668ae0b6), U64x(626e974d,be39a873),
+  U64x(ce5d73ff,402d98e3), U64x(fb0a3d21,2dc81290),
+  U64x(80fa687f,881c7f8e), U64x(7ce66634,bc9d0b9a),
+  U64x(a139029f,6a239f72), U64x(1c1fffc1,ebc44e81),
+  U64x(c9874347,44ac874e), U64x(a327ffb2,66b56221),
+  U64x(fbe91419,15d7a922), U64x(4bf1ff9f,0062baa9),
+  U64x(9d71ac8f,ada6c9b5), U64x(6f773fc3,603db4aa),
+  U64x(c4ce17b3,99107c22), U64x(cb550fb4,384d21d4),
+  U64x(f6019da0,7f549b2b), U64x(7e2a53a1,46606a49),
+  U64x(99c10284,4f94e0fb), U64x(2eda7444,cbfc426e),
+  U64x(c0314325,637a1939), U64x(fa911155,fefb5309),
+  U64x(f03d93ee,bc589f88), U64x(793555ab,7eba27cb),
+  U64x(96267c75,35b763b5), U64x(4bc1558b,2f3458df),
+  U64x(bbb01b92,83253ca2), U64x(9eb1aaed,fb016f17),
+  U64x(ea9c2277,23ee8bcb), U64x(465e15a9,79c1cadd),
+  U64x(92a1958a,7675175f), U64x(0bfacd89,ec191eca),
+  U64x(b749faed,14125d36), U64x(cef980ec,671f667c),
+  U64x(e51c79a8,5916f484), U64x(82b7e127,80e7401b),
+  U64x(8f31cc09,37ae58d2), U64x(d1b2ecb8,b0908811),
+  U64x(b2fe3f0b,8599ef07), U64x(861fa7e6,dcb4aa16),
+  U64x(dfbdcece,67006ac9), U64x(67a791e0,93e1d49b),
+  U64x(8bd6a141,006042bd), U64x(e0c8bb2c,5c6d24e1),
+  U64x(aecc4991,4078536d), U64x(58fae9f7,73886e19),
+  U64x(da7f5bf5,90966848), U64x(af39a475,506a899f),
+  U64x(888f9979,7a5e012d), U64x(6d8406c9,52429604),
+  U64x(aab37fd7,d8f58178), U64x(c8e5087b,a6d33b84),
+  U64x(d5605fcd,cf32e1d6), U64x(fb1e4a9a,90880a65),
+  U64x(855c3be0,a17fcd26), U64x(5cf2eea0,9a550680),
+  U64x(a6b34ad8,c9dfc06f), U64x(f42faa48,c0ea481f),
+  U64x(d0601d8e,fc57b08b), U64x(f13b94da,f124da27),
+  U64x(823c1279,5db6ce57), U64x(76c53d08,d6b70859),
+  U64x(a2cb1717,b52481ed), U64x(54768c4b,0c64ca6f),
+  U64x(cb7ddcdd,a26da268), U64x(a9942f5d,cf7dfd0a),
+  U64x(fe5d5415,0b090b02), U64x(d3f93b35,435d7c4d),
+  U64x(9efa548d,26e5a6e1), U64x(c47bc501,4a1a6db0),
+  U64x(c6b8e9b0,709f109a), U64x(359ab641,9ca1091c),
+  U64x(f867241c,8cc6d4c0), U64x(c30163d2,03c94b63),
+  U64x(9b407691,d7fc44f8), U64x(79e0de63,425dcf1e),
+  U64x(c2109436,4dfb5636), U64x(985915fc,12f542e5),
+  U64x(f294b943,e17a2bc4), U64x(3e6f5b7b,17b2939e),
+  U64x(979cf3ca,6cec5b5a), U64x(a705992c,eecf9c43),
+  U64x(bd8430bd,08277231), U64x(50c6ff78,2a838354),
+  U64x(ece53cec,4a314ebd), U64x(a4f8bf56,35246429),
+  U64x(940f4613,ae5ed136), U64x(871b7795,e136be9a),
+  U64x(b9131798,99f68584), U64x(28e2557b,59846e40),
+  U64x(e757dd7e,c07426e5), U64x(331aeada,2fe589d0),
+  U64x(9096ea6f,3848984f), U64x(3ff0d2c8,5def7622),
+  U64x(b4bca50b,065abe63), U64x(0fed077a,756b53aa),
+  U64x(e1ebce4d,c7f16dfb), U64x(d3e84959,12c62895),
+  U64x(8d3360f0,9cf6e4bd), U64x(64712dd7,abbbd95d),
+  U64x(b080392c,c4349dec), U64x(bd8d794d,96aacfb4),
+  U64x(dca04777,f541c567), U64x(ecf0d7a0,fc5583a1),
+  U64x(89e42caa,f9491b60), U64x(f41686c4,9db57245),
+  U64x(ac5d37d5,b79b6239), U64x(311c2875,c522ced6),
+  U64x(d77485cb,25823ac7), U64x(7d633293,366b828c),
+  U64x(86a8d39e,f77164bc), U64x(ae5dff9c,02033198),
+  U64x(a8530886,b54dbdeb), U64x(d9f57f83,0283fdfd),
+  U64x(d267caa8,62a12d66), U64x(d072df63,c324fd7c),
+  U64x(8380dea9,3da4bc60), U64x(4247cb9e,59f71e6e),
+  U64x(a4611653,8d0deb78), U64x(52d9be85,f074e609),
+  U64x(cd795be8,70516656), U64x(67902e27,6c921f8c),
+  U64x(806bd971,4632dff6), U64x(00ba1cd8,a3db53b7),
+  U64x(a086cfcd,97bf97f3), U64x(80e8a40e,ccd228a5),
+  U64x(c8a883c0,fdaf7df0), U64x(6122cd12,8006b2ce),
+  U64x(fad2a4b1,3d1b5d6c), U64x(796b8057,20085f82),
+  U64x(9cc3a6ee,c6311a63), U64x(cbe33036,74053bb1),
+  U64x(c3f490aa,77bd60fc), U64x(bedbfc44,11068a9d),
+  U64x(f4f1b4d5,15acb93b), U64x(ee92fb55,15482d45),
+  U64x(99171105,2d8bf3c5), U64x(751bdd15,2d4d1c4b),
+  U64x(bf5cd546,78eef0b6), U64x(d262d45a,78a0635e),
+  U64x(ef340a98,172aace4), U64x(86fb8971,16c87c35),
+  U64x(9580869f,0e7aac0e), U64x(d45d35e6,ae3d4da1),
+  U64x(bae0a846,d2195712), U64x(89748360,59cca10a),
+  U64x(e998d258,869facd7), U64x(2bd1a438,703fc94c),
+  U64x(91ff8377,5423cc06), U64x(7b6306a3,4627ddd0),
+  U64x(b67f6455,292cbf08), U64x(1a3bc84c,17b1d543),
+  U64x(e41f3d6a,7377eeca), U64x(20caba5f,1d9e4a94),
+  U64x(8e938662,882af53e), U64x(547eb47b,7282ee9d),
+  U64x(b23867fb,2a35b28d), U64x(e99e619a,4f23aa44),
+  U64x(dec681f9,f4c31f31), U64x(6405fa00,e2ec94d5),
+  U64x(8b3c113c,38f9f37e), U64x(de83bc40,8dd3dd05),
+  U64x(ae0b158b,4738705e), U64x(9624ab50,b148d446),
+  U64x(d98ddaee,19068c76), U64x(3badd624,dd9b0958),
+  U64x(87f8a8d4,cfa417c9), U64x(e54ca5d7,0a80e5d7),
+  U64x(a9f6d30a,038d1dbc), U64x(5e9fcf4c,cd211f4d),
+  U64x(d47487cc,8470652b), U64x(7647c320,00696720),
+  U64x(84c8d4df,d2c63f3b), U64x(29ecd9f4,0041e074),
+  U64x(a5fb0a17,c777cf09), U64x(f4681071,00525891),
+  U64x(cf79cc9d,b955c2cc), U64x(7182148d,4066eeb5),
+  U64x(81ac1fe2,93d599bf), U64x(c6f14cd8,48405531),
+  U64x(a21727db,38cb002f), U64x(b8ada00e,5a506a7d),
+  U64x(ca9cf1d2,06fdc03b), U64x(a6d90811,f0e4851d),
+  U64x(fd442e46,88bd304a), U64x(908f4a16,6d1da664),
+  U64x(9e4a9cec,15763e2e), U64x(9a598e4e,043287ff),
+  U64x(c5dd4427,1ad3cdba), U64x(40eff1e1,853f29fe),
+  U64x(f7549530,e188c128), U64x(d12bee59,e68ef47d),
+  U64x(9a94dd3e,8cf578b9), U64x(82bb74f8,301958cf),
+  U64x(c13a148e,3032d6e7), U64x(e36a5236,3c1faf02),
+  U64x(f18899b1,bc3f8ca1), U64x(dc44e6c3,cb279ac2),
+  U64x(96f5600f,15a7b7e5), U64x(29ab103a,5ef8c0ba),
+  U64x(bcb2b812,db11a5de), U64x(7415d448,f6b6f0e8),
+  U64x(ebdf6617,91d60f56), U64x(111b495b,3464ad22),
+  U64x(936b9fce,bb25c995), U64x(cab10dd9,00beec35),
+  U64x(b84687c2,69ef3bfb), U64x(3d5d514f,40eea743),
+  U64x(e65829b3,046b0afa), U64x(0cb4a5a3,112a5113),
+  U64x(8ff71a0f,e2c2e6dc), U64x(47f0e785,eaba72ac),
+  U64x(b3f4e093,db73a093), U64x(59ed2167,65690f57),
+  U64x(e0f218b8,d25088b8), U64x(306869c1,3ec3532d),
+  U64x(8c974f73,83725573), U64x(1e414218,c73a13fc),
+  U64x(afbd2350,644eeacf), U64x(e5d1929e,f90898fb),
+  U64x(dbac6c24,7d62a583), U64x(df45f746,b74abf3a),
+  U64x(894bc396,ce5da772), U64x(6b8bba8c,328eb784),
+  U64x(ab9eb47c,81f5114f), U64x(066ea92f,3f326565),
+  U64x(d686619b,a27255a2), U64x(c80a537b,0efefebe),
+  U64x(8613fd01,45877585), U64x(bd06742c,e95f5f37),
+  U64x(a798fc41,96e952e7), U64x(2c481138,23b73705),
+  U64x(d17f3b51,fca3a7a0), U64x(f75a1586,2ca504c6),
+  U64x(82ef8513,3de648c4), U64x(9a984d73,dbe722fc),
+  U64x(a3ab6658,0d5fdaf5), U64x(c13e60d0,d2e0ebbb),
+  U64x(cc963fee,10b7d1b3), U64x(318df905,079926a9),
+  U64x(ffbbcfe9,94e5c61f), U64x(fdf17746,497f7053),
+  U64x(9fd561f1,fd0f9bd3), U64x(feb6ea8b,edefa634),
+  U64x(c7caba6e,7c5382c8), U64x(fe64a52e,e96b8fc1),
+  U64x(f9bd690a,1b68637b), U64x(3dfdce7a,a3c673b1),
+  U64x(9c1661a6,51213e2d), U64x(06bea10c,a65c084f),
+  U64x(c31bfa0f,e5698db8), U64x(486e494f,cff30a63),
+  U64x(f3e2f893,dec3f126), U64x(5a89dba3,c3efccfb),
+  U64x(986ddb5c,6b3a76b7), U64x(f8962946,5a75e01d),
+  U64x(be895233,86091465), U64x(f6bbb397,f1135824),
+  U64x(ee2ba6c0,678b597f), U64x(746aa07d,ed582e2d),
+  U64x(94db4838,40b717ef), U64x(a8c2a44e,b4571cdd),
+  U64x(ba121a46,50e4ddeb), U64x(92f34d62,616ce414),
+  U64x(e896a0d7,e51e1566), U64x(77b020ba,f9c81d18),
+  U64x(915e2486,ef32cd60), U64x(0ace1474,dc1d122f),
+  U64x(b5b5ada8,aaff80b8), U64x(0d819992,132456bb),
+  U64x(e3231912,d5bf60e6), U64x(10e1fff6,97ed6c6a),
+  U64x(8df5efab,c5979c8f), U64x(ca8d3ffa,1ef463c2),
+  U64x(b1736b96,b6fd83b3), U64x(bd308ff8,a6b17cb3),
+  U64x(ddd0467c,64bce4a0), U64x(ac7cb3f6,d05ddbdf),
+  U64x(8aa22c0d,bef60ee4), U64x(6bcdf07a,423aa96c),
+  U64x(ad4ab711,2eb3929d), U64x(86c16c98,d2c953c7),
+  U64x(d89d64d5,7a607744), U64x(e871c7bf,077ba8b8),
+  U64x(87625f05,6c7c4a8b), U64x(11471cd7,64ad4973),
+  U64x(a93af6c6,c79b5d2d), U64x(d598e40d,3dd89bd0),
+  U64x(d389b478,79823479), U64x(4aff1d10,8d4ec2c4),
+  U64x(843610cb,4bf160cb), U64x(cedf722a,585139bb),
+  U64x(a54394fe,1eedb8fe), U64x(c2974eb4,ee658829),
+  U64x(ce947a3d,a6a9273e), U64x(733d2262,29feea33),
+  U64x(811ccc66,8829b887), U64x(0806357d,5a3f5260),
+  U64x(a163ff80,2a3426a8), U64x(ca07c2dc,b0cf26f8),
+  U64x(c9bcff60,34c13052), U64x(fc89b393,dd02f0b6),
+  U64x(fc2c3f38,41f17c67), U64x(bbac2078,d443ace3),
+  U64x(9d9ba783,2936edc0), U64x(d54b944b,84aa4c0e),
+  U64x(c5029163,f384a931), U64x(0a9e795e,65d4df12),
+  U64x(f64335bc,f065d37d), U64x(4d4617b5,ff4a16d6),
+  U64x(99ea0196,163fa42e), U64x(504bced1,bf8e4e46),
+  U64x(c06481fb,9bcf8d39), U64x(e45ec286,2f71e1d7),
+  U64x(f07da27a,82c37088), U64x(5d767327,bb4e5a4d),
+  U64x(964e858c,91ba2655), U64x(3a6a07f8,d510f870),
+  U64x(bbe226ef,b628afea), U64x(890489f7,0a55368c),
+  U64x(eadab0ab,a3b2dbe5), U64x(2b45ac74,ccea842f),
+  U64x(92c8ae6b,464fc96f), U64x(3b0b8bc9,0012929e),
+  U64x(b77ada06,17e3bbcb), U64x(09ce6ebb,40173745),
+  U64x(e5599087,9ddcaabd), U64x(cc420a6a,101d0516),
+  U64x(8f57fa54,c2a9eab6), U64x(9fa94682,4a12232e),
+  U64x(b32df8e9,f3546564), U64x(47939822,dc96abfa),
+  U64x(dff97724,70297ebd), U64x(59787e2b,93bc56f8),
+  U64x(8bfbea76,c619ef36), U64x(57eb4edb,3c55b65b),
+  U64x(aefae514,77a06b03), U64x(ede62292,0b6b23f2),
+  U64x(dab99e59,958885c4), U64x(e95fab36,8e45ecee),
+  U64x(88b402f7,fd75539b), U64x(11dbcb02,18ebb415),
+  U64x(aae103b5,fcd2a881), U64x(d652bdc2,9f26a11a),
+  U64x(d59944a3,7c0752a2), U64x(4be76d33,46f04960),
+  U64x(857fcae6,2d8493a5), U64x(6f70a440,0c562ddc),
+  U64x(a6dfbd9f,b8e5b88e), U64x(cb4ccd50,0f6bb953),
+  U64x(d097ad07,a71f26b2), U64x(7e2000a4,1346a7a8),
+  U64x(825ecc24,c873782f), U64x(8ed40066,8c0c28c9),
+  U64x(a2f67f2d,fa90563b), U64x(72890080,2f0f32fb),
+  U64x(cbb41ef9,79346bca), U64x(4f2b40a0,3ad2ffba),
+  U64x(fea126b7,d78186bc), U64x(e2f610c8,4987bfa9),
+  U64x(9f24b832,e6b0f436), U64x(0dd9ca7d,2df4d7ca),
+  U64x(c6ede63f,a05d3143), U64x(91503d1c,79720dbc),
+  U64x(f8a95fcf,88747d94), U64x(75a44c63,97ce912b),
+  U64x(9b69dbe1,b548ce7c), U64x(c986afbe,3ee11abb),
+  U64x(c24452da,229b021b), U64x(fbe85bad,ce996169),
+  U64x(f2d56790,ab41c2a2), U64x(fae27299,423fb9c4),
+  U64x(97c560ba,6b0919a5), U64x(dccd879f,c967d41b),
+  U64x(bdb6b8e9,05cb600f), U64x(5400e987,bbc1c921),
+  U64x(ed246723,473e3813), U64x(290123e9,aab23b69),
+  U64x(9436c076,0c86e30b), U64x(f9a0b672,0aaf6522),
+  U64x(b9447093,8fa89bce), U64x(f808e40e,8d5b3e6a),
+  U64x(e7958cb8,7392c2c2), U64x(b60b1d12,30b20e05),
+  U64x(90bd77f3,483bb9b9), U64x(b1c6f22b,5e6f48c3),
+  U64x(b4ecd5f0,1a4aa828), U64x(1e38aeb6,360b1af4),
+  U64x(e2280b6c,20dd5232), U64x(25c6da63,c38de1b1),
+  U64x(8d590723,948a535f), U64x(579c487e,5a38ad0f),
+  U64x(b0af48ec,79ace837), U64x(2d835a9d,f0c6d852),
+  U64x(dcdb1b27,98182244), U64x(f8e43145,6cf88e66),
+  U64x(8a08f0f8,bf0f156b), U64x(1b8e9ecb,641b5900),
+  U64x(ac8b2d36,eed2dac5), U64x(e272467e,3d222f40),
+  U64x(d7adf884,aa879177), U64x(5b0ed81d,cc6abb10),
+  U64x(86ccbb52,ea94baea), U64x(98e94712,9fc2b4ea),
+  U64x(a87fea27,a539e9a5), U64x(3f2398d7,47b36225),
+  U64x(d29fe4b1,8e88640e), U64x(8eec7f0d,19a03aae),
+  U64x(83a3eeee,f9153e89), U64x(1953cf68,300424ad),
+  U64x(a48ceaaa,b75a8e2b), U64x(5fa8c342,3c052dd8),
+  U64x(cdb02555,653131b6), U64x(3792f412,cb06794e),
+  U64x(808e1755,5f3ebf11), U64x(e2bbd88b,bee40bd1),
+  U64x(a0b19d2a,b70e6ed6), U64x(5b6aceae,ae9d0ec5),
+  U64x(c8de0475,64d20a8b), U64x(f245825a,5a445276),
+  U64x(fb158592,be068d2e), U64x(eed6e2f0,f0d56713),
+  U64x(9ced737b,b6c4183d), U64x(55464dd6,9685606c),
+  U64x(c428d05a,a4751e4c), U64x(aa97e14c,3c26b887),
+  U64x(f5330471,4d9265df), U64x(d53dd99f,4b3066a9),
+  U64x(993fe2c6,d07b7fab), U64x(e546a803,8efe402a),
+  U64x(bf8fdb78,849a5f96), U64x(de985204,72bdd034),
+  U64x(ef73d256,a5c0f77c), U64x(963e6685,8f6d4441),
+  U64x(95a86376,27989aad), U64x(dde70013,79a44aa9),
+  U64x(bb127c53,b17ec159), U64x(5560c018,580d5d53),
+  U64x(e9d71b68,9dde71af), U64x(aab8f01e,6e10b4a7),
+  U64x(92267121,62ab070d), U64x(cab39613,04ca70e9),
+  U64x(b6b00d69,bb55c8d1), U64x(3d607b97,c5fd0d23),
+  U64x(e45c10c4,2a2b3b05), U64x(8cb89a7d,b77c506b),
+  U64x(8eb98a7a,9a5b04e3), U64x(77f3608e,92adb243),
+  U64x(b267ed19,40f1c61c), U64x(55f038b2,37591ed4),
+  U64x(df01e85f,912e37a3), U64x(6b6c46de,c52f6689),
+  U64x(8b61313b,babce2c6), U64x(2323ac4b,3b3da016),
+  U64x(ae397d8a,a96c1b77), U64x(abec975e,0a0d081b),
+  U64x(d9c7dced,53c72255), U64x(96e7bd35,8c904a22),
+  U64x(881cea14,545c7575), U64x(7e50d641,77da2e55),
+  U64x(aa242499,697392d2), U64x(dde50bd1,d5d0b9ea),
+  U64x(d4ad2dbf,c3d07787), U64x(955e4ec6,4b44e865),
+  U64x(84ec3c97,da624ab4), U64x(bd5af13b,ef0b113f),
+  U64x(a6274bbd,d0fadd61), U64x(ecb1ad8a,eacdd58f),
+  U64x(cfb11ead,453994ba), U64x(67de18ed,a5814af3),
+  U64x(81ceb32c,4b43fcf4), U64x(80eacf94,8770ced8),
+  U64x(a2425ff7,5e14fc31), U64x(a1258379,a94d028e),
+  U64x(cad2f7f5,359a3b3e), U64x(096ee458,13a04331),
+  U64x(fd87b5f2,8300ca0d), U64x(8bca9d6e,188853fd),
+  U64x(9e74d1b7,91e07e48), U64x(775ea264,cf55347e),
+  U64x(c6120625,76589dda), U64x(95364afe,032a819e),
+  U64x(f79687ae,d3eec551), U64x(3a83ddbd,83f52205),
+  U64x(9abe14cd,44753b52), U64x(c4926a96,72793543),
+  U64x(c16d9a00,95928a27), U64x(75b7053c,0f178294),
+  U64x(f1c90080,baf72cb1), U64x(5324c68b,12dd6339),
+  U64x(971da050,74da7bee), U64x(d3f6fc16,ebca5e04),
+  U64x(bce50864,92111aea), U64x(88f4bb1c,a6bcf585),
+  U64x(ec1e4a7d,b69561a5), U64x(2b31e9e3,d06c32e6),
+  U64x(9392ee8e,921d5d07), U64x(3aff322e,62439fd0),
+  U64x(b877aa32,36a4b449), U64x(09befeb9,fad487c3),
+  U64x(e69594be,c44de15b), U64x(4c2ebe68,7989a9b4),
+  U64x(901d7cf7,3ab0acd9), U64x(0f9d3701,4bf60a11),
+  U64x(b424dc35,095cd80f), U64x(538484c1,9ef38c95),
+  U64x(e12e1342,4bb40e13), U64x(2865a5f2,06b06fba),
+  U64x(8cbccc09,6f5088cb), U64x(f93f87b7,442e45d4),
+  U64x(afebff0b,cb24aafe), U64x(f78f69a5,1539d749),
+  U64x(dbe6fece,bdedd5be), U64x(b573440e,5a884d1c),
+  U64x(89705f41,36b4a597), U64x(31680a88,f8953031),
+  U64x(abcc7711,8461cefc), U64x(fdc20d2b,36ba7c3e),
+  U64x(d6bf94d5,e57a42bc), U64x(3d329076,04691b4d),
+  U64x(8637bd05,af6c69b5), U64x(a63f9a49,c2c1b110),
+  U64x(a7c5ac47,1b478423), U64x(0fcf80dc,33721d54),
+  U64x(d1b71758,e219652b), U64x(d3c36113,404ea4a9),
+  U64x(83126e97,8d4fdf3b), U64x(645a1cac,083126ea),
+  U64x(a3d70a3d,70a3d70a), U64x(3d70a3d7,0a3d70a4),
+  U64x(cccccccc,cccccccc), U64x(cccccccc,cccccccd),
+  U64x(80000000,00000000), U64x(00000000,00000000),
+  U64x(a0000000,00000000), U64x(00000000,00000000),
+  U64x(c8000000,00000000), U64x(00000000,00000000),
+  U64x(fa000000,00000000), U64x(00000000,00000000),
+  U64x(9c400000,00000000), U64x(00000000,00000000),
+  U64x(c3500000,00000000), U64x(00000000,00000000),
+  U64x(f4240000,00000000), U64x(00000000,00000000),
+  U64x(98968000,00000000), U64x(00000000,00000000),
+  U64x(bebc2000,00000000), U64x(00000000,00000000),
+  U64x(ee6b2800,00000000), U64x(00000000,00000000),
+  U64x(9502f900,00000000), U64x(00000000,00000000),
+  U64x(ba43b740,00000000), U64x(00000000,00000000),
+  U64x(e8d4a510,00000000), U64x(00000000,00000000),
+  U64x(9184e72a,00000000), U64x(00000000,00000000),
+  U64x(b5e620f4,80000000), U64x(00000000,00000000),
+  U64x(e35fa931,a0000000), U64x(00000000,00000000),
+  U64x(8e1bc9bf,04000000), U64x(00000000,00000000),
+  U64x(b1a2bc2e,c5000000), U64x(00000000,00000000),
+  U64x(de0b6b3a,76400000), U64x(00000000,00000000),
+  U64x(8ac72304,89e80000), U64x(00000000,00000000),
+  U64x(ad78ebc5,ac620000), U64x(00000000,00000000),
+  U64x(d8d726b7,177a8000), U64x(00000000,00000000),
+  U64x(87867832,6eac9000), U64x(00000000,00000000),
+  U64x(a968163f,0a57b400), U64x(00000000,00000000),
+  U64x(d3c21bce,cceda100), U64x(00000000,00000000),
+  U64x(84595161,401484a0), U64x(00000000,00000000),
+  U64x(a56fa5b9,9019a5c8), U64x(00000000,00000000),
+  U64x(cecb8f27,f4200f3a), U64x(00000000,00000000),
+  U64x(813f3978,f8940984), U64x(40000000,00000000),
+  U64x(a18f07d7,36b90be5), U64x(50000000,00000000),
+  U64x(c9f2c9cd,04674ede), U64x(a4000000,00000000),
+  U64x(fc6f7c40,45812296), U64x(4d000000,00000000),
+  U64x(9dc5ada8,2b70b59d), U64x(f0200000,00000000),
+  U64x(c5371912,364ce305), U64x(6c280000,00000000),
+  U64x(f684df56,c3e01bc6), U64x(c7320000,00000000),
+  U64x(9a130b96,3a6c115c), U64x(3c7f4000,00000000),
+  U64x(c097ce7b,c90715b3), U64x(4b9f1000,00000000),
+  U64x(f0bdc21a,bb48db20), U64x(1e86d400,00000000),
+  U64x(96769950,b50d88f4), U64x(13144480,00000000),
+  U64x(bc143fa4,e250eb31), U64x(17d955a0,00000000),
+  U64x(eb194f8e,1ae525fd), U64x(5dcfab08,00000000),
+  U64x(92efd1b8,d0cf37be), U64x(5aa1cae5,00000000),
+  U64x(b7abc627,050305ad), U64x(f14a3d9e,40000000),
+  U64x(e596b7b0,c643c719), U64x(6d9ccd05,d0000000),
+  U64x(8f7e32ce,7bea5c6f), U64x(e4820023,a2000000),
+  U64x(b35dbf82,1ae4f38b), U64x(dda2802c,8a800000),
+  U64x(e0352f62,a19e306e), U64x(d50b2037,ad200000),
+  U64x(8c213d9d,a502de45), U64x(4526f422,cc340000),
+  U64x(af298d05,0e4395d6), U64x(9670b12b,7f410000),
+  U64x(daf3f046,51d47b4c), U64x(3c0cdd76,5f114000),
+  U64x(88d8762b,f324cd0f), U64x(a5880a69,fb6ac800),
+  U64x(ab0e93b6,efee0053), U64x(8eea0d04,7a457a00),
+  U64x(d5d238a4,abe98068), U64x(72a49045,98d6d880),
+  U64x(85a36366,eb71f041), U64x(47a6da2b,7f864750),
+  U64x(a70c3c40,a64e6c51), U64x(999090b6,5f67d924),
+  U64x(d0cf4b50,cfe20765), U64x(fff4b4e3,f741cf6d),
+  U64x(82818f12,81ed449f), U64x(bff8f10e,7a8921a5),
+  U64x(a321f2d7,226895c7), U64x(aff72d52,192b6a0e),
+  U64x(cbea6f8c,eb02bb39), U64x(9bf4f8a6,9f764491),
+  U64x(fee50b70,25c36a08), U64x(02f236d0,4753d5b5),
+  U64x(9f4f2726,179a2245), U64x(01d76242,2c946591),
+  U64x(c722f0ef,9d80aad6), U64x(424d3ad2,b7b97ef6),
+  U64x(f8ebad2b,84e0d58b), U64x(d2e08987,65a7deb3),
+  U64x(9b934c3b,330c8577), U64x(63cc55f4,9f88eb30),
+  U64x(c2781f49,ffcfa6d5), U64x(3cbf6b71,c76b25fc),
+  U64x(f316271c,7fc3908a), U64x(8bef464e,3945ef7b),
+  U64x(97edd871,cfda3a56), U64x(97758bf0,e3cbb5ad),
+  U64x(bde94e8e,43d0c8ec), U64x(3d52eeed,1cbea318),
+  U64x(ed63a231,d4c4fb27), U64x(4ca7aaa8,63ee4bde),
+  U64x(945e455f,24fb1cf8), U64x(8fe8caa9,3e74ef6b),
+  U64x(b975d6b6,ee39e436), U64x(b3e2fd53,8e122b45),
+  U64x(e7d34c64,a9c85d44), U64x(60dbbca8,7196b617),
+  U64x(90e40fbe,ea1d3a4a), U64x(bc8955e9,46fe31ce),
+  U64x(b51d13ae,a4a488dd), U64x(6babab63,98bdbe42),
+  U64x(e264589a,4dcdab14), U64x(c696963c,7eed2dd2),
+  U64x(8d7eb760,70a08aec), U64x(fc1e1de5,cf543ca3),
+  U64x(b0de6538,8cc8ada8), U64x(3b25a55f,43294bcc),
+  U64x(dd15fe86,affad912), U64x(49ef0eb7,13f39ebf),
+  U64x(8a2dbf14,2dfcc7ab), U64x(6e356932,6c784338),
+  U64x(acb92ed9,397bf996), U64x(49c2c37f,07965405),
+  U64x(d7e77a8f,87daf7fb), U64x(dc33745e,c97be907),
+  U64x(86f0ac99,b4e8dafd), U64x(69a028bb,3ded71a4),
+  U64x(a8acd7c0,222311bc), U64x(c40832ea,0d68ce0d),
+  U64x(d2d80db0,2aabd62b), U64x(f50a3fa4,90c30191),
+  U64x(83c7088e,1aab65db), U64x(792667c6,da79e0fb),
+  U64x(a4b8cab1,a1563f52), U64x(577001b8,91185939),
+  U64x(cde6fd5e,09abcf26), U64x(ed4c0226,b55e6f87),
+  U64x(80b05e5a,c60b6178), U64x(544f8158,315b05b5),
+  U64x(a0dc75f1,778e39d6), U64x(696361ae,3db1c722),
+  U64x(c913936d,d571c84c), U64x(03bc3a19,cd1e38ea),
+  U64x(fb587849,4ace3a5f), U64x(04ab48a0,4065c724),
+  U64x(9d174b2d,cec0e47b), U64x(62eb0d64,283f9c77),
+  U64x(c45d1df9,42711d9a), U64x(3ba5d0bd,324f8395),
+  U64x(f5746577,930d6500), U64x(ca8f44ec,7ee3647a),
+  U64x(9968bf6a,bbe85f20), U64x(7e998b13,cf4e1ecc),
+  U64x(bfc2ef45,6ae276e8), U64x(9e3fedd8,c321a67f),
+  U64x(efb3ab16,c59b14a2), U64x(c5cfe94e,f3ea101f),
+  U64x(95d04aee,3b80ece5), U64x(bba1f1d1,58724a13),
+  U64x(bb445da9,ca61281f), U64x(2a8a6e45,ae8edc98),
+  U64x(ea157514,3cf97226), U64x(f52d09d7,1a3293be),
+  U64x(924d692c,a61be758), U64x(593c2626,705f9c57),
+  U64x(b6e0c377,cfa2e12e), U64x(6f8b2fb0,0c77836d),
+  U64x(e498f455,c38b997a), U64x(0b6dfb9c,0f956448),
+  U64x(8edf98b5,9a373fec), U64x(4724bd41,89bd5ead),
+  U64x(b2977ee3,00c50fe7), U64x(58edec91,ec2cb658),
+  U64x(df3d5e9b,c0f653e1), U64x(2f2967b6,6737e3ee),
+  U64x(8b865b21,5899f46c), U64x(bd79e0d2,0082ee75),
+  U64x(ae67f1e9,aec07187), U64x(ecd85906,80a3aa12),
+  U64x(da01ee64,1a708de9), U64x(e80e6f48,20cc9496),
+  U64x(884134fe,908658b2), U64x(3109058d,147fdcde),
+  U64x(aa51823e,34a7eede), U64x(bd4b46f0,599fd416),
+  U64x(d4e5e2cd,c1d1ea96), U64x(6c9e18ac,7007c91b),
+  U64x(850fadc0,9923329e), U64x(03e2cf6b,c604ddb1),
+  U64x(a6539930,bf6bff45), U64x(84db8346,b786151d),
+  U64x(cfe87f7c,ef46ff16), U64x(e6126418,65679a64),
+  U64x(81f14fae,158c5f6e), U64x(4fcb7e8f,3f60c07f),
+  U64x(a26da399,9aef7749), U64x(e3be5e33,0f38f09e),
+  U64x(cb090c80,01ab551c), U64x(5cadf5bf,d3072cc6),
+  U64x(fdcb4fa0,02162a63), U64x(73d9732f,c7c8f7f7),
+  U64x(9e9f11c4,014dda7e), U64x(2867e7fd,dcdd9afb),
+  U64x(c646d635,01a1511d), U64x(b281e1fd,541501b9),
+  U64x(f7d88bc2,4209a565), U64x(1f225a7c,a91a4227),
+  U64x(9ae75759,6946075f), U64x(3375788d,e9b06959),
+  U64x(c1a12d2f,c3978937), U64x(0052d6b1,641c83af),
+  U64x(f209787b,b47d6b84), U64x(c0678c5d,bd23a49b),
+  U64x(9745eb4d,50ce6332), U64x(f840b7ba,963646e1),
+  U64x(bd176620,a501fbff), U64x(b650e5a9,3bc3d899),
+  U64x(ec5d3fa8,ce427aff), U64x(a3e51f13,8ab4cebf),
+  U64x(93ba47c9,80e98cdf), U64x(c66f336c,36b10138),
+  U64x(b8a8d9bb,e123f017), U64x(b80b0047,445d4185),
+  U64x(e6d3102a,d96cec1d), U64x(a60dc059,157491e6),
+  U64x(9043ea1a,c7e41392), U64x(87c89837,ad68db30),
+  U64x(b454e4a1,79dd1877), U64x(29babe45,98c311fc),
+  U64x(e16a1dc9,d8545e94), U64x(f4296dd6,fef3d67b),
+  U64x(8ce2529e,2734bb1d), U64x(1899e4a6,5f58660d),
+  U64x(b01ae745,b101e9e4), U64x(5ec05dcf,f72e7f90),
+  U64x(dc21a117,1d42645d), U64x(76707543,f4fa1f74),
+  U64x(899504ae,72497eba), U64x(6a06494a,791c53a9),
+  U64x(abfa45da,0edbde69), U64x(0487db9d,17636893),
+  U64x(d6f8d750,9292d603), U64x(45a9d284,5d3c42b7),
+  U64x(865b8692,5b9bc5c2), U64x(0b8a2392,ba45a9b3),
+  U64x(a7f26836,f282b732), U64x(8e6cac77,68d7141f),
+  U64x(d1ef0244,af2364ff), U64x(3207d795,430cd927),
+  U64x(8335616a,ed761f1f), U64x(7f44e6bd,49e807b9),
+  U64x(a402b9c5,a8d3a6e7), U64x(5f16206c,9c6209a7),
+  U64x(cd036837,130890a1), U64x(36dba887,c37a8c10),
+  U64x(80222122,6be55a64), U64x(c2494954,da2c978a),
+  U64x(a02aa96b,06deb0fd), U64x(f2db9baa,10b7bd6d),
+  U64x(c83553c5,c8965d3d), U64x(6f928294,94e5acc8),
+  U64x(fa42a8b7,3abbf48c), U64x(cb772339,ba1f17fa),
+  U64x(9c69a972,84b578d7), U64x(ff2a7604,14536efc),
+  U64x(c38413cf,25e2d70d), U64x(fef51385,19684abb),
+  U64x(f46518c2,ef5b8cd1), U64x(7eb25866,5fc25d6a),
+  U64x(98bf2f79,d5993802), U64x(ef2f773f,fbd97a62),
+  U64x(beeefb58,4aff8603), U64x(aafb550f,facfd8fb),
+  U64x(eeaaba2e,5dbf6784), U64x(95ba2a53,f983cf39),
+  U64x(952ab45c,fa97a0b2), U64x(dd945a74,7bf26184),
+  U64x(ba756174,393d88df), U64x(94f97111,9aeef9e5),
+  U64x(e912b9d1,478ceb17), U64x(7a37cd56,01aab85e),
+  U64x(91abb422,ccb812ee), U64x(ac62e055,c10ab33b),
+  U64x(b616a12b,7fe617aa), U64x(577b986b,314d600a),
+  U64x(e39c4976,5fdf9d94), U64x(ed5a7e85,fda0b80c),
+  U64x(8e41ade9,fbebc27d), U64x(14588f13,be847308),
+  U64x(b1d21964,7ae6b31c), U64x(596eb2d8,ae258fc9),
+  U64x(de469fbd,99a05fe3), U64x(6fca5f8e,d9aef3bc),
+  U64x(8aec23d6,80043bee), U64x(25de7bb9,480d5855),
+  U64x(ada72ccc,20054ae9), U64x(af561aa7,9a10ae6b),
+  U64x(d910f7ff,28069da4), U64x(1b2ba151,8094da05),
+  U64x(87aa9aff,79042286), U64x(90fb44d2,f05d0843),
+  U64x(a99541bf,57452b28), U64x(353a1607,ac744a54),
+  U64x(d3fa922f,2d1675f2), U64x(42889b89,97915ce9),
+  U64x(847c9b5d,7c2e09b7), U64x(69956135,febada12),
+  U64x(a59bc234,db398c25), U64x(43fab983,7e699096),
+  U64x(cf02b2c2,1207ef2e), U64x(94f967e4,5e03f4bc),
+  U64x(8161afb9,4b44f57d), U64x(1d1be0ee,bac278f6),
+  U64x(a1ba1ba7,9e1632dc), U64x(6462d92a,69731733),
+  U64x(ca28a291,859bbf93), U64x(7d7b8f75,03cfdcff),
+  U64x(fcb2cb35,e702af78), U64x(5cda7352,44c3d43f),
+  U64x(9defbf01,b061adab), U64x(3a088813,6afa64a8),
+  U64x(c56baec2,1c7a1916), U64x(088aaa18,45b8fdd1),
+  U64x(f6c69a72,a3989f5b), U64x(8aad549e,57273d46),
+  U64x(9a3c2087,a63f6399), U64x(36ac54e2,f678864c),
+  U64x(c0cb28a9,8fcf3c7f), U64x(84576a1b,b416a7de),
+  U64x(f0fdf2d3,f3c30b9f), U64x(656d44a2,a11c51d6),
+  U64x(969eb7c4,7859e743), U64x(9f644ae5,a4b1b326),
+  U64x(bc4665b5,96706114), U64x(873d5d9f,0dde1fef),
+  U64x(eb57ff22,fc0c7959), U64x(a90cb506,d155a7eb),
+  U64x(9316ff75,dd87cbd8), U64x(09a7f124,42d588f3),
+  U64x(b7dcbf53,54e9bece), U64x(0c11ed6d,538aeb30),
+  U64x(e5d3ef28,2a242e81), U64x(8f1668c8,a86da5fb),
+  U64x(8fa47579,1a569d10), U64x(f96e017d,694487bd),
+  U64x(b38d92d7,60ec4455), U64x(37c981dc,c395a9ad),
+  U64x(e070f78d,3927556a), U64x(85bbe253,f47b1418),
+  U64x(8c469ab8,43b89562), U64x(93956d74,78ccec8f),
+  U64x(af584166,54a6babb), U64x(387ac8d1,970027b3),
+  U64x(db2e51bf,e9d0696a), U64x(06997b05,fcc0319f),
+  U64x(88fcf317,f22241e2), U64x(441fece3,bdf81f04),
+  U64x(ab3c2fdd,eeaad25a), U64x(d527e81c,ad7626c4),
+  U64x(d60b3bd5,6a5586f1), U64x(8a71e223,d8d3b075),
+  U64x(85c70565,62757456), U64x(f6872d56,67844e4a),
+  U64x(a738c6be,bb12d16c), U64x(b428f8ac,016561dc),
+  U64x(d106f86e,69d785c7), U64x(e13336d7,01beba53),
+  U64x(82a45b45,0226b39c), U64x(ecc00246,61173474),
+  U64x(a34d7216,42b06084), U64x(27f002d7,f95d0191),
+  U64x(cc20ce9b,d35c78a5), U64x(31ec038d,f7b441f5),
+  U64x(ff290242,c83396ce), U64x(7e670471,75a15272),
+  U64x(9f79a169,bd203e41), U64x(0f0062c6,e984d387),
+  U64x(c75809c4,2c684dd1), U64x(52c07b78,a3e60869),
+  U64x(f92e0c35,37826145), U64x(a7709a56,ccdf8a83),
+  U64x(9bbcc7a1,42b17ccb), U64x(88a66076,400bb692),
+  U64x(c2abf989,935ddbfe), U64x(6acff893,d00ea436),
+  U64x(f356f7eb,f83552fe), U64x(0583f6b8,c4124d44),
+  U64x(98165af3,7b2153de), U64x(c3727a33,7a8b704b),
+  U64x(be1bf1b0,59e9a8d6), U64x(744f18c0,592e4c5d),
+  U64x(eda2ee1c,7064130c), U64x(1162def0,6f79df74),
+  U64x(9485d4d1,c63e8be7), U64x(8addcb56,45ac2ba9),
+  U64x(b9a74a06,37ce2ee1), U64x(6d953e2b,d7173693),
+  U64x(e8111c87,c5c1ba99), U64x(c8fa8db6,ccdd0438),
+  U64x(910ab1d4,db9914a0), U64x(1d9c9892,400a22a3),
+  U64x(b54d5e4a,127f59c8), U64x(2503beb6,d00cab4c),
+  U64x(e2a0b5dc,971f303a), U64x(2e44ae64,840fd61e),
+  U64x(8da471a9,de737e24), U64x(5ceaecfe,d289e5d3),
+  U64x(b10d8e14,56105dad), U64x(7425a83e,872c5f48),
+  U64x(dd50f199,6b947518), U64x(d12f124e,28f7771a),
+  U64x(8a5296ff,e33cc92f), U64x(82bd6b70,d99aaa70),
+  U64x(ace73cbf,dc0bfb7b), U64x(636cc64d,1001550c),
+  U64x(d8210bef,d30efa5a), U64x(3c47f7e0,5401aa4f),
+  U64x(8714a775,e3e95c78), U64x(65acfaec,34810a72),
+  U64x(a8d9d153,5ce3b396), U64x(7f1839a7,41a14d0e),
+  U64x(d31045a8,341ca07c), U64x(1ede4811,1209a051),
+  U64x(83ea2b89,2091e44d), U64x(934aed0a,ab460433),
+  U64x(a4e4b66b,68b65d60), U64x(f81da84d,56178540),
+  U64x(ce1de406,42e3f4b9), U64x(36251260,ab9d668f),
+  U64x(80d2ae83,e9ce78f3), U64x(c1d72b7c,6b42601a),
+  U64x(a1075a24,e4421730), U64x(b24cf65b,8612f820),
+  U64x(c94930ae,1d529cfc), U64x(dee033f2,6797b628),
+  U64x(fb9b7cd9,a4a7443c), U64x(169840ef,017da3b2),
+  U64x(9d412e08,06e88aa5), U64x(8e1f2895,60ee864f),
+  U64x(c491798a,08a2ad4e), U64x(f1a6f2ba,b92a27e3),
+  U64x(f5b5d7ec,8acb58a2), U64x(ae10af69,6774b1dc),
+  U64x(9991a6f3,d6bf1765), U64x(acca6da1,e0a8ef2a),
+  U64x(bff610b0,cc6edd3f), U64x(17fd090a,58d32af4),
+  U64x(eff394dc,ff8a948e), U64x(ddfc4b4c,ef07f5b1),
+  U64x(95f83d0a,1fb69cd9), U64x(4abdaf10,1564f98f),
+  U64x(bb764c4c,a7a4440f), U64x(9d6d1ad4,1abe37f2),
+  U64x(ea53df5f,d18d5513), U64x(84c86189,216dc5ee),
+  U64x(92746b9b,e2f8552c), U64x(32fd3cf5,b4e49bb5),
+  U64x(b7118682,dbb66a77), U64x(3fbc8c33,221dc2a2),
+  U64x(e4d5e823,92a40515), U64x(0fabaf3f,eaa5334b),
+  U64x(8f05b116,3ba6832d), U64x(29cb4d87,f2a7400f),
+  U64x(b2c71d5b,ca9023f8), U64x(743e20e9,ef511013),
+  U64x(df78e4b2,bd342cf6), U64x(914da924,6b255417),
+  U64x(8bab8eef,b6409c1a), U64x(1ad089b6,c2f7548f),
+  U64x(ae9672ab,a3d0c320), U64x(a184ac24,73b529b2),
+  U64x(da3c0f56,8cc4f3e8), U64x(c9e5d72d,90a2741f),
+  U64x(88658996,17fb1871), U64x(7e2fa67c,7a658893),
+  U64x(aa7eebfb,9df9de8d), U64x(ddbb901b,98feeab8),
+  U64x(d51ea6fa,85785631), U64x(552a7422,7f3ea566),
+  U64x(8533285c,936b35de), U64x(d53a8895,8f872760),
+  U64x(a67ff273,b8460356), U64x(8a892aba,f368f138),
+  U64x(d01fef10,a657842c), U64x(2d2b7569,b0432d86),
+  U64x(8213f56a,67f6b29b), U64x(9c3b2962,0e29fc74),
+  U64x(a298f2c5,01f45f42), U64x(8349f3ba,91b47b90),
+  U64x(cb3f2f76,42717713), U64x(241c70a9,36219a74),
+  U64x(fe0efb53,d30dd4d7), U64x(ed238cd3,83aa0111),
+  U64x(9ec95d14,63e8a506), U64x(f4363804,324a40ab),
+  U64x(c67bb459,7ce2ce48), U64x(b143c605,3edcd0d6),
+  U64x(f81aa16f,dc1b81da), U64x(dd94b786,8e94050b),
+  U64x(9b10a4e5,e9913128), U64x(ca7cf2b4,191c8327),
+  U64x(c1d4ce1f,63f57d72), U64x(fd1c2f61,1f63a3f1),
+  U64x(f24a01a7,3cf2dccf), U64x(bc633b39,673c8ced),
+  U64x(976e4108,8617ca01), U64x(d5be0503,e085d814),
+  U64x(bd49d14a,a79dbc82), U64x(4b2d8644,d8a74e19),
+  U64x(ec9c459d,51852ba2), U64x(ddf8e7d6,0ed1219f),
+  U64x(93e1ab82,52f33b45), U64x(cabb90e5,c942b504),
+  U64x(b8da1662,e7b00a17), U64x(3d6a751f,3b936244),
+  U64x(e7109bfb,a19c0c9d), U64x(0cc51267,0a783ad5),
+  U64x(906a617d,450187e2), U64x(27fb2b80,668b24c6),
+  U64x(b484f9dc,9641e9da), U64x(b1f9f660,802dedf7),
+  U64x(e1a63853,bbd26451), U64x(5e7873f8,a0396974),
+  U64x(8d07e334,55637eb2), U64x(db0b487b,6423e1e9),
+  U64x(b049dc01,6abc5e5f), U64x(91ce1a9a,3d2cda63),
+  U64x(dc5c5301,c56b75f7), U64x(7641a140,cc7810fc),
+  U64x(89b9b3e1,1b6329ba), U64x(a9e904c8,7fcb0a9e),
+  U64x(ac2820d9,623bf429), U64x(546345fa,9fbdcd45),
+  U64x(d732290f,bacaf133), U64x(a97c1779,47ad4096),
+  U64x(867f59a9,d4bed6c0), U64x(49ed8eab,cccc485e),
+  U64x(a81f3014,49ee8c70), U64x(5c68f256,bfff5a75),
+  U64x(d226fc19,5c6a2f8c), U64x(73832eec,6fff3112),
+  U64x(83585d8f,d9c25db7), U64x(c831fd53,c5ff7eac),
+  U64x(a42e74f3,d032f525), U64x(ba3e7ca8,b77f5e56),
+  U64x(cd3a1230,c43fb26f), U64x(28ce1bd2,e55f35ec),
+  U64x(80444b5e,7aa7cf85), U64x(7980d163,cf5b81b4),
+  U64x(a0555e36,1951c366), U64x(d7e105bc,c3326220),
+  U64x(c86ab5c3,9fa63440), U64x(8dd9472b,f3fefaa8),
+  U64x(fa856334,878fc150), U64x(b14f98f6,f0feb952),
+  U64x(9c935e00,d4b9d8d2), U64x(6ed1bf9a,569f33d4),
+  U64x(c3b83581,09e84f07), U64x(0a862f80,ec4700c9),
+  U64x(f4a642e1,4c6262c8), U64x(cd27bb61,2758c0fb),
+  U64x(98e7e9cc,cfbd7dbd), U64x(8038d51c,b897789d),
+  U64x(bf21e440,03acdd2c), U64x(e0470a63,e6bd56c4),
+  U64x(eeea5d50,04981478), U64x(1858ccfc,e06cac75),
+  U64x(95527a52,02df0ccb), U64x(0f37801e,0c43ebc9),
+  U64x(baa718e6,8396cffd), U64x(d3056025,8f54e6bb),
+  U64x(e950df20,247c83fd), U64x(47c6b82e,f32a206a),
+  U64x(91d28b74,16cdd27e), U64x(4cdc331d,57fa5442),
+  U64x(b6472e51,1c81471d), U64x(e0133fe4,adf8e953),
+  U64x(e3d8f9e5,63a198e5), U64x(58180fdd,d97723a7),
+  U64x(8e679c2f,5e44ff8f), U64x(570f09ea,a7ea7649),
+  U64x(b201833b,35d63f73), U64x(2cd2cc65,51e513db),
+  U64x(de81e40a,034bcf4f), U64x(f8077f7e,a65e58d2),
+  U64x(8b112e86,420f6191), U64x(fb04afaf,27faf783),
+  U64x(add57a27,d29339f6), U64x(79c5db9a,f1f9b564),
+  U64x(d94ad8b1,c7380874), U64x(18375281,ae7822bd),
+  U64x(87cec76f,1c830548), U64x(8f229391,0d0b15b6),
+  U64x(a9c2794a,e3a3c69a), U64x(b2eb3875,504ddb23),
+  U64x(d433179d,9c8cb841), U64x(5fa60692,a46151ec),
+  U64x(849feec2,81d7f328), U64x(dbc7c41b,a6bcd334),
+  U64x(a5c7ea73,224deff3), U64x(12b9b522,906c0801),
+  U64x(cf39e50f,eae16bef), U64x(d768226b,34870a01),
+  U64x(81842f29,f2cce375), U64x(e6a11583,00d46641),
+  U64x(a1e53af4,6f801c53), U64x(60495ae3,c1097fd1),
+  U64x(ca5e89b1,8b602368), U64x(385bb19c,b14bdfc5),
+  U64x(fcf62c1d,ee382c42), U64x(46729e03,dd9ed7b6),
+  U64x(9e19db92,b4e31ba9), U64x(6c07a2c2,6a8346d2)
+};
+
+/* Compute the high 64 bits of g*cp/2^64, rounded to odd. */
+static LJ_AINLINE uint64_t round_to_odd(const uint64_t *g, uint64_t cp)
+{
+  uint64_t xlo, ylo, x1 = lj_strfmt_mul128(g[1], cp, &xlo);
+  uint64_t y1 = lj_strfmt_mul128(g[0], cp, &ylo);
+  uint64_t z = ylo + x1;
+  y1 += (z < ylo);
+  return y1 | (z > 1);
+}
+
+/* floor(log10(2^e)), floor(log10(3/4 * 2^e)) and floor(log2(10^e)). */
+#define FLOORLOG10_POW2(e)	(((e) * 1262611) >> 22)
+#define FLOORLOG10_34POW2(e)	(((e) * 1262611 - 524031) >> 22)
+#define FLOORLOG2_POW10(e)	(((e) * 1741647) >> 19)
+
+/* Convert finite non-zero double to shortest decimal s*10^k. */
+static uint64_t shortest_dec(uint64_t bits, int32_t *kp)
+{
+  uint64_t c = bits & U64x(000fffff,ffffffff);
+  int32_t q = (int32_t)((bits >> 52) & 0x7ff), k, h;
+  int closer = (c == 0 && q > 1), even;
+  const uint64_t *g;
+  uint64_t vbl, vb, vbr, lower, upper, s;
+  if (q) {
+    c |= U64x(00100000,00000000);
+    q -= 1075;
+    if ((uint32_t)-q < 53 && !(c & ((U64x(00000000,00000001) << -q) - 1))) {
+      *kp = 0;  /* Fast path for small integers. */
+      return c >> -q;
+    }
+  } else {
+    q = -1074;
+  }
+  even = !(c & 1);
+  k = closer ? FLOORLOG10_34POW2(q) : FLOORLOG10_POW2(q);
+  h = q + FLOORLOG2_POW10(-k) + 1;
+  g = lj_strfmt_pow10 + 2*(-k - STRFMT_POW10_KMIN);
+  vbl = round_to_odd(g, (4*c - 2 + closer) << h);
+  vb = round_to_odd(g, (4*c) << h);
+  vbr = round_to_odd(g, (4*c + 2) << h);
+  lower = vbl + !even;
+  upper = vbr - !even;
+  s = vb >> 2;
+  if (s >= 10) {  /* Try one digit less. */
+    uint64_t sp = s / 10;
+    int up = lower <= 40*sp, wp = 40*sp + 40 <= upper;
+    if (up != wp) { *kp = k + 1; return sp + wp; }
+  }
+  {
+    int u = lower <= 4*s, w = 4*s + 4 <= upper;
+    *kp = k;
+    if (u != w) return s + w;
+    /* Both candidates are inside the rounding interval: pick the closest. */
+    return s + (vb > 4*s + 2 || (vb == 4*s + 2 && (s & 1)));
+  }
+}
+
+/* Write shortest round-trip representation of finite number. */
+static char *lj_strfmt_wshortest(char *p, SFormat sf, lua_Number n)
+{
+  TValue t;
+  char buf[20], *q = buf;
+  int32_t k, nde;
+  MSize nd;
+  t.n = n;
+  if ((t.u64 << 1) == 0) {
+    *q = '0'; nd = 1; k = 0;
+  } else {
+    uint64_t s = shortest_dec(t.u64 & U64x(7fffffff,ffffffff), &k);
+    uint32_t hi;
+    while (s % 10 == 0) { s /= 10; k++; }  /* Strip trailing zeroes. */
+    hi = (uint32_t)(s / 1000000000);
+    if (hi) q = lj_strfmt_wuint9(lj_strfmt_wint(q, (int32_t)hi),
+				 (uint32_t)(s - (uint64_t)hi * 1000000000));
+    else q = lj_strfmt_wint(q, (int32_t)s);
+    nd = (MSize)(q - buf);
+    q = buf;
+  }
+  nde = k + (int32_t)nd - 1;
+  if (t.u32.hi & 0x80000000) *p++ = '-';
+  else if ((sf & STRFMT_F_PLUS)) *p++ = '+';
+  else if ((sf & STRFMT_F_SPACE)) *p++ = ' ';
+  if (nde < -4 || nde >= 17) {
+    /* Exponential format, like %.17g. */
+    *p++ = *q++;
+    if (nd > 1) {
+      *p++ = '.';
+      memcpy(p, q, nd - 1); p += nd - 1;
+    }
+    *p++ = (sf & STRFMT_F_UPPER) ? 'E' : 'e';
+    if (nde < 0) { *p++ = '-'; nde = -nde; } else { *p++ = '+'; }
+    if (nde < 10) *p++ = '0';  /* Always at least two digits of exponent. */
+    p = lj_strfmt_wint(p, nde);
+  } else if (nde < 0) {
+    /* Leading zeroes: 0.000ddd */
+    *p++ = '0'; *p++ = '.';
+    while (++nde < 0) *p++ = '0';
+    memcpy(p, q, nd); p += nd;
+  } else if ((MSize)nde + 1 >= nd) {
+    /* Integer: ddd000 */
+    memcpy(p, q, nd); p += nd;
+    while ((MSize)nde-- >= nd) *p++ = '0';
+  } else {
+    /* Fraction: ddd.ddd */
+    memcpy(p, q, (MSize)nde + 1); p += nde + 1;
+    *p++ = '.';
+    memcpy(p, q + nde + 1, nd - nde - 1); p += nd - nde - 1;
+  }
+  return p;
+}
+
 /* -- Formatted conversions to buffer ------------------------------------- */
 
 /* Write formatted floating-point number to either sb or p. */
@@ -288,6 +1032,22 @@ static char *lj_strfmt_wfnum(SBuf *sb, SFormat sf, lua_Number n, char *p)
     if (!(sf & STRFMT_F_LEFT)) while (width-- > len) *p++ = ' ';
     if (prefix) *p++ = prefix;
     *p++ = (char)(ch >> 16); *p++ = (char)(ch >> 8); *p++ = (char)ch;
+  } else if ((sf & STRFMT_T_FP_R)) {
+    /* %r */
+    char buf[STRFMT_MAXBUF_NUM];
+    len = (MSize)(lj_strfmt_wshortest(buf, sf, n) - buf);
+    if (!p) p = lj_buf_more(sb, width > len ? width : len);
+    if (!(sf & (STRFMT_F_LEFT | STRFMT_F_ZERO))) {
+      while (width-- > len) *p++ = ' ';
+    }
+    if ((sf & (STRFMT_F_LEFT | STRFMT_F_ZERO)) == STRFMT_F_ZERO) {
+      MSize sign = (buf[0] < '0');  /* Zero padding goes after the sign. */
+      if (sign) *p++ = buf[0];
+      while (width-- > len) *p++ = '0';
+      memcpy(p, buf + sign, len - sign); p += len - sign;
+    } else {
+      memcpy(p, buf, len); p += len;
+    }
   } else if (STRFMT_FP(sf) == STRFMT_FP(STRFMT_T_FP_A)) {
     /* %a */
     const char *hexdig = (sf & STRFMT_F_UPPER) ? "0123456789ABCDEFPX"
@@ -586,7 +1346,7 @@ SBuf *lj_strfmt_putfnum(SBuf *sb, SFormat sf, lua_Number n)
 GCstr * LJ_FASTCALL lj_strfmt_num(lua_State *L, cTValue *o)
 {
   char buf[STRFMT_MAXBUF_NUM];
-  MSize len = (MSize)(lj_strfmt_wfnum(NULL, STRFMT_G14, o->n, buf) - buf);
+  MSize len = (MSize)(lj_strfmt_wfnum(NULL, STRFMT_NUMDEF, o->n, buf) - buf);
   return lj_str_new(L, buf, len);
 }
 
@@ -10,6 +10,7 @@
 
 #include "lj_obj.h"
 #include "lj_char.h"
+#include "lj_strfmt.h"
 #include "lj_strscan.h"
 
 /* -- Scanning numbers ---------------------------------------------------- */
@@ -50,12 +51,14 @@
 ** handles simple integers on-the-fly. Otherwise, it dispatches to the
 ** base-specific parser. Hex and octal is straightforward.
 **
-** Decimal to binary conversion uses a fixed-length circular buffer in
-** base 100. Some simple cases are handled directly. For other cases, the
-** number in the buffer is up-scaled or down-scaled until the integer part
-** is in the proper range. Then the integer part is rounded and converted
-** to a double which is finally rescaled to the result. Denormals need
-** special treatment to prevent incorrect 'double rounding'.
+** Decimal numbers with up to 19 significant digits are usually converted
+** directly with a 128 bit approximation of the power of ten (see below).
+** Otherwise decimal to binary conversion uses a fixed-length circular
+** buffer in base 100. Some simple cases are handled directly. For other
+** cases, the number in the buffer is up-scaled or down-scaled until the
+** integer part is in the proper range. Then the integer part is rounded
+** and converted to a double which is finally rescaled to the result.
+** Denormals need special treatment to prevent incorrect 'double rounding'.
 */
 
 /* Definitions for circular decimal digit buffer (base 100 = 2 digits/byte). */
@@ -177,6 +180,75 @@ static StrScanFmt strscan_oct(const uint8_t *p, TValue *o,
   return fmt;
 }
 
+/* -- Fast decimal conversion --------------------------------------------- */
+
+/*
+** Most decimal numbers have no more than 19 significant digits, i.e. they
+** are w*10^q with w < 2^64. These are converted directly:
+**
+** a) If w is exactly representable and so is 10^q, a single rounded FP
+**    multiply or divide gives the correctly rounded result (Clinger).
+** b) Otherwise w is multiplied with a 128 bit approximation of 10^q
+**    (Eisel-Lemire). This settles the result, unless it's too close to a
+**    halfway case, a denormal or an overflow. These are left to the exact
+**    conversion in strscan_dec().
+*/
+
+static const double strscan_pow10[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/* Count leading zeros of a non-zero 64 bit number. */
+static LJ_AINLINE int32_t strscan_clz64(uint64_t x)
+{
+#if defined(__GNUC__) && LJ_64
+  return (int32_t)__builtin_clzll(x);
+#else
+  return (x>>32) ? 31-(int32_t)lj_fls((uint32_t)(x>>32)) :
+		   63-(int32_t)lj_fls((uint32_t)x);
+#endif
+}
+
+/* Convert w*10^q (w != 0) to double bits. Returns 0 if undecided. */
+static int strscan_fastdec(uint64_t w, int32_t q, uint64_t *bits)
+{
+  const uint64_t *g;
+  uint64_t ghi, glo, hi, lo, m, upperbit;
+  int32_t lz, ex;
+  if (q < STRFMT_POW10_KMIN || q > 308) return 0;
+  g = lj_strfmt_pow10 + 2*(q - STRFMT_POW10_KMIN);
+  ghi = g[0]; glo = g[1];
+  if (q < 0 || q > 55) {  /* Inexact powers are rounded up, truncate them. */
+    if (glo-- == 0) ghi--;
+  }
+  lz = strscan_clz64(w);
+  w <<= lz;
+  hi = lj_strfmt_mul128(w, ghi, &lo);
+  if ((hi & 0x1ff) == 0x1ff && lo + w < lo) {
+    /* Truncation of 10^q may affect the result. Use the lower half, too. */
+    uint64_t lo2, mid = lj_strfmt_mul128(w, glo, &lo2) + lo;
+    if (mid < lo) hi++;
+    if (mid + 1 == 0 && (hi & 0x1ff) == 0x1ff && lo2 + w < lo2) return 0;
+    lo = mid;
+  }
+  upperbit = hi >> 63;
+  m = hi >> (upperbit + 9);
+  lz += (int32_t)(1 ^ upperbit);
+  if (lo == 0 && (hi & 0x1ff) == 0 && (m & 3) == 1)
+    return 0;  /* Possibly halfway between two doubles. */
+  m += m & 1;
+  m >>= 1;
+  if (m >= U64x(00200000,00000000)) {  /* Rounding overflow. */
+    m = U64x(00100000,00000000);
+    lz--;
+  }
+  ex = (((152170 + 65536) * q) >> 16) + 1024 + 63 - lz;
+  if (ex < 1 || ex > 2046) return 0;  /* Denormal or overflow. */
+  *bits = (m & U64x(000fffff,ffffffff)) | ((uint64_t)ex << 52);
+  return 1;
+}
+
 /* Parse decimal number. */
 static StrScanFmt strscan_dec(const uint8_t *p, TValue *o,
 			      StrScanFmt fmt, uint32_t opt,
@@ -184,6 +256,31 @@ static StrScanFmt strscan_dec(const uint8_t *p, TValue *o,
 {
   uint8_t xi[STRSCAN_DDIG], *xip = xi;
 
+  /* Fast path for non-integers with up to 19 significant digits. */
+  if (fmt < STRSCAN_INT && dig) {
+    const uint8_t *pp = p;
+    uint32_t i, n = dig < 19 ? dig : 19;
+    int32_t q = ex10 + (int32_t)(dig - n);
+    uint64_t w = 0, bits, bits2;
+    for (i = 0; i < n; i++, pp++)
+      w = w * 10 + ((*pp != '.' ? *pp : *++pp) & 15);
+    if (dig <= 19 && q >= -22 && q <= 22 && w <= U64x(00200000,00000000)) {
+      double d = (double)(int64_t)w;
+      if (q < 0) d /= strscan_pow10[-q]; else d *= strscan_pow10[q];
+      o->n = neg ? -d : d;
+      return fmt;
+    }
+    /*
+    ** If there are more digits, the result must be the same for both
+    ** truncated and incremented mantissas. strscan_fastdec() needs w != 0.
+    */
+    if (w && strscan_fastdec(w, q, &bits) &&
+	(dig <= 19 || (strscan_fastdec(w+1, q, &bits2) && bits == bits2))) {
+      o->u64 = bits | ((uint64_t)neg << 63);
+      return fmt;
+    }
+  }
+
   if (dig) {
     uint32_t i = dig;
     if (i > STRSCAN_MAXDIG) {
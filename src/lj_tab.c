@@ -52,6 +52,18 @@ static Node *hashkey(const GCtab *t, cTValue *key)
 
 /* -- Table creation and destruction -------------------------------------- */
 
+LJ_STATIC_ASSERT(LJ_MAX_COLOSIZE <= TAB_COLO_AMASK);
+LJ_STATIC_ASSERT(LJ_MAX_COLOHBITS <= 3);
+
+/* Colocated array part still in use? */
+#define tabcoloarr(t)	(tabcoloa(t) && !((t)->colo & TAB_COLO_ASEP))
+/* Colocated hash part follows the (possibly separated) array part. */
+#define tabcolonode(t)	((Node *)((char *)(t) + sizetabcolo(tabcoloa(t))))
+#define tabiscolonode(t, n)	(tabcoloh(t) && (n) == tabcolonode(t))
+/* Size of the table object including all colocated parts. */
+#define sizetabobj(t) \
+  (sizetabcolo(tabcoloa(t)) + (tabcoloh(t) ? sizeof(Node) << tabcoloh(t) : 0))
+
 /* Create new hash part for table. */
 static LJ_AINLINE void newhpart(lua_State *L, GCtab *t, uint32_t hbits)
 {
@@ -61,7 +73,11 @@ static LJ_AINLINE void newhpart(lua_State *L, GCtab *t, uint32_t hbits)
   if (hbits > LJ_MAX_HBITS)
     lj_err_msg(L, LJ_ERR_TABOV);
   hsize = 1u << hbits;
-  node = lj_mem_newvec(L, hsize, Node);
+  /* Use the colocated hash part, unless it's still occupied (by a resize). */
+  if (hbits == tabcoloh(t) && !tabiscolonode(t, noderef(t->node)))
+    node = tabcolonode(t);
+  else
+    node = lj_mem_newvec(L, hsize, Node);
   setmref(t->node, node);
   setfreetop(t, node, &node[hsize]);
   t->hmask = hsize-1;
@@ -100,44 +116,41 @@ static LJ_AINLINE void clearapart(GCtab *t)
 static GCtab *newtab(lua_State *L, uint32_t asize, uint32_t hbits)
 {
   GCtab *t;
-  /* First try to colocate the array part. */
-  if (LJ_MAX_COLOSIZE != 0 && asize > 0 && asize <= LJ_MAX_COLOSIZE) {
-    Node *nilnode;
+  Node *nilnode;
+  uint32_t acolo = 0, hcolo = 0;
+  /* First try to colocate small array and hash parts. E.g. records. */
+  if (LJ_MAX_COLOSIZE != 0 && asize > 0 && asize <= LJ_MAX_COLOSIZE)
+    acolo = asize;
+  if (LJ_MAX_COLOHBITS != 0 && hbits > 0 && hbits <= LJ_MAX_COLOHBITS)
+    hcolo = hbits;
+  if (acolo | hcolo) {
     lua_assert((sizeof(GCtab) & 7) == 0);
-    t = (GCtab *)lj_mem_newgco(L, sizetabcolo(asize));
-    t->gct = ~LJ_TTAB;
-    t->nomm = (uint8_t)~0;
-    t->colo = (int8_t)asize;
-    setmref(t->array, (TValue *)((char *)t + sizeof(GCtab)));
-    setgcrefnull(t->metatable);
-    t->asize = asize;
-    t->hmask = 0;
-    nilnode = &G(L)->nilnode;
-    setmref(t->node, nilnode);
-#if LJ_GC64
-    setmref(t->freetop, nilnode);
-#endif
-  } else {  /* Otherwise separately allocate the array part. */
-    Node *nilnode;
+    t = (GCtab *)lj_mem_newgco(L, sizetabcolo(acolo) +
+				  (hcolo ? sizeof(Node) << hcolo : 0));
+    t->colo = (int8_t)(acolo | (hcolo << TAB_COLO_HSHIFT));
+    setmref(t->array, acolo ? (TValue *)((char *)t + sizeof(GCtab)) : NULL);
+    t->asize = acolo;
+  } else {
     t = lj_mem_newobj(L, GCtab);
-    t->gct = ~LJ_TTAB;
-    t->nomm = (uint8_t)~0;
     t->colo = 0;
     setmref(t->array, NULL);
-    setgcrefnull(t->metatable);
-    t->asize = 0;  /* In case the array allocation fails. */
-    t->hmask = 0;
-    nilnode = &G(L)->nilnode;
-    setmref(t->node, nilnode);
+    t->asize = 0;
+  }
+  t->gct = ~LJ_TTAB;
+  t->nomm = (uint8_t)~0;
+  setgcrefnull(t->metatable);
+  t->hmask = 0;
+  nilnode = &G(L)->nilnode;
+  setmref(t->node, nilnode);
 #if LJ_GC64
-    setmref(t->freetop, nilnode);
+  t->lenhint = 0;
+  setmref(t->freetop, nilnode);
 #endif
-    if (asize > 0) {
-      if (asize > LJ_MAX_ASIZE)
-	lj_err_msg(L, LJ_ERR_TABOV);
-      setmref(t->array, lj_mem_newvec(L, asize, TValue));
-      t->asize = asize;
-    }
+  if (asize > 0 && !acolo) {  /* Otherwise separately allocate the array. */
+    if (asize > LJ_MAX_ASIZE)
+      lj_err_msg(L, LJ_ERR_TABOV);
+    setmref(t->array, lj_mem_newvec(L, asize, TValue));
+    t->asize = asize;
   }
   if (hbits)
     newhpart(L, t, hbits);
@@ -233,12 +246,12 @@ void LJ_FASTCALL lj_tab_clear(GCtab *t)
 /* Free a table. */
 void LJ_FASTCALL lj_tab_free(global_State *g, GCtab *t)
 {
-  if (t->hmask > 0)
+  if (t->hmask > 0 && !tabiscolonode(t, noderef(t->node)))
     lj_mem_freevec(g, noderef(t->node), t->hmask+1, Node);
-  if (t->asize > 0 && LJ_MAX_COLOSIZE != 0 && t->colo <= 0)
+  if (t->asize > 0 && !tabcoloarr(t))
     lj_mem_freevec(g, tvref(t->array), t->asize, TValue);
-  if (LJ_MAX_COLOSIZE != 0 && t->colo)
-    lj_mem_free(g, t, sizetabcolo((uint32_t)t->colo & 0x7f));
+  if (t->colo)
+    lj_mem_free(g, t, sizetabobj(t));
   else
     lj_mem_freet(g, t);
   g->gc.tabnum--;
@@ -257,11 +270,11 @@ void lj_tab_resize(lua_State *L, GCtab *t, uint32_t asize, uint32_t hbits)
     uint32_t i;
     if (asize > LJ_MAX_ASIZE)
       lj_err_msg(L, LJ_ERR_TABOV);
-    if (LJ_MAX_COLOSIZE != 0 && t->colo > 0) {
+    if (tabcoloarr(t)) {
       /* A colocated array must be separated and copied. */
       TValue *oarray = tvref(t->array);
       array = lj_mem_newvec(L, asize, TValue);
-      t->colo = (int8_t)(t->colo | 0x80);  /* Mark as separated (colo < 0). */
+      t->colo = (int8_t)(t->colo | TAB_COLO_ASEP);  /* Mark as separated. */
       for (i = 0; i < oldasize; i++)
 	copyTV(L, &array[i], &oarray[i]);
     } else {
@@ -293,7 +306,7 @@ void lj_tab_resize(lua_State *L, GCtab *t, uint32_t asize, uint32_t hbits)
       if (!tvisnil(&array[i]))
 	copyTV(L, lj_tab_setinth(L, t, (int32_t)i), &array[i]);
     /* Physically shrink only separated arrays. */
-    if (LJ_MAX_COLOSIZE != 0 && t->colo <= 0)
+    if (!tabcoloarr(t))
       setmref(t->array, lj_mem_realloc(L, array,
 	      oldasize*sizeof(TValue), asize*sizeof(TValue)));
   }
@@ -306,7 +319,8 @@ void lj_tab_resize(lua_State *L, GCtab *t, uint32_t asize, uint32_t hbits)
 	copyTV(L, lj_tab_set(L, t, &n->key), &n->val);
     }
     g = G(L);
-    lj_mem_freevec(g, oldnode, oldhmask+1, Node);
+    if (!tabiscolonode(t, oldnode))
+      lj_mem_freevec(g, oldnode, oldhmask+1, Node);
   }
 }
 
@@ -376,7 +390,7 @@ static uint32_t bestasize(uint32_t bins[], uint32_t *narray)
 static void rehashtab(lua_State *L, GCtab *t, cTValue *ek)
 {
   uint32_t bins[LJ_MAX_ABITS];
-  uint32_t total, asize, na, i;
+  uint32_t total, asize, na, i, hbits;
   for (i = 0; i < LJ_MAX_ABITS; i++) bins[i] = 0;
   asize = countarray(t, bins);
   total = 1 + asize;
@@ -384,7 +398,16 @@ static void rehashtab(lua_State *L, GCtab *t, cTValue *ek)
   asize += countint(ek, bins);
   na = bestasize(bins, &asize);
   total -= na;
-  lj_tab_resize(L, t, asize, hsize2hbits(total));
+  hbits = hsize2hbits(total);
+  /*
+  ** The hash part doesn't grow, so it has been filled up by key churn,
+  ** i.e. new keys inserted after others have been deleted. Leave enough
+  ** free nodes, or it's rehashed again after only a few insertions.
+  */
+  if (hbits > 0 && hbits < LJ_MAX_HBITS && t->hmask > 0 &&
+      hbits <= lj_fls(t->hmask)+1 && total > (3u << hbits) / 4)
+    hbits++;
+  lj_tab_resize(L, t, asize, hbits);
 }
 
 #if LJ_HASFFI
@@ -692,24 +715,106 @@ static MSize unbound_search(GCtab *t, MSize j)
   return i;
 }
 
+/*
+** The last boundary is only remembered with LJ_GC64, where t->lenhint
+** fills padding in GCtab. The 32 byte GCtab of the other builds has no
+** room left for it, so they always search for the boundary.
+*/
+#if LJ_GC64
+/* Check whether i is a boundary, by looking at the array part only. */
+static LJ_AINLINE int isborder(GCtab *t, MSize i)
+{
+  MSize asize = t->asize;
+  if (i+1 < asize)
+    return (i == 0 || !tvisnil(arrayslot(t, i))) &&
+	   tvisnil(arrayslot(t, i+1));
+  return i+1 == asize && t->hmask == 0 &&
+	 (i == 0 || !tvisnil(arrayslot(t, i)));
+}
+#endif
+
 /*
 ** Try to find a boundary in table `t'. A `boundary' is an integer index
 ** such that t[i] is non-nil and t[i+1] is nil (and 0 if t[1] is nil).
 */
 MSize LJ_FASTCALL lj_tab_len(GCtab *t)
 {
-  MSize j = (MSize)t->asize;
+  MSize j;
+#if LJ_GC64
+  j = t->lenhint;
+  /* Most likely the last boundary is still valid or has moved by one. */
+  if (LJ_LIKELY(isborder(t, j)))
+    return j;
+  if (isborder(t, j+1)) {  /* Appended an element. */
+    t->lenhint = j+1;
+    return j+1;
+  }
+  if (j > 0 && isborder(t, j-1)) {  /* Removed the last element. */
+    t->lenhint = j-1;
+    return j-1;
+  }
+#endif
+  j = (MSize)t->asize;
   if (j > 1 && tvisnil(arrayslot(t, j-1))) {
     MSize i = 1;
     while (j - i > 1) {
       MSize m = (i+j)/2;
       if (tvisnil(arrayslot(t, m-1))) j = m; else i = m;
     }
-    return i-1;
+    j = i-1;
+  } else {
+    if (j) j--;
+    if (t->hmask > 0)
+      return unbound_search(t, j);  /* Not in the array part. */
   }
-  if (j) j--;
-  if (t->hmask <= 0)
-    return j;
-  return unbound_search(t, j);
+#if LJ_GC64
+  t->lenhint = j;
+#endif
+  return j;
 }
 
+/* -- Bulk operations ----------------------------------------------------- */
+
+/*
+** Move the elements st[f..e] to dt[t..]. This is a raw operation, i.e.
+** the caller must check for __index/__newindex metamethods. Returns 0
+** if the ranges are invalid (and nothing was moved), 1 otherwise.
+*/
+int lj_tab_move(lua_State *L, GCtab *dt, GCtab *st,
+		int32_t f, int32_t e, int32_t t)
+{
+  uint32_t n, i;
+  if (e < f)
+    return 1;
+  if (!(f > 0 || e < INT_MAX + f))
+    return 0;  /* Too many elements to move. */
+  n = (uint32_t)(e - f) + 1;
+  if (t > INT_MAX - (int32_t)n + 1)
+    return 0;  /* Destination wrap around. */
+  if (f >= 0 && (uint32_t)e < st->asize && t >= 0) {
+    /* Grow the destination array part, if the range adjoins it. */
+    if ((uint32_t)t <= dt->asize+1 && (uint64_t)t + n > dt->asize &&
+	(uint64_t)t + n <= LJ_MAX_ASIZE)
+      lj_tab_reasize(L, dt, (uint32_t)t + n-1);
+    if ((uint64_t)t + n <= dt->asize) {  /* Both ranges in the array part. */
+      memmove(arrayslot(dt, t), arrayslot(st, f), n*sizeof(TValue));
+      lj_gc_anybarriert(L, dt);
+      return 1;
+    }
+  }
+  for (i = 0; i < n; i++) {
+    /* Copy backwards, if the ranges overlap and the destination is above. */
+    uint32_t k = (dt == st && t > f && t <= e) ? n-1-i : i;
+    cTValue *o = lj_tab_getint(st, f + (int32_t)k);
+    if (o && !tvisnil(o)) {
+      TValue tmp;
+      copyTV(L, &tmp, o);  /* Setting a new key may rehash st. */
+      copyTV(L, lj_tab_setint(L, dt, t + (int32_t)k), &tmp);
+    } else {
+      TValue *v = (TValue *)lj_tab_getint(dt, t + (int32_t)k);
+      if (v) setnilV(v);
+    }
+  }
+  lj_gc_anybarriert(L, dt);
+  return 1;
+}
@@ -69,5 +69,7 @@ LJ_FUNC TValue *lj_tab_set(lua_State *L, GCtab *t, cTValue *key);
 
 LJ_FUNCA int lj_tab_next(lua_State *L, GCtab *t, TValue *key);
 LJ_FUNCA MSize LJ_FASTCALL lj_tab_len(GCtab *t);
+LJ_FUNCA int lj_tab_move(lua_State *L, GCtab *dt, GCtab *st,
+			 int32_t f, int32_t e, int32_t t);
 
 #endif
@@ -287,6 +287,8 @@ typedef enum {
   XO_MOVSSto =	XO_f30f(11),
   XO_MOVLPD =	XO_660f(12),
   XO_MOVAPS =	XO_0f(28),
+  XO_MOVUPS =	XO_0f(10),
+  XO_MOVUPSto =	XO_0f(11),
   XO_XORPS =	XO_0f(57),
   XO_ANDPS =	XO_0f(54),
   XO_ADDSD =	XO_f20f(58),
@@ -307,6 +309,9 @@ typedef enum {
   XO_ADDSS =	XO_f30f(58),
   XO_MOVD =	XO_660f(6e),
   XO_MOVDto =	XO_660f(7e),
+  XO_PUNPCKLBW=	XO_660f(60),
+  XO_PUNPCKLQDQ=	XO_660f(6c),
+  XO_PSHUFLW =	XO_f20f(70),
 
   XO_FLDd =	XO_(d9), XOg_FLDd = 0,
   XO_FLDq =	XO_(dd), XOg_FLDq = 0,
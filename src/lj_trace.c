@@ -737,15 +737,36 @@ void lj_trace_ins(jit_State *J, const BCIns *pc)
     J->state = LJ_TRACE_ERR;
 }
 
+/* Check the bytecode triggering a hot counter against the previous one.
+** A different bytecode means the hashed counter is shared by unrelated
+** loops or calls and the trigger may be a false one. Hot loops sharing
+** a counter may alternate forever, so accept the trigger after too many
+** failed verifications.
+*/
+static int trace_hotverify(jit_State *J, const BCIns *pc)
+{
+  MRef *ref = &hotpc_get(J2GG(J), pc);
+  uint8_t *miss = &hotmiss_get(J2GG(J), pc);
+  const BCIns *opc = mref(*ref, const BCIns);
+  setmref(*ref, pc);
+  if (opc != pc) {
+    if (opc) J->nhotcollide++;
+    if (J->param[JIT_P_hotverify] && ++*miss < HOTVERIFY_MAXMISS)
+      return 0;
+  }
+  *miss = 0;
+  return 1;
+}
+
 /* A hotcount triggered. Start recording a root trace. */
 void LJ_FASTCALL lj_trace_hot(jit_State *J, const BCIns *pc)
 {
   /* Note: pc is the interpreter bytecode PC here. It's offset by 1. */
   ERRNO_SAVE
   /* Reset hotcount. */
-  hotcount_set(J2GG(J), pc, J->param[JIT_P_hotloop]*HOTCOUNT_LOOP);
+  hotcount_set(J2GG(J), pc, hotcount_start(J));
   /* Only start a new trace if not recording or inside __gc call or vmevent. */
-  if (J->state == LJ_TRACE_IDLE &&
+  if (trace_hotverify(J, pc) && J->state == LJ_TRACE_IDLE &&
       !(J2G(J)->hookmask & (HOOK_GC|HOOK_VMEVENT))) {
     J->parent = 0;  /* Root trace. */
     J->exitno = 0;
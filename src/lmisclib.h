@@ -56,6 +56,17 @@ struct luam_Metrics {
   size_t jit_mcode_size;
   /* Amount of JIT traces. */
   unsigned int jit_trace_num;
+
+  /* Number of small cdata allocations reusing a freed object. */
+  size_t gc_cdatapool_hit;
+  /* Number of small cdata allocations from the allocator. */
+  size_t gc_cdatapool_miss;
+
+  /*
+  ** Number of hot counter triggers by a different bytecode than the
+  ** previous trigger of the same hashed counter (possibly false ones).
+  */
+  size_t jit_hotcount_collisions;
 };
 
 LUAMISC_API void luaM_metrics(lua_State *L, struct luam_Metrics *metrics);
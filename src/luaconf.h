@@ -75,6 +75,7 @@
 #define LUA_PATH	"LUA_PATH"
 #define LUA_CPATH	"LUA_CPATH"
 #define LUA_INIT	"LUA_INIT"
+#define LUA_BCCACHE	"LUA_BCCACHE"
 
 /* Special file system characters. */
 #if defined(_WIN32)
@@ -64,6 +64,10 @@ enum {
 /* Control the JIT engine. */
 LUA_API int luaJIT_setmode(lua_State *L, int idx, int mode);
 
+/* Load a chunk consisting of a single literal and push its value. */
+LUA_API int luaJIT_loaddata(lua_State *L, lua_Reader reader, void *data,
+			    const char *chunkname);
+
 /* Low-overhead profiling API. */
 typedef void (*luaJIT_profile_callback)(void *data, lua_State *L,
 					int samples, int vmstate);
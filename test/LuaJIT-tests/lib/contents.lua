@@ -105,7 +105,7 @@ do --- io
 end
 
 do --- io file
-  check(debug.getmetatable(io.stdin), "__gc:__index:__tostring:close:flush:lines:read:seek:setvbuf:write")
+  check(debug.getmetatable(io.stdin), "__gc:__index:__tostring:close:flush:lines:read:seek:setvbuf:write", "readinto:writefrom")
 end
 
 -- Test is disabled for the Tarantool's binary,
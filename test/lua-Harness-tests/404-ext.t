@@ -66,7 +66,7 @@ do -- table.clear
 end
 
 -- table.clone
-if profile.openresty then
+if profile.openresty or profile.has_table_clone then
     local r, clone = pcall(require, 'table.clone')
     is_true(r, 'table.clone')
     is_function(clone)
@@ -37,6 +37,7 @@ local profile = {
 -- [[ luajit
     luajit_compat52 = true,
     openresty = false,
+    has_table_clone = true,
 --]]
 
 }
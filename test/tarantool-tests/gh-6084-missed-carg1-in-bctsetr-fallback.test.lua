@@ -6,7 +6,7 @@ test:plan(2)
 
 -- XXX: Bytecode TSETR appears only in built-ins libraries, when
 -- doing fixups for fast function written in Lua (i.e.
--- `table.move()`), by replacing all TSETV bytecodes with
+-- `table.remove()`), by replacing all TSETV bytecodes with
 -- the TSETR. See <src/host/genlibbc.lua> for more details.
 
 -- This test checks that fallback path, when the index of the new
@@ -15,13 +15,15 @@ test:plan(2)
 
 -- XXX: We need to make sure the bytecode is present in the chosen
 -- built-in to make sure our test is still valid.
-assert(utils.hasbc(table.move, 'TSETR'))
+assert(utils.hasbc(table.remove, 'TSETR'))
 
--- `t` table asize equals 1. Just copy its first element (1)
--- to the field by index 2 > 1, to fallback inside TSETR.
-local t = {1}
-local res = table.move(t, 1, 1, 2)
-test:ok(t == res, 'table.move returns the same table')
-test:ok(t[1] == t[2], 'table.move is correct')
+-- `t` table asize equals 0, all its elements are in the hash
+-- part. Removing the first element shifts the other ones down
+-- by TSETR, which falls back for any index.
+local t = require('table.new')(0, 4)
+t[1], t[2], t[3] = 1, 2, 3
+local res = table.remove(t, 1)
+test:ok(res == 1, 'table.remove returns the removed element')
+test:ok(t[1] == 2 and t[2] == 3 and t[3] == nil, 'table.remove is correct')
 
 os.exit(test:check() and 0 or 1)
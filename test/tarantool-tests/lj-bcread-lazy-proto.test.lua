@@ -0,0 +1,100 @@
+local tap = require('tap')
+
+-- Test file to check that the child prototypes of the large
+-- bytecode files loaded via <loadfile> are materialized on
+-- demand correctly.
+
+local test = tap.test('lj-bcread-lazy-proto')
+test:plan(11)
+
+local TMP_BCFILE = os.tmpname()
+
+-- XXX: The file should be large enough to be read in a single
+-- chunk by <luaL_loadfilex>, so generate a bunch of unused
+-- functions.
+local NFUNCS = 5000
+
+local chunk = {
+  'local M = {}',
+  'local uv = 42',
+  'function M.add(a, b) return a + b + uv end',
+  'function M.vararg(...) return select("#", ...), ... end',
+  'function M.nested(x)',
+  '  local function inner(y)',
+  '    return function() return x + y end',
+  '  end',
+  '  return inner(x)',
+  'end',
+  'function M.line() error("lazy") end',
+  'function M.ktab() return {1, 2, k = "v", [true] = 0.5} end',
+  'function M.setuv(v) uv = v end',
+}
+for i = 1, NFUNCS do
+  chunk[#chunk + 1] = ('function M.f%d(a) return a .. "s%d" end'):format(i, i)
+end
+chunk[#chunk + 1] = 'return M'
+local src = table.concat(chunk, '\n')
+
+local function save(strip)
+  local fh = assert(io.open(TMP_BCFILE, 'wb'))
+  fh:write(string.dump(assert(loadstring(src, '@lazy.lua')), strip))
+  fh:close()
+end
+
+save(false)
+local M = assert(loadfile(TMP_BCFILE))()
+
+test:is(M.add(1, 2), 45, 'upvalues of the lazy prototype')
+test:is(select(4, M.vararg(1, 2, 3)), 3, 'vararg lazy prototype')
+test:is(M.nested(5)(), 10, 'nested lazy prototypes')
+local t = M.ktab()
+test:ok(t[2] == 2 and t.k == 'v' and t[true] == 0.5,
+        'template table of the lazy prototype')
+M.setuv(0)
+test:is(M.add(1, 2), 3, 'shared upvalue of the lazy prototypes')
+
+local _, err = pcall(M.line)
+test:like(err, '^lazy.lua:11: lazy', 'debug info of the lazy prototype')
+
+-- Check that the functions with lazy children are dumped and
+-- loaded again.
+local M2 = assert(loadstring(string.dump(M.nested)))
+test:is(M2(1)() , 2, 'string.dump of the lazy prototypes')
+
+-- Check that lazy prototypes are accessible via reflection API.
+local main = assert(loadfile(TMP_BCFILE))
+local funck = require('jit.util').funck
+local nproto = 0
+for i = -1, -math.huge, -1 do
+  local k = funck(main, i)
+  if k == nil then break end
+  if type(k) == 'proto' then
+    local info = require('jit.util').funcinfo(k)
+    if info.bytecodes > 0 then nproto = nproto + 1 end
+  end
+end
+test:is(nproto, NFUNCS + 6, 'jit.util.funck materializes prototypes')
+
+-- Check the stripped dump.
+save(true)
+M = assert(loadfile(TMP_BCFILE))()
+test:is(M.nested(1)(), 2, 'stripped lazy prototypes')
+
+-- Check that a truncated dump is rejected.
+local fh = assert(io.open(TMP_BCFILE, 'wb'))
+local dump = string.dump(assert(loadstring(src, '@lazy.lua')))
+fh:write(dump:sub(1, #dump - 100))
+fh:close()
+M, err = loadfile(TMP_BCFILE)
+test:ok(M == nil and err:match('malformed bytecode'), 'truncated dump')
+
+-- Check that the large source file is loaded as usual.
+fh = assert(io.open(TMP_BCFILE, 'wb'))
+fh:write(src)
+fh:close()
+M = assert(loadfile(TMP_BCFILE))()
+test:is(M.nested(2)(), 4, 'large source file')
+
+os.remove(TMP_BCFILE)
+
+os.exit(test:check() and 0 or 1)
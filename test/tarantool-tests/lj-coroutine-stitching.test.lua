@@ -0,0 +1,63 @@
+local tap = require('tap')
+
+-- Test file to check that coroutine switches are stitched
+-- instead of aborting the trace and coroutine.running() is
+-- recorded.
+
+local test = tap.test('lj-coroutine-stitching')
+test:plan(6)
+
+-- XXX: Make the stitched traces "too short" to be compiled, so
+-- the other NYI fast functions abort the recording, while the
+-- coroutine switches ignore minstitch and are still stitched.
+jit.opt.start('hotloop=1', 'minstitch=100')
+
+local NTEST = 100
+
+jit.flush()
+local aborts = misc.getmetrics().jit_trace_abort
+local gen = coroutine.wrap(function()
+  for i = 1, math.huge do coroutine.yield(i) end
+end)
+local sum = 0
+for _ = 1, NTEST do
+  sum = sum + gen()
+end
+test:is(sum, NTEST * (NTEST + 1) / 2, 'correct generator results')
+test:is(misc.getmetrics().jit_trace_abort, aborts,
+        'no trace aborts for coroutine switches')
+
+local co = coroutine.create(function(n)
+  local x = 0
+  while true do x = x + coroutine.yield(x + n) end
+end)
+jit.flush()
+aborts = misc.getmetrics().jit_trace_abort
+local res = {}
+for i = 1, NTEST do
+  local ok, v = coroutine.resume(co, i)
+  res[i] = ok and v
+end
+local new_aborts = misc.getmetrics().jit_trace_abort
+local ok_all = true
+for i = 1, NTEST do
+  -- The first resume passes n = 1, the others are accumulated
+  -- into x: 1 + (2 + ... + i).
+  ok_all = ok_all and res[i] == i * (i + 1) / 2
+end
+test:ok(ok_all, 'correct producer/consumer results')
+test:is(new_aborts, aborts, 'no trace aborts for coroutine.resume()')
+
+-- Compile the trace in the main thread and run it in the
+-- coroutine and vice versa.
+local function running(n)
+  local r
+  for _ = 1, n do r = coroutine.running() end
+  return r
+end
+test:is(running(NTEST), nil, 'coroutine.running() in the main thread')
+local th
+th = coroutine.create(function() return running(NTEST) == th end)
+test:ok(select(2, coroutine.resume(th)), 'coroutine.running() in coroutine')
+
+os.exit(test:check() and 0 or 1)
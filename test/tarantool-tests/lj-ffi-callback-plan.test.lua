@@ -0,0 +1,62 @@
+local tap = require('tap')
+local ffi = require('ffi')
+
+-- Test file to check the precomputed argument conversions of FFI
+-- callbacks.
+
+local test = tap.test('lj-ffi-callback-plan')
+test:plan(8)
+
+ffi.cdef([[
+  typedef enum { CB_RED = 1, CB_BLUE = 2 } cb_color;
+]])
+
+local function roundtrip(sig, ...)
+  local args
+  local cb = ffi.cast(sig, function(...)
+    args = {...}
+    return 0
+  end)
+  cb(...)
+  cb:free()
+  return args
+end
+
+local a = roundtrip(
+  'int (*)(int8_t, uint8_t, int16_t, uint16_t, int32_t, uint32_t)',
+  -5, 250, -30000, 65000, -2^31, 2^32 - 1
+)
+test:is_deeply(a, {-5, 250, -30000, 65000, -2^31, 2^32 - 1},
+               'integer arguments')
+
+a = roundtrip('int (*)(float, double, bool, bool)', 0.5, 1e300, true, false)
+test:is_deeply(a, {0.5, 1e300, true, false}, 'FP and bool arguments')
+
+local buf = ffi.new('int[1]')
+a = roundtrip('int (*)(int *, const char *, int64_t, cb_color)',
+              buf, nil, -2^40, 'CB_BLUE')
+test:ok(a[1] == buf and a[2] == nil and a[3] == -2^40 and a[4] == 2,
+        'pointer, 64 bit and enum arguments')
+test:ok(ffi.istype('int *', a[1]), 'pointer argument type')
+
+-- More arguments than registers: the rest is passed on the stack.
+local sig = 'int (*)(' .. ('int, double, '):rep(7) .. 'double, double)'
+local vals = {}
+for i = 1, 16 do vals[i] = (i % 2 == 1 and i < 15) and i or i + 0.5 end
+test:is_deeply(roundtrip(sig, unpack(vals)), vals, 'stack arguments')
+
+-- Reuse of a freed slot for a different function type.
+local sum1 = ffi.cast('int (*)(int, int)', function(x, y) return x + y end)
+test:is(sum1(2, 3), 5, 'first callback')
+sum1:free()
+local sum2 = ffi.cast('double (*)(double, int, double)',
+                      function(x, y, z) return x + y + z end)
+test:is(sum2(0.25, 2, 0.5), 2.75, 'reused slot with another type')
+sum2:free()
+
+-- Results are converted like before.
+local res = ffi.cast('int (*)(double)', function(x) return x end)
+test:is(res(-7.9), -7, 'int result is truncated')
+res:free()
+
+os.exit(test:check() and 0 or 1)
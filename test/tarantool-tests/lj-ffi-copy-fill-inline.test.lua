@@ -0,0 +1,138 @@
+local tap = require('tap')
+local ffi = require('ffi')
+local jutil = require('jit.util')
+local vmdef = require('jit.vmdef')
+
+-- Test file to check ffi.copy() and ffi.fill() with a constant
+-- length which is too big to be unrolled by the recorder. Such
+-- calls are emitted inline by the x86/x64 backend.
+
+local test = tap.test('lj-ffi-copy-fill-inline')
+
+-- Lengths around the borders of 16 byte moves and the inlining
+-- limit.
+local LENS = {16, 17, 31, 129, 143, 144, 150, 159, 160, 161}
+local BUFSZ = 200
+local NTEST = 100
+
+-- Lengths around the borders of the recorder unrolling and the
+-- inline 16 byte moves.
+local MCODE_LENS = {15, 16, 17, 128, 129, 159, 160, 161}
+local HAS_MCODE_CHECKS = jit.arch == 'x86' or jit.arch == 'x64'
+
+test:plan(3 * #LENS + (HAS_MCODE_CHECKS and 2 * #MCODE_LENS or 0))
+
+jit.opt.start('hotloop=1')
+
+local src = ffi.new('uint8_t[?]', BUFSZ)
+local dst = ffi.new('uint8_t[?]', BUFSZ)
+for i = 0, BUFSZ - 1 do src[i] = i % 251 end
+
+-- Compile a loop with the given literal length, so it becomes
+-- a constant on the trace.
+local function compile(fmt, len)
+  local chunk = fmt:gsub('LEN', tostring(len))
+  return assert(loadstring(chunk))()
+end
+
+local COPY = [[
+  local ffi = require('ffi')
+  return function(dst, src, n)
+    for _ = 1, n do ffi.copy(dst + 3, src + 1, LEN) end
+  end
+]]
+
+local FILL = [[
+  local ffi = require('ffi')
+  return function(dst, n, c)
+    for i = 1, n do ffi.fill(dst + 5, LEN, c + i) end
+  end
+]]
+
+local ZERO = [[
+  local ffi = require('ffi')
+  return function(dst, n)
+    for _ = 1, n do ffi.fill(dst + 5, LEN) end
+  end
+]]
+
+-- Check the destination buffer against the expected byte
+-- function. Returns the first mismatch or nil.
+local function mismatch(expected)
+  for i = 0, BUFSZ - 1 do
+    if dst[i] ~= expected(i) then return i end
+  end
+end
+
+for _, len in ipairs(LENS) do
+  ffi.fill(dst, BUFSZ, 0xee)
+  compile(COPY, len)(dst, src, NTEST)
+  test:is(mismatch(function(i)
+    return (i >= 3 and i < 3 + len) and src[i - 2] or 0xee
+  end), nil, ('copy %d bytes'):format(len))
+
+  ffi.fill(dst, BUFSZ, 0xee)
+  -- The fill value is truncated to a byte.
+  compile(FILL, len)(dst, NTEST, 0x1a0)
+  test:is(mismatch(function(i)
+    return (i >= 5 and i < 5 + len) and (0xa0 + NTEST) % 256 or 0xee
+  end), nil, ('fill %d bytes'):format(len))
+
+  ffi.fill(dst, BUFSZ, 0xee)
+  compile(ZERO, len)(dst, NTEST)
+  test:is(mismatch(function(i)
+    return (i >= 5 and i < 5 + len) and 0 or 0xee
+  end), nil, ('zero %d bytes'):format(len))
+end
+
+-- Check how a call with the given length is compiled on x86/x64:
+-- unrolled by the recorder (no call in the IR), inlined by the
+-- backend (a call in the IR, but MOVUPS instead of a call in the
+-- machine code) or left as a call.
+local function how_compiled(fmt, len, ...)
+  jit.flush()
+  compile(fmt, len)(...)
+  -- The looping trace is the one for the call.
+  local tr = 1
+  while jutil.traceinfo(tr).linktype ~= 'loop' do tr = tr + 1 end
+  local info = jutil.traceinfo(tr)
+  local has_ircall = false
+  for ref = 1, info.nins - 1 do
+    local _, ot, _, op2 = jutil.traceir(tr, ref)
+    local o = math.floor(ot / 256)
+    if vmdef.irnames:sub(o * 6 + 1, o * 6 + 4) == 'CALL' then
+      local name = vmdef.ircall[op2]
+      if name == 'memcpy' or name == 'memset' then has_ircall = true end
+    end
+  end
+  local mcode, addr = jutil.tracemc(tr)
+  local asm = {}
+  require('jit.dis_' .. jit.arch).disass(mcode, addr, function(line)
+    asm[#asm + 1] = line
+  end)
+  asm = table.concat(asm)
+  if not has_ircall then
+    return 'unrolled'
+  elseif asm:find('movups') and not asm:find('call') then
+    return 'inlined'
+  end
+  return 'call'
+end
+
+if HAS_MCODE_CHECKS then
+  -- The recorder unrolls up to 16 pointer-sized moves, the backend
+  -- inlines memcpy/memset calls of 16 up to 160 bytes.
+  local UNROLL_MAXLEN = 16 * ffi.sizeof('void *')
+  local function expected(len)
+    if len <= UNROLL_MAXLEN then return 'unrolled' end
+    return len <= 160 and 'inlined' or 'call'
+  end
+  for _, len in ipairs(MCODE_LENS) do
+    test:is(how_compiled(COPY, len, dst, src, NTEST), expected(len),
+            ('copy %d bytes is %s'):format(len, expected(len)))
+    test:is(how_compiled(FILL, len, dst, NTEST, 0x1a0), expected(len),
+            ('fill %d bytes is %s'):format(len, expected(len)))
+  end
+end
+
+os.exit(test:check() and 0 or 1)
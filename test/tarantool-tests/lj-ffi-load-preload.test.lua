@@ -0,0 +1,56 @@
+require('utils').skipcond(jit.os ~= 'Linux',
+                          'Dynamic symbol table preloading is Linux-only')
+
+local tap = require('tap')
+local ffi = require('ffi')
+
+-- Test file to check `ffi.load()` with the `preload` option.
+
+local test = tap.test('lj-ffi-load-preload')
+test:plan(10)
+
+ffi.cdef([[
+  double sin(double);
+  double cos(double);
+  double erand48(unsigned short xsubi[3]);
+]])
+
+local plain = ffi.load('m')
+local preloaded = ffi.load('m', {preload = true})
+
+test:is(preloaded.sin(0.5), math.sin(0.5), 'preloaded function call')
+test:is(preloaded.cos(0.5), math.cos(0.5), 'second preloaded function call')
+test:is(type(preloaded.sin), 'cdata', 'resolved symbol is cdata')
+test:ok(ffi.typeof(preloaded.sin) == ffi.typeof(plain.sin),
+        'resolved symbol has the declared type')
+test:ok(ffi.cast('void *', preloaded.sin) == ffi.cast('void *', plain.sin),
+        'same address as with dlsym()')
+
+-- Undeclared symbols must still raise an error, even if the
+-- library exports them.
+local ok, err = pcall(function() return preloaded.tan end)
+test:ok(not ok and err:match('missing declaration'),
+        'undeclared symbol raises an error')
+
+-- Symbols not defined by the library itself fall back to
+-- `dlsym()`.
+ffi.cdef('int printf(const char *, ...);')
+local okp = pcall(function() return preloaded.printf end)
+local okd = pcall(function() return plain.printf end)
+test:is(okp, okd, 'fallback to dlsym() for other symbols')
+
+-- The options table also accepts the `global` flag.
+test:ok(pcall(ffi.load, 'm', {global = true, preload = true}),
+        'global and preload options')
+
+-- The preloaded addresses are not reachable from Lua, but are
+-- kept alive by the namespace.
+local lib = ffi.load('m', {preload = true})
+test:is(getmetatable(debug.getfenv(lib)), nil,
+        'preloaded addresses are not exposed')
+collectgarbage()
+collectgarbage()
+test:ok(ffi.cast('void *', lib.cos) == ffi.cast('void *', plain.cos),
+        'preloaded addresses survive GC')
+
+os.exit(test:check() and 0 or 1)
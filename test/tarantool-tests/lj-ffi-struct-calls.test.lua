@@ -0,0 +1,138 @@
+local tap = require('tap')
+local ffi = require('ffi')
+local traceinfo = require('jit.util').traceinfo
+
+-- Test file to check that C calls passing or returning structs
+-- by value are compiled.
+
+local test = tap.test('lj-ffi-struct-calls')
+test:plan(12)
+
+ffi.cdef([[
+  struct pair { int32_t a, b; };
+  struct rgba { uint8_t r, g, b, a; };
+  struct half { int16_t v; };
+  struct byte { uint8_t v; };
+  struct vec2 { float x, y; };
+  struct flt { float v; };
+  struct dbl { double v; };
+  struct big { int64_t a, b, c; };
+  union fltdbl { float f; double d; };
+
+  struct pair pair_swap(struct pair p);
+  struct rgba rgba_invert(struct rgba c);
+  struct half half_neg(struct half h);
+  struct byte byte_inc(struct byte b);
+  struct vec2 vec2_scale(struct vec2 v, float k);
+  struct flt flt_add(struct flt a, struct flt b);
+  struct dbl dbl_mul(struct dbl a, double k);
+  union fltdbl fltdbl_twice(union fltdbl u, double k);
+  complex float cplx_conj(complex float z);
+  struct big big_make(int64_t a, int64_t b, int64_t c);
+  int64_t big_sum(const struct big *p);
+]])
+
+local lib = ffi.load('libstructcall')
+
+local NTEST = 100
+
+jit.opt.start('hotloop=1')
+
+-- Run the given function in a loop with and without JIT and
+-- check that both modes agree. Also check that the loop is
+-- compiled, i.e. the C call doesn't abort the recording.
+local function check(name, f)
+  -- Resolve the C symbols first, since the recording of the
+  -- namespace lookup is aborted otherwise.
+  f(0)
+  jit.flush()
+  local res = {}
+  for i = 1, NTEST do res[i] = f(i) end
+  local ok = false
+  for tr = 1, 10 do
+    local info = traceinfo(tr)
+    if not info then break end
+    ok = ok or info.linktype == 'loop'
+  end
+  jit.off()
+  for i = 1, NTEST do ok = ok and res[i] == f(i) end
+  jit.on()
+  test:ok(ok, name)
+end
+
+local pair = ffi.new('struct pair')
+check('int32 pair', function(i)
+  pair.a, pair.b = i, -i
+  local r = lib.pair_swap(pair)
+  return r.a * 1000 + r.b
+end)
+
+local rgba = ffi.new('struct rgba')
+check('four bytes', function(i)
+  rgba.r, rgba.g, rgba.b, rgba.a = i, i + 1, 255 - i, i % 7
+  local r = lib.rgba_invert(rgba)
+  return r.r + r.g * 2^8 + r.b * 2^16 + r.a * 2^24
+end)
+
+local half = ffi.new('struct half')
+check('int16', function(i)
+  half.v = i * 300
+  return lib.half_neg(half).v
+end)
+
+local byte = ffi.new('struct byte')
+check('uint8', function(i)
+  byte.v = i + 150
+  return lib.byte_inc(byte).v
+end)
+
+local vec2 = ffi.new('struct vec2')
+check('float pair', function(i)
+  vec2.x, vec2.y = i, i + 0.5
+  local r = lib.vec2_scale(vec2, 0.25)
+  return r.x * 1000 + r.y
+end)
+
+local flt1, flt2 = ffi.new('struct flt'), ffi.new('struct flt')
+check('float', function(i)
+  flt1.v, flt2.v = i, 0.5
+  return lib.flt_add(flt1, flt2).v
+end)
+
+local dbl = ffi.new('struct dbl')
+check('double', function(i)
+  dbl.v = i + 0.125
+  return lib.dbl_mul(dbl, 3).v
+end)
+
+-- A union of float and double is passed in an FPR, too.
+local fltdbl = ffi.new('union fltdbl')
+check('union of float and double', function(i)
+  fltdbl.d = i + 0.125
+  return lib.fltdbl_twice(fltdbl, 0.5).d == 2 * i + 0.75
+end)
+
+check('complex float', function(i)
+  local r = lib.cplx_conj(ffi.new('complex float', i, -2 * i))
+  return r.re * 1000 + r.im
+end)
+
+check('hidden result pointer', function(i)
+  local r = lib.big_make(i, 2 * i, 2^40 + i)
+  return tonumber(r.a + r.b * 1000 + r.c)
+end)
+
+check('result is a new object', function(i)
+  local r1 = lib.big_make(i, i, i)
+  local r2 = lib.big_make(-i, -i, -i)
+  return tonumber(lib.big_sum(r1) * 10 + lib.big_sum(r2))
+end)
+
+-- A struct passed by value to a non-struct parameter is still
+-- rejected.
+local ok = pcall(function()
+  for _ = 1, NTEST do lib.big_sum(pair) end
+end)
+test:ok(not ok, 'type mismatch is an error')
+
+os.exit(test:check() and 0 or 1)
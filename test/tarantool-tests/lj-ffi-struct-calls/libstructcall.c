@@ -0,0 +1,83 @@
+#include <stdint.h>
+#include <complex.h>
+
+/*
+ * Functions passing and returning aggregates by value in all the
+ * flavours the JIT compiler handles: in a single GPR, in a single
+ * FPR and via a hidden result pointer.
+ */
+
+struct pair { int32_t a, b; };
+struct rgba { uint8_t r, g, b, a; };
+struct half { int16_t v; };
+struct byte { uint8_t v; };
+struct vec2 { float x, y; };
+struct flt { float v; };
+struct dbl { double v; };
+struct big { int64_t a, b, c; };
+union fltdbl { float f; double d; };
+
+struct pair pair_swap(struct pair p)
+{
+	struct pair r = { p.b, p.a };
+	return r;
+}
+
+struct rgba rgba_invert(struct rgba c)
+{
+	struct rgba r = { 255 - c.r, 255 - c.g, 255 - c.b, c.a };
+	return r;
+}
+
+struct half half_neg(struct half h)
+{
+	struct half r = { -h.v };
+	return r;
+}
+
+struct byte byte_inc(struct byte b)
+{
+	struct byte r = { b.v + 1 };
+	return r;
+}
+
+struct vec2 vec2_scale(struct vec2 v, float k)
+{
+	struct vec2 r = { v.x * k, v.y * k };
+	return r;
+}
+
+struct flt flt_add(struct flt a, struct flt b)
+{
+	struct flt r = { a.v + b.v };
+	return r;
+}
+
+struct dbl dbl_mul(struct dbl a, double k)
+{
+	struct dbl r = { a.v * k };
+	return r;
+}
+
+union fltdbl fltdbl_twice(union fltdbl u, double k)
+{
+	union fltdbl r;
+	r.d = u.d * 2 + k;
+	return r;
+}
+
+float complex cplx_conj(float complex z)
+{
+	return conjf(z);
+}
+
+struct big big_make(int64_t a, int64_t b, int64_t c)
+{
+	struct big r = { a, b, c };
+	return r;
+}
+
+int64_t big_sum(const struct big *p)
+{
+	return p->a + p->b + p->c;
+}
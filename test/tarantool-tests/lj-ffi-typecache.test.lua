@@ -0,0 +1,41 @@
+local tap = require('tap')
+local ffi = require('ffi')
+
+-- Test file to check the cache of parsed C type declaration
+-- strings.
+
+local test = tap.test('lj-ffi-typecache')
+test:plan(7)
+
+test:ok(ffi.typeof('int *') == ffi.typeof('int *'), 'same type is cached')
+test:ok(ffi.typeof('struct { int x; }') ~= ffi.typeof('struct { int x; }'),
+        'anonymous structs are not cached')
+test:is(ffi.sizeof(ffi.typeof('int[$]', 3)) +
+        ffi.sizeof(ffi.typeof('int[$]', 5)), 32,
+        'parameterized types are not cached')
+
+-- Errors are not cached, new declarations are visible.
+local ok = pcall(ffi.typeof, 'typecache_t')
+ffi.cdef('typedef struct { double d; } typecache_t;')
+test:ok(not ok and ffi.sizeof('typecache_t') == 8, 'cache and ffi.cdef')
+
+-- The forward declared struct is completed in place.
+ffi.cdef('struct typecache_fwd;')
+local fwd = ffi.typeof('struct typecache_fwd *')
+ffi.typeof('struct typecache_fwd *')
+ffi.cdef('struct typecache_fwd { int a, b; };')
+test:ok(ffi.typeof('struct typecache_fwd *') == fwd and
+        ffi.sizeof('struct typecache_fwd') == 8, 'forward declared struct')
+
+-- The cache is bounded and all the strings may be collected.
+for i = 1, 1000 do ffi.typeof('int[' .. i .. ']') end
+collectgarbage()
+test:is(ffi.sizeof('int[7]'), 28, 'cache is flushed')
+
+-- XXX: Each parse of a function type creates a new C type, so
+-- the C type table overflows without the cache.
+local f = ffi.cast('void *', 0)
+for _ = 1, 70000 do f = ffi.cast('int (*)(int, double)', f) end
+test:ok(ffi.istype('int (*)(int, double)', f), 'no C type table overflow')
+
+os.exit(test:check() and 0 or 1)
@@ -0,0 +1,132 @@
+local tap = require('tap')
+local jutil = require('jit.util')
+local vmdef = require('jit.vmdef')
+
+-- Test file to check the verification of hashed hot counter
+-- triggers (the 'hotverify' JIT parameter) and the collision
+-- metric.
+
+local test = tap.test('lj-hotcount-verify')
+test:plan(8)
+
+local NLOOPS = 300
+local NITER = 20
+
+-- Count the traces the JIT compiler starts to record.
+local nstart = 0
+jit.attach(function(what)
+  if what == 'start' then nstart = nstart + 1 end
+end, 'trace')
+
+-- Each cold loop runs well below the 'hotloop' threshold. But
+-- there are many more of them than hashed hot counters, so the
+-- sum of iterations sharing a counter exceeds it.
+-- The chunks are kept alive, so no bytecode is allocated at the
+-- address of a previous one.
+local chunks = {}
+local function run_cold_loops()
+  for _ = 1, NLOOPS do
+    local f = assert(loadstring(([[
+      local x = 0
+      for i = 1, %d do x = x + i end
+      return x
+    ]]):format(NITER)))
+    chunks[#chunks + 1] = f
+    f()
+  end
+end
+-- The driver loop itself is hot, so don't compile it.
+jit.off(run_cold_loops)
+
+local function collisions()
+  return misc.getmetrics().jit_hotcount_collisions
+end
+
+jit.opt.start(3, 'hotloop=56', 'hotverify=0')
+jit.flush()
+
+local ncoll = collisions()
+nstart = 0
+run_cold_loops()
+test:ok(nstart > 0, 'cold loops trigger shared counters')
+test:ok(collisions() > ncoll, 'collisions are counted')
+
+-- With verification no cold loop ever triggers its counter
+-- twice in a row, since another loop wins the next trigger.
+jit.opt.start('hotverify=1')
+jit.flush()
+
+ncoll = collisions()
+nstart = 0
+run_cold_loops()
+test:is(nstart, 0, 'no false triggers with hotverify')
+test:ok(collisions() > ncoll, 'collisions are counted with hotverify')
+
+-- A genuinely hot loop is still compiled.
+nstart = 0
+local x = 0
+for i = 1, 200 do x = x + i end
+test:is(x, 20100, 'hot loop result')
+test:is(nstart, 1, 'hot loop is compiled with hotverify')
+
+-- Two hot loops sharing a counter and triggering it in turn
+-- are compiled, too. The loops are placed 1024 bytecodes apart,
+-- so they share a counter for counter table sizes up to 1024.
+-- With 28 iterations each, they trigger the counter alternately.
+local function forlpcs(f)
+  local pcs = {}
+  for pc = 1, math.huge do
+    local ins = jutil.funcbc(f, pc)
+    if not ins then break end
+    if vmdef.bcnames:sub(ins % 256 * 6 + 1, ins % 256 * 6 + 4) == 'FORL' then
+      pcs[#pcs + 1] = pc
+    end
+  end
+  return pcs
+end
+local function gen_loops(npad)
+  return assert(loadstring(([[
+    local n = ...
+    local x = 0
+    for i = 1, n do x = x + i end
+    %s
+    for i = 1, n do x = x + i end
+    return x
+  ]]):format(('x = x + 1 '):rep(npad))))
+end
+local DIST = 1024
+local pcs = forlpcs(gen_loops(DIST))
+local loops = gen_loops(2 * DIST - (pcs[2] - pcs[1]))
+pcs = forlpcs(loops)
+assert(pcs[2] - pcs[1] == DIST, 'loops are placed apart')
+
+-- Root traces of the loops by trace number.
+local compiled = {}
+local function trace_cb(what, tr, func, pc, otr)
+  if what == 'start' and func == loops and not otr then
+    compiled[tr] = pc
+  elseif what == 'abort' then
+    compiled[tr] = nil
+  end
+end
+jit.attach(trace_cb, 'trace')
+local function run_hot_loops()
+  for _ = 1, 200 do loops(28) end
+end
+jit.off(run_hot_loops)
+jit.flush()
+
+ncoll = collisions()
+run_hot_loops()
+jit.attach(trace_cb)
+local nloops = 0
+for _, pc in pairs(compiled) do
+  if pc == pcs[1] or pc == pcs[2] then nloops = nloops + 1 end
+end
+test:ok(collisions() > ncoll, 'alternating hot loops share a counter')
+test:is(nloops, 2, 'alternating hot loops are compiled with hotverify')
+
+jit.attach(function() end)
+jit.opt.start('hotverify=0')
+
+os.exit(test:check() and 0 or 1)
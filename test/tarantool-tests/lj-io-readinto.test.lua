@@ -0,0 +1,89 @@
+local tap = require('tap')
+local ffi = require('ffi')
+
+-- Test file to check file:readinto() and file:writefrom().
+
+local test = tap.test('lj-io-readinto')
+test:plan(22)
+
+local fname = os.tmpname()
+local N = 1000
+local buf = ffi.new('uint8_t[?]', N)
+
+local function run(mode)
+  local f = assert(io.open(fname, 'wb'))
+  local ok = true
+  for i = 1, 100 do
+    ffi.fill(buf, N, i)
+    if not f:writefrom(buf, i * 10) then ok = false end
+  end
+  f:close()
+  test:ok(ok, 'writefrom ' .. mode)
+
+  f = assert(io.open(fname, 'rb'))
+  local s = f:read('*a')
+  ok = #s == 50500
+  local pos = 0
+  for i = 1, 100 do
+    if s:sub(pos + 1, pos + i * 10) ~= string.char(i):rep(i * 10) then
+      ok = false
+    end
+    pos = pos + i * 10
+  end
+  test:ok(ok, 'file contents ' .. mode)
+
+  f:seek('set')
+  ok = true
+  local total, sum = 0, 0
+  while true do
+    local n = f:readinto(buf, N)
+    if n == 0 then break end
+    total = total + n
+    for i = 0, n - 1 do sum = sum + buf[i] end
+  end
+  local expected = 0
+  for i = 1, 100 do expected = expected + i * i * 10 end
+  test:ok(total == 50500 and sum == expected, 'readinto ' .. mode)
+  test:is(f:readinto(buf, N), 0, 'readinto at EOF ' .. mode)
+  f:close()
+end
+
+jit.on()
+run('(JIT on)')
+jit.off()
+run('(JIT off)')
+jit.on()
+
+-- Mixed with line reads through the buffer of the file handle.
+local f = assert(io.open(fname, 'wb'))
+f:write('first line\nsecond line\nthird line\n')
+f:close()
+f = assert(io.open(fname))
+test:is(f:read('*l'), 'first line', 'line before readinto')
+test:is(f:readinto(buf, 7), 7, 'readinto after line')
+test:is(ffi.string(buf, 7), 'second ', 'data after line')
+test:is(f:read('*l'), 'line', 'line after readinto')
+test:is(f:readinto(buf, N), 11, 'short readinto')
+test:is(ffi.string(buf, 11), 'third line\n', 'data of short readinto')
+test:is(f:seek('cur'), 34, 'file position')
+f:seek('set', 6)
+test:is(f:readinto(buf + 1, 4), 4, 'readinto pointer')
+test:is(ffi.string(buf, 5), 'tline', 'data of readinto pointer')
+
+-- Errors.
+local status, err = pcall(f.readinto, f, 'string', 1)
+test:ok(not status and err:match('cdata expected'), 'readinto string')
+status, err = pcall(f.readinto, f, buf, -1)
+test:ok(not status and err:match('out of range'), 'readinto negative')
+local res
+res, err = f:writefrom(buf, 1)
+test:ok(res == nil and err, 'writefrom read-only file')
+f:close()
+status, err = pcall(f.readinto, f, buf, 1)
+test:ok(not status and err:match('closed file'), 'readinto closed file')
+status, err = pcall(f.writefrom, f, buf, 1)
+test:ok(not status and err:match('closed file'), 'writefrom closed file')
+
+os.remove(fname)
+
+os.exit(test:check() and 0 or 1)
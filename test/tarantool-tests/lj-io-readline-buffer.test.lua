@@ -0,0 +1,164 @@
+local tap = require('tap')
+local ffi = require('ffi')
+
+-- Test file to check reading lines from files without reading
+-- ahead of the stdio buffer.
+
+local test = tap.test('lj-io-readline-buffer')
+test:plan(31)
+
+local fname = os.tmpname()
+
+local function writefile(s)
+  local f = assert(io.open(fname, 'wb'))
+  f:write(s)
+  f:close()
+end
+
+-- Compiled line loops drive the GC forward. This goes first,
+-- so the GC threshold is well below the garbage.
+do
+  local f = assert(io.open(fname, 'wb'))
+  local x = ('x'):rep(50)
+  for i = 1, 100000 do f:write(i, ':', x, '\n') end
+  f:close()
+end
+-- Each loop creates about 8 Mb of distinct strings.
+local memlimit = 4096
+
+collectgarbage()
+local mem = collectgarbage('count')
+local n = 0
+for l in io.lines(fname) do n = n + #l end
+test:ok(collectgarbage('count') - mem < memlimit, 'io.lines runs the GC')
+
+collectgarbage()
+mem = collectgarbage('count')
+local f = assert(io.open(fname))
+n = 0
+while true do
+  local l = f:read('*l')
+  if not l then break end
+  n = n + #l
+end
+f:close()
+test:ok(collectgarbage('count') - mem < memlimit, 'file:read runs the GC')
+
+-- Lines longer than the stdio buffer and lines crossing its
+-- boundary.
+local lines = {}
+for i = 1, 2000 do
+  lines[i] = ('%d:'):format(i) .. ('x'):rep(i % 7 == 0 and 70000 or i % 113)
+end
+lines[#lines + 1] = ''
+lines[#lines + 1] = 'last line without a newline'
+writefile(table.concat(lines, '\n'))
+
+local function run(mode)
+  local ok, n = true, 0
+  for l in io.lines(fname) do
+    n = n + 1
+    if l ~= lines[n] then ok = false end
+  end
+  test:ok(ok and n == #lines, 'io.lines ' .. mode)
+
+  local f = assert(io.open(fname))
+  ok, n = true, 0
+  for l in f:lines('*L') do
+    n = n + 1
+    if l ~= lines[n] .. (n < #lines and '\n' or '') then ok = false end
+  end
+  test:ok(ok and n == #lines, 'file:lines("*L") ' .. mode)
+  test:is(f:read('*l'), nil, 'EOF ' .. mode)
+  f:close()
+
+  f = assert(io.open(fname))
+  ok, n = true, 0
+  while true do
+    local l = f:read('L')
+    if not l then break end
+    n = n + 1
+    if l ~= lines[n] .. (n < #lines and '\n' or '') then ok = false end
+  end
+  test:ok(ok and n == #lines, 'file:read("L") ' .. mode)
+  f:close()
+
+  f = assert(io.open(fname))
+  io.input(f)
+  ok, n = true, 0
+  for _ = 1, #lines do
+    n = n + 1
+    if io.read() ~= lines[n] then ok = false end
+  end
+  test:ok(ok and io.read() == nil, 'io.read ' .. mode)
+  io.input(io.stdin)
+  f:close()
+
+  local status, err = pcall(f.read, f, '*l')
+  test:ok(not status and err:match('closed file'), 'closed file ' .. mode)
+end
+
+jit.on()
+run('(JIT on)')
+jit.off()
+run('(JIT off)')
+jit.on()
+
+-- Mixed formats: the file position is the one after the last line.
+writefile('first\n12 second\n3.5\nrest\nof file')
+local f = assert(io.open(fname))
+test:is(f:read('*l'), 'first', 'line')
+test:is(f:seek('cur'), 6, 'seek after line')
+test:is(f:read('*n'), 12, 'number after line')
+test:is(f:read('*l'), ' second', 'line after number')
+test:is(f:read(3), '3.5', 'count after line')
+test:is(f:read('*l'), '', 'line after count')
+test:is(f:read('*l'), 'rest', 'line before seek')
+f:seek('set', 1)
+test:is(f:read('*l'), 'irst', 'line after seek')
+f:read('*l')
+test:is(f:read('*a'), '3.5\nrest\nof file', 'all after line')
+f:close()
+
+-- Same file opened for update.
+f = assert(io.open(fname, 'r+'))
+test:is(f:read('*l'), 'first', 'line of file opened for update')
+f:seek('cur')
+f:write('X')
+f:seek('set')
+f:read('*l')
+test:is(f:read('*l'), 'X2 second', 'write after line')
+f:close()
+
+-- The FILE * of the handle is at the position after the line.
+ffi.cdef[[
+  size_t fread(void *ptr, size_t size, size_t nmemb, void *stream);
+  long ftell(void *stream);
+]]
+writefile('line1\nline2\nline3\n')
+f = assert(io.open(fname))
+local fp = ffi.cast('void *', f)
+local buf = ffi.new('char[64]')
+test:is(f:read('*l'), 'line1', 'line before fread')
+test:is(tonumber(ffi.C.ftell(fp)), f:seek('cur'), 'ftell after line')
+local n = ffi.C.fread(buf, 1, 63, fp)
+test:is(ffi.string(buf, n), 'line2\nline3\n', 'fread after line')
+f:close()
+
+-- Embedded zeros.
+writefile('a\0b\nc\n')
+f = assert(io.open(fname))
+f:read('*l')
+test:is(f:read('*l'), 'c', 'line after embedded zero')
+f:close()
+
+-- io.lines() closes the file at EOF.
+writefile('a\nb\n')
+local iter = io.lines(fname)
+test:ok(iter() == 'a' and iter() == 'b' and iter() == nil, 'io.lines EOF')
+local status, err = pcall(iter)
+test:ok(not status and err:match('closed file'), 'io.lines closed')
+
+os.remove(fname)
+
+os.exit(test:check() and 0 or 1)
@@ -0,0 +1,92 @@
+local tap = require('tap')
+
+-- Test file to check io.write() and file:write() with several
+-- arguments gathered into a single write.
+
+local test = tap.test('lj-io-write-gather')
+test:plan(13)
+
+local fname = os.tmpname()
+
+local function readfile()
+  local f = assert(io.open(fname, 'rb'))
+  local s = f:read('*a')
+  f:close()
+  return s
+end
+
+local function expected(n)
+  local t = {}
+  for i = 1, n do
+    t[#t + 1] = i .. ' ' .. i * 0.25 .. ' ' .. -i .. '\n'
+  end
+  return table.concat(t)
+end
+
+local function run(mode)
+  local f = assert(io.open(fname, 'wb'))
+  local ok = true
+  for i = 1, 100 do
+    local res = f:write(i, ' ', i * 0.25, ' ', -i, '', '\n')
+    if res ~= f and res ~= true then ok = false end
+  end
+  f:close()
+  test:ok(ok and readfile() == expected(100), 'file:write ' .. mode)
+
+  io.output(fname)
+  for i = 1, 100 do
+    io.write(i, ' ', i * 0.25, ' ', -i, '\n')
+  end
+  io.close()
+  io.output(io.stdout)
+  test:is(readfile(), expected(100), 'io.write ' .. mode)
+
+  f = assert(io.open(fname, 'wb'))
+  local args = {}
+  for i = 1, 200 do args[i] = i % 2 == 0 and ('x'):rep(i) or i end
+  for _ = 1, 3 do f:write(unpack(args)) end
+  f:close()
+  local s = table.concat(args)
+  test:is(readfile(), s .. s .. s, 'many arguments ' .. mode)
+
+  f = assert(io.open(fname, 'wb'))
+  for _ = 1, 3 do
+    f:write(0/0, ' ', 1/0, ' ', -1/0, ' ', -0, ' ', 2^53, ' ', 0.1, '\n')
+  end
+  f:close()
+  s = tostring(0/0) .. ' inf -inf ' .. tostring(-0) .. ' ' ..
+      tostring(2^53) .. ' 0.1\n'
+  test:is(readfile(), s .. s .. s, 'number formatting ' .. mode)
+
+  f = assert(io.open(fname, 'wb'))
+  f:write()
+  f:write('', '')
+  f:write('a', 'b')
+  f:close()
+  test:is(readfile(), 'ab', 'empty arguments ' .. mode)
+end
+
+jit.on()
+run('(JIT on)')
+jit.off()
+run('(JIT off)')
+jit.on()
+
+local f = assert(io.open(fname, 'wb'))
+local status, err = pcall(f.write, f, 'a', {}, 'b')
+test:ok(not status and err:match('bad argument #3'), 'bad argument')
+f:close()
+
+-- Writes to a file opened for reading fail.
+f = assert(io.open(fname, 'rb'))
+local res
+res, err = f:write('a', 'b')
+test:ok(res == nil and err, 'file opened for reading')
+f:close()
+
+status, err = pcall(f.write, f, 'a', 'b')
+test:ok(not status and err:match('closed file'), 'closed file')
+
+os.remove(fname)
+
+os.exit(test:check() and 0 or 1)
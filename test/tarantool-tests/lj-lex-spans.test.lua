@@ -0,0 +1,61 @@
+local tap = require('tap')
+
+-- Test file to check the span scanning in the lexer. Spans are
+-- located within a single input chunk, so the same source is
+-- also loaded in pieces of various sizes to cross the chunk
+-- boundaries at every position.
+
+local test = tap.test('lj-lex-spans')
+test:plan(6)
+
+local function loadchunked(src, size)
+  local pos = 1
+  return load(function()
+    local s = src:sub(pos, pos + size - 1)
+    pos = pos + size
+    return s
+  end, '=spans')
+end
+
+-- Check the source gives the same results for all chunk sizes.
+local function check(src, expected, msg)
+  local ok = true
+  for size = 1, 40 do
+    local f = assert(loadchunked(src, size))
+    local r = f()
+    if r ~= expected then
+      ok = false
+      test:diag(('chunk size %d: got %q'):format(size, tostring(r)))
+    end
+  end
+  test:is(assert(load(src))(), expected, msg)
+  test:ok(ok, msg .. ' (chunked)')
+end
+
+local ident = ('abc_XYZ_019_'):rep(8)
+check(('local %s = 42\t\v\f    return %s + 1'):format(ident, ident),
+      43, 'long identifiers and blanks')
+
+local str = ('plain text '):rep(10)
+check(([===[
+-- Short comment with ]===] .. ('x'):rep(100) .. [===[ and "quotes"
+--[==[ Long comment
+with ]] and ]=] inside ]==]
+return "%s\n\t\65\x42\u{263A}\z
+        %s" .. '%s\'' .. [[
+first line
+second line]] ]===]):format(str, str, str),
+      str .. '\n\tAB\226\152\186' .. str .. str .. "'" ..
+      'first line\nsecond line',
+      'comments and strings')
+
+-- Line breaks in long strings are normalized, and line numbers
+-- must be counted the same way in the long comments.
+local src = '--[[ \r\n\r\n ]] local s = [[a\r\nb\n\rc\rd]]\n' ..
+            'error(s, 1)'
+for _, f in ipairs({load(src, '=spans'), loadchunked(src, 3)}) do
+  local _, err = pcall(f)
+  test:is(err, 'spans:7: a\nb\nc\nd', 'line breaks in long strings')
+end
+
+os.exit(test:check() and 0 or 1)
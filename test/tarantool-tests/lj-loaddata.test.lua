@@ -0,0 +1,88 @@
+local tap = require('tap')
+
+-- Test file to check the data-only loader <loaddata>.
+
+local test = tap.test('lj-loaddata')
+test:plan(9)
+
+-- Compare two values recursively.
+local function equal(a, b)
+  if type(a) ~= 'table' or type(b) ~= 'table' then
+    return a == b or a ~= a and b ~= b
+  end
+  for k, v in pairs(a) do
+    if not equal(v, b[k]) then return false end
+  end
+  for k in pairs(b) do
+    if a[k] == nil then return false end
+  end
+  return true
+end
+
+local src = [[
+return {
+  1, -2, 0x10, 1.5e3, -0.25, "str", 'q\n\0', [==[long]==], true, false,
+  name = "value", ["with space"] = { nested = { deeper = { 42 } } },
+  [100] = "hash", [-1] = 1, [2.5] = "float", [false] = 0,
+  { }, { nil, nil, 3 }; mixed = { "a", b = "b", "c" },
+}
+]]
+test:ok(equal(loaddata(src), load(src)()), 'same result as load()')
+
+-- Fields are assigned in the source order.
+local t = loaddata('{ [1] = "a", "b", [2] = "c", x = 1, x = nil }')
+test:ok(t[1] == 'b' and t[2] == 'c' and t.x == nil, 'fields order')
+
+test:ok(loaddata('"str"') == 'str' and loaddata('-5') == -5 and
+        loaddata('return nil') == nil, 'non-table values')
+
+-- Only literals are accepted.
+local errors = {
+  ['{ x = y }'] = 'cfg:1: unexpected symbol near \'y\'',
+  ['{ f() }'] = 'cfg:1: \'=\' expected near \'(\'',
+  ['{ 1 + 2 }'] = 'cfg:1: \'}\' expected near \'+\'',
+  ['{ [nil] = 1 }'] = 'cfg:1: table index is nil',
+  ['{ 1 } { 2 }'] = 'cfg:1: \'<eof>\' expected near \'{\'',
+  ['{\n1,\n2'] = 'cfg:3: \'}\' expected (to close \'{\' at line 1) near' ..
+                 ' \'<eof>\'',
+}
+local ok = true
+for s, msg in pairs(errors) do
+  local res, err = loaddata(s, '=cfg')
+  if res ~= nil or err ~= msg then
+    ok = false
+    test:diag(('%q: %s'):format(s, tostring(err)))
+  end
+end
+test:ok(ok, 'syntax errors')
+test:like(select(2, loaddata(string.dump(function() end))), 'wrong mode',
+          'bytecode is rejected')
+
+-- Reader function.
+local parts, i = {'{ a', ' = 1,', ' b = { 2 } }'}, 0
+t = loaddata(function() i = i + 1; return parts[i] end)
+test:is(t.b[1], 2, 'reader function')
+
+-- There is no limit on the number of constants, and all the
+-- strings must survive the GC steps during the load.
+local N = 100000
+local buf = {'{'}
+for n = 1, N do buf[#buf + 1] = ('{ "s%d", k%d = %d },'):format(n, n, n) end
+buf[#buf + 1] = '}'
+collectgarbage('setpause', 0)
+collectgarbage('setstepmul', 10)
+t = loaddata(table.concat(buf))
+collectgarbage('setpause', 200)
+collectgarbage('setstepmul', 200)
+collectgarbage()
+test:is(#t, N, 'large table')
+ok = true
+for n = 1, N do
+  local e = t[n]
+  if e[1] ~= 's' .. n or e['k' .. n] ~= n then ok = false; break end
+end
+test:ok(ok, 'large table contents')
+test:is(select(2, loaddata(('{'):rep(1000))), '(data):1: chunk has' ..
+        ' too many syntax levels', 'nesting limit')
+
+os.exit(test:check() and 0 or 1)
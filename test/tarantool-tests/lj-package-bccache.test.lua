@@ -0,0 +1,97 @@
+require('utils').skipcond(jit.os == 'Windows',
+                          'Bytecode cache is POSIX-only')
+
+local tap = require('tap')
+local ffi = require('ffi')
+
+-- Test file to check the on-disk bytecode cache of <require>.
+
+local test = tap.test('lj-package-bccache')
+test:plan(8)
+
+ffi.cdef([[
+  int mkdir(const char *path, unsigned int mode);
+  struct utimbuf { long actime; long modtime; };
+  int utime(const char *path, const struct utimbuf *times);
+]])
+
+local MTIME = 1000000000
+
+local dir = os.tmpname()
+os.remove(dir)
+assert(ffi.C.mkdir(dir, tonumber('700', 8)) == 0)
+local cachedir = dir .. '/cache'
+assert(ffi.C.mkdir(cachedir, tonumber('700', 8)) == 0)
+
+local modfile = dir .. '/bccachemod.lua'
+
+-- Write the module source and set the given mtime.
+local function writemod(src, mtime)
+  local fh = assert(io.open(modfile, 'w'))
+  fh:write(src)
+  fh:close()
+  assert(ffi.C.utime(modfile, ffi.new('struct utimbuf', mtime, mtime)) == 0)
+end
+
+local function loadmod()
+  package.loaded.bccachemod = nil
+  return require('bccachemod')
+end
+
+local function lscache()
+  local files = {}
+  local p = io.popen('ls ' .. cachedir)
+  for f in p:lines() do files[#files + 1] = cachedir .. '/' .. f end
+  p:close()
+  return files
+end
+
+package.path = dir .. '/?.lua;' .. package.path
+package.bccache = cachedir
+
+writemod('return function() return "v1" end', MTIME)
+test:is(loadmod()(), 'v1', 'module loaded from the source')
+test:is(#lscache(), 1, 'module stored in the cache')
+
+-- The source with the same size, mtime and inode is considered to
+-- be unchanged, so the cached bytecode is used.
+writemod('return function() return "v2" end', MTIME)
+test:is(loadmod()(), 'v1', 'module loaded from the cache')
+
+-- Any mismatch of the key invalidates the cache file.
+writemod('return function() return "v2" end', MTIME + 1)
+test:is(loadmod()(), 'v2', 'stale cache file is replaced')
+
+-- Corrupted cache file is ignored.
+local cachefile = lscache()[1]
+local fh = assert(io.open(cachefile, 'r+b'))
+local hdr = fh:read('*l')
+fh:seek('set', #hdr + 1)
+fh:write(('\0'):rep(16))
+fh:close()
+test:is(loadmod()(), 'v2', 'corrupted cache file is ignored')
+
+-- The source modified within the current second bypasses the
+-- cache, so a change of the same size in the same second isn't
+-- missed.
+local function writemodnow(src)
+  local fh = assert(io.open(modfile, 'w'))
+  fh:write(src)
+  fh:close()
+end
+writemodnow('return function() return "v3" end')
+test:is(loadmod()(), 'v3', 'recently modified module loaded')
+writemodnow('return function() return "v4" end')
+test:is(loadmod()(), 'v4', 'same second change is not missed')
+
+-- Check the cache is disabled by default.
+package.bccache = nil
+os.remove(cachefile)
+test:is(loadmod()() .. #lscache(), 'v40', 'cache is disabled')
+
+os.remove(modfile)
+for _, f in ipairs(lscache()) do os.remove(f) end
+os.remove(cachedir)
+os.remove(dir)
+
+os.exit(test:check() and 0 or 1)
@@ -0,0 +1,77 @@
+require('utils').skipcond(jit.os == 'Windows',
+                          'Directory listing cache is POSIX-only')
+
+local tap = require('tap')
+local ffi = require('ffi')
+
+-- Test file to check the directory listing cache used by the
+-- package.path and package.cpath search.
+
+local test = tap.test('lj-package-dircache')
+test:plan(10)
+
+ffi.cdef([[
+  int mkdir(const char *path, unsigned int mode);
+  struct utimbuf { long actime; long modtime; };
+  int utime(const char *path, const struct utimbuf *times);
+]])
+
+local MTIME = 1000000000
+
+local dir = os.tmpname()
+os.remove(dir)
+assert(ffi.C.mkdir(dir, tonumber('700', 8)) == 0)
+
+local path = dir .. '/?/init.lua;' .. dir .. '/?.lua'
+
+local function touch(name)
+  local fh = assert(io.open(dir .. '/' .. name, 'w'))
+  fh:write('return true')
+  fh:close()
+end
+
+local function settime(mtime)
+  assert(ffi.C.utime(dir, ffi.new('struct utimbuf', mtime, mtime)) == 0)
+end
+
+local function search(name)
+  return package.searchpath(name, path) ~= nil
+end
+
+-- "on" mode trusts the listing until it's flushed.
+package.dircache('on')
+touch('mod1.lua')
+settime(MTIME)
+test:ok(search('mod1'), 'existing module is found')
+touch('mod2.lua')
+test:ok(not search('mod2'), 'new module is not found until flush')
+package.dircache('flush')
+test:ok(search('mod2'), 'new module is found after flush')
+local _, err = package.searchpath('mod3', path)
+test:like(err, 'no file .*/mod3/init.lua.*no file .*/mod3.lua',
+          'error message lists all templates')
+
+-- A directory modified within the current second isn't cached.
+package.dircache('flush')
+test:ok(not search('mod5'), 'missing module is not found')
+touch('mod5.lua')
+test:ok(search('mod5'), 'recently modified directory is not cached')
+
+-- "mtime" mode revalidates the listing by the directory mtime.
+package.dircache('mtime')
+settime(MTIME)
+test:ok(not search('mod3'), 'missing module is not found')
+touch('mod3.lua')
+test:ok(search('mod3'), 'new module is found after mtime change')
+settime(MTIME)
+test:ok(search('mod3'), 'listing is cached')
+touch('mod4.lua')
+settime(MTIME)
+test:ok(not search('mod4'), 'listing is not rescanned for the same mtime')
+
+package.dircache('off')
+
+for i = 1, 5 do os.remove(('%s/mod%d.lua'):format(dir, i)) end
+os.remove(dir)
+
+os.exit(test:check() and 0 or 1)
@@ -0,0 +1,104 @@
+local tap = require('tap')
+
+-- Test file to check that coroutines recycled via the thread
+-- pool in global_State are indistinguishable from the fresh
+-- ones.
+
+local test = tap.test('lj-state-thread-pool')
+test:plan(7)
+
+-- XXX: Number of coroutines to be created between collections.
+-- It is chosen to be greater than LJ_MAX_THPOOL to check that
+-- the pool is bounded and both code paths are covered.
+local NCORO = 1000
+
+local function deep(n)
+  if n == 0 then return 0 end
+  return 1 + deep(n - 1)
+end
+
+-- Grow the stacks, leave some coroutines suspended and some
+-- dead with an error, so they are recycled in various states.
+for _ = 1, NCORO do
+  local co = coroutine.create(function(n)
+    coroutine.yield(deep(n))
+    error('dead')
+  end)
+  coroutine.resume(co, 1000)
+  coroutine.resume(co)
+end
+collectgarbage()
+collectgarbage()
+
+local statuses_ok, results_ok, envs_ok = true, true, true
+local env = getfenv(0)
+for i = 1, NCORO do
+  local co = coroutine.create(function(a)
+    local b = coroutine.yield(a + 1)
+    return getfenv(0), b * 2
+  end)
+  statuses_ok = statuses_ok and coroutine.status(co) == 'suspended'
+  local _, r1 = coroutine.resume(co, i)
+  local _, e, r2 = coroutine.resume(co, i)
+  results_ok = results_ok and r1 == i + 1 and r2 == i * 2
+  envs_ok = envs_ok and e == env
+  statuses_ok = statuses_ok and coroutine.status(co) == 'dead'
+end
+
+test:ok(statuses_ok, 'recycled coroutines have correct status')
+test:ok(results_ok, 'recycled coroutines pass arguments and results')
+test:ok(envs_ok, 'recycled coroutines have correct environment')
+
+-- Check that the recycled stack can be grown again.
+local co = coroutine.wrap(function(n) return deep(n) end)
+test:is(co(10000), 10000, 'recycled coroutine stack is grown')
+
+-- Check that the memory held by the pool is bounded.
+collectgarbage()
+collectgarbage()
+local before = collectgarbage('count')
+for _ = 1, 10 * NCORO do
+  coroutine.wrap(function() end)()
+end
+collectgarbage()
+collectgarbage()
+test:ok(collectgarbage('count') <= before + 64, 'thread pool is bounded')
+
+-- Check that recycled coroutines are accounted as allocated and
+-- freed just like the fresh ones.
+local POOLSIZE = 128
+local N = 100
+local function noop() end
+local function create(n)
+  local t = {}
+  for i = 1, n do t[i] = coroutine.create(noop) end
+  return t
+end
+-- Keep the trace compiler from allocating in between.
+jit.off(create)
+
+local function allocated(n)
+  local old = misc.getmetrics().gc_allocated
+  local t = create(n)
+  return misc.getmetrics().gc_allocated - old, t
+end
+
+-- Don't let GC steps allocate in between.
+collectgarbage('stop')
+collectgarbage()
+-- The first run drains the pool.
+local drain = create(POOLSIZE) -- luacheck: no unused
+local fresh_allocated = allocated(N)
+drain = nil -- luacheck: no unused
+collectgarbage()
+local pooled_allocated, placeholder = allocated(N)
+test:is(pooled_allocated, fresh_allocated,
+        'recycled coroutines are accounted as allocated')
+placeholder = nil -- luacheck: no unused
+local old_freed = misc.getmetrics().gc_freed
+collectgarbage()
+test:ok(misc.getmetrics().gc_freed - old_freed >= fresh_allocated,
+        'pooled coroutines are accounted as freed')
+collectgarbage('restart')
+
+os.exit(test:check() and 0 or 1)
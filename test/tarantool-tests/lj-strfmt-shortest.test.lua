@@ -0,0 +1,87 @@
+local tap = require('tap')
+local ffi = require('ffi')
+
+-- Test file to check the shortest round-trip number format "%r".
+
+local test = tap.test('lj-strfmt-shortest')
+test:plan(6)
+
+local cases = {
+  {0, '0'}, {-0, '-0'}, {0.1, '0.1'}, {1/3, '0.3333333333333333'},
+  {0.1 + 0.2, '0.30000000000000004'}, {100, '100'},
+  {2^53, '9007199254740992'}, {1e16, '10000000000000000'},
+  {1e17, '1e+17'}, {1e-4, '0.0001'}, {1.5e-5, '1.5e-05'},
+  {5e-324, '5e-324'}, {1.7976931348623157e308, '1.7976931348623157e+308'},
+  {2^-1022, '2.2250738585072014e-308'}, {-1.25, '-1.25'},
+  {0/0, 'nan'}, {1/0, 'inf'}, {-1/0, '-inf'},
+}
+local ok = true
+for _, c in ipairs(cases) do
+  local s = string.format('%r', c[1])
+  if s ~= c[2] then
+    ok = false
+    test:diag(('expected %s, got %s'):format(c[2], s))
+  end
+end
+test:ok(ok, 'shortest representation')
+
+test:is(string.format('[%8r|%-8r|%08r|%+r|% r|%R]', 1.5, 1.5, -1.5, 1.5, 1.5,
+                      1e100),
+        '[     1.5|1.5     |-00001.5|+1.5| 1.5|1E+100]', 'flags and width')
+
+-- Check round-trip of random bit patterns.
+local u = ffi.new('union { double d; uint32_t w[2]; }')
+math.randomseed(42)
+local rt_ok = true
+for _ = 1, 1e5 do
+  u.w[0] = math.random(0, 2^32 - 1)
+  u.w[1] = math.random(0, 2^32 - 1)
+  local d = u.d
+  if d == d and tonumber(string.format('%r', d)) ~= d then
+    rt_ok = false
+    test:diag(('round-trip failed for %.17g'):format(d))
+    break
+  end
+end
+test:ok(rt_ok, 'round-trip of random numbers')
+
+-- Check that the digits are the shortest ones, i.e. dropping the
+-- last digit doesn't round-trip.
+local short_ok = true
+for _ = 1, 1e4 do
+  local d = math.random() * 10^math.random(-30, 30)
+  local s = string.format('%r', d)
+  local m, e = s:match('^([%d.]+)(.*)$')
+  local digits = m:gsub('%.', ''):gsub('^0+', ''):gsub('0+$', '')
+  if #digits > 1 then
+    local shorter = ('%.' .. (#digits - 2) .. 'e'):format(d)
+    if tonumber(shorter) == d then
+      short_ok = false
+      test:diag(('%s is not the shortest for %s%s'):format(s, m, e))
+      break
+    end
+  end
+end
+test:ok(short_ok, 'shortest digits')
+
+-- Check the recorded string.format.
+jit.opt.start('hotloop=1')
+local res = {}
+for i = 1, 8 do
+  res[i] = string.format('%r', i / 3)
+end
+jit.off()
+local rec_ok = true
+for i = 1, 8 do
+  rec_ok = rec_ok and res[i] == string.format('%r', i / 3)
+end
+jit.on()
+test:ok(rec_ok, 'recorded %r')
+
+-- The default conversion is unchanged unless the VM is built with
+-- LUAJIT_NUMFMT_SHORTEST.
+local tostr = tostring(1/3)
+test:ok(tostr == '0.33333333333333' or tostr == '0.3333333333333333',
+        'tostring conversion')
+
+os.exit(test:check() and 0 or 1)
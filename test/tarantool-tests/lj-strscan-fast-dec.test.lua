@@ -0,0 +1,87 @@
+local tap = require('tap')
+
+-- Test file to check the fast paths of the decimal number
+-- conversion in lj_strscan.c against the exact one.
+
+local test = tap.test('lj-strscan-fast-dec')
+test:plan(4)
+
+-- Expected values are given as hexadecimal literals, which are
+-- converted exactly.
+local cases = {
+  {'0.1', 0x1.999999999999ap-4},
+  {'1.5', 0x1.8000000000000p+0},
+  {'123.456', 0x1.edd2f1a9fbe77p+6},
+  {'9007199254740993.0', 0x1.0000000000000p+53},
+  {'9007199254740993e0', 0x1.0000000000000p+53},
+  {'1e22', 0x1.0f0cf064dd592p+73},
+  {'1e23', 0x1.52d02c7e14af6p+76},
+  {'8.98846567431158e307', 0x1.0000000000000p+1023},
+  {'1.7976931348623157e308', 0x1.fffffffffffffp+1023},
+  {'1.7976931348623158e308', 0x1.fffffffffffffp+1023},
+  {'1.7976931348623159e308', math.huge},
+  {'2.2250738585072011e-308', 0x0.fffffffffffffp-1022},
+  {'2.2250738585072014e-308', 0x1.0000000000000p-1022},
+  {'4.9406564584124654e-324', 0x0.0000000000001p-1022},
+  {'2.4703282292062328e-324', 0x0.0000000000001p-1022},
+  {'2.4703282292062327e-324', 0},
+  {'1e-400', 0},
+  {'1e400', math.huge},
+  {'0.30000000000000004', 0x1.3333333333334p-2},
+  {'123456789012345678901234567890e-10', 0x1.56a95319d63e1p+63},
+  {'1.00000000000000011102230246251565404236316680908203125', 0x1.0000000000000p+0},
+  {'1.00000000000000011102230246251565404236316680908203124', 0x1.0000000000000p+0},
+  {'1.00000000000000011102230246251565404236316680908203126', 0x1.0000000000001p+0},
+  {'7.2057594037927933e16', 0x1.0000000000000p+56},
+  {'9.999999999999999e22', 0x1.52d02c7e14af6p+76},
+  {'0.000000000000000000000000000000000001e36', 0x1.0000000000000p+0},
+  {'3.14159265358979323846264338327950288', 0x1.921fb54442d18p+1},
+  {'1e-22', 0x1.e392010175ee6p-74},
+  {'12345678901234567890.5', 0x1.56a95319d63e1p+63},
+  {'-1e-5', -0x1.4f8b588e368f1p-17},
+  -- Many zeros before the first significant digit.
+  {'0.00000000000000000000000000000000000001', 0x1.b38fb9daa78e4p-127},
+  {'0000000000000000000000000000.125', 0x1.0000000000000p-3},
+  {'.0000000000000000000000000000000000000000123456789012345678901e5',
+   0x1.a41a07f2ab972p-120},
+  {'0.' .. ('0'):rep(323) .. '49', 0x0.0000000000001p-1022},
+}
+
+local tonum_ok, lex_ok = true, true
+for _, c in ipairs(cases) do
+  local s, expected = c[1], c[2]
+  local n = tonumber(s)
+  if n ~= expected then
+    tonum_ok = false
+    test:diag(('tonumber(%q): expected %a, got %a'):format(s, expected, n))
+  end
+  n = assert(loadstring('return ' .. s))()
+  if n ~= expected then
+    lex_ok = false
+    test:diag(('literal %s: expected %a, got %a'):format(s, expected, n))
+  end
+end
+test:ok(tonum_ok, 'tonumber() of decimal numbers')
+test:ok(lex_ok, 'decimal number literals')
+
+test:is(1/tonumber('-0.0'), -math.huge, 'negative zero')
+
+-- Check the numbers printed with 17 significant digits are
+-- converted back exactly.
+local ffi = require('ffi')
+local u = ffi.new('union { double d; uint32_t w[2]; }')
+math.randomseed(42)
+local rt_ok = true
+for _ = 1, 1e5 do
+  u.w[0] = math.random(0, 2^32 - 1)
+  u.w[1] = math.random(0, 2^31 - 1)
+  local d = u.d
+  if d == d and d ~= math.huge and tonumber(('%.17g'):format(d)) ~= d then
+    rt_ok = false
+    test:diag(('round-trip failed for %a'):format(d))
+    break
+  end
+end
+test:ok(rt_ok, 'round-trip of random numbers')
+
+os.exit(test:check() and 0 or 1)
@@ -0,0 +1,42 @@
+local tap = require('tap')
+
+-- Test file to check that insertion/deletion churn of hash keys
+-- doesn't rehash the table on each insertion.
+
+local test = tap.test('lj-tab-churn-rehash')
+test:plan(4)
+
+local NOPS = 10000
+
+local keys = {}
+for i = 1, NOPS + 2048 do keys[i] = 'k' .. i end
+
+-- Return the number of bytes allocated by churn at the given
+-- number of live keys.
+local function churn(live)
+  local t = {}
+  for i = 1, live do t[keys[i]] = i end
+  collectgarbage()
+  local old = misc.getmetrics().gc_allocated
+  for i = live + 1, live + NOPS do
+    t[keys[i - live]] = nil
+    t[keys[i]] = i
+  end
+  local allocated = misc.getmetrics().gc_allocated - old
+  for i = NOPS + 1, NOPS + live do
+    assert(t[keys[i]] == i)
+  end
+  return allocated
+end
+
+-- Each rehash reallocates the hash part (24 bytes per node). It
+-- used to happen on every insertion with a number of live keys
+-- just below a power of two. Now a rehash leaves a quarter of the
+-- nodes free, i.e. it costs a few nodes per insertion.
+for _, live in ipairs({ 127, 1000, 1023, 2047 }) do
+  local allocated = churn(live)
+  test:ok(allocated < NOPS * 16 * 24,
+          ('no rehash per insertion with %d live keys'):format(live))
+end
+
+os.exit(test:check() and 0 or 1)
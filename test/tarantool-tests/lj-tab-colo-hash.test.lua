@@ -0,0 +1,94 @@
+local tap = require('tap')
+
+-- Test file to check tables with small hash parts colocated with
+-- the table object.
+
+local test = tap.test('lj-tab-colo-hash')
+test:plan(7)
+
+local table_new = require('table.new')
+local table_clear = require('table.clear')
+
+local function nkeys(t)
+  local n = 0
+  for _ in pairs(t) do n = n + 1 end
+  return n
+end
+
+local function mkrec(i)
+  return { id = i, name = 'rec' .. i, ts = i * 0.5 }
+end
+
+local ok = true
+for i = 1, 100 do
+  local r = mkrec(i)
+  if r.id ~= i or r.name ~= 'rec' .. i or r.ts ~= i * 0.5 or
+     nkeys(r) ~= 3 then
+    ok = false
+  end
+end
+test:ok(ok, 'record constructor')
+
+-- Grow the hash part past the colocated one.
+local r = mkrec(1)
+for i = 1, 100 do r['f' .. i] = i end
+ok = r.id == 1 and r.name == 'rec1' and r.ts == 0.5 and nkeys(r) == 103
+for i = 1, 100 do
+  if r['f' .. i] ~= i then ok = false end
+end
+test:ok(ok, 'hash part grows')
+
+-- Shrink it again: the rehash may reuse the colocated hash part.
+for i = 1, 100 do r['f' .. i] = nil end
+r.id = nil
+for i = 1, 100 do
+  r.x = i
+  r.x = nil
+  r['y' .. i] = i
+  r['y' .. i] = nil
+end
+r.id = 2
+test:ok(r.id == 2 and r.name == 'rec1' and r.ts == 0.5 and nkeys(r) == 3,
+        'hash part shrinks')
+
+-- Colocated array and hash parts, then separate the array part.
+local t = table_new(4, 4)
+for i = 1, 4 do t[i] = i; t['k' .. i] = -i end
+for i = 5, 100 do t[i] = i end
+ok = #t == 100 and nkeys(t) == 104
+for i = 1, 4 do
+  if t['k' .. i] ~= -i then ok = false end
+end
+test:ok(ok, 'colocated array part is separated')
+
+table_clear(r)
+r.a = 1
+test:ok(nkeys(r) == 1 and r.a == 1, 'table.clear')
+
+-- Lots of dead records with grown or shrunk hash parts.
+local function churn()
+  local keep = {}
+  for i = 1, 20000 do
+    local rec = mkrec(i)
+    if i % 3 == 0 then
+      for j = 1, 10 do rec[j] = j; rec['g' .. j] = j end
+    elseif i % 3 == 1 then
+      rec.name = nil
+      rec.other = i
+    end
+    if i % 100 == 0 then keep[#keep + 1] = rec end
+  end
+  collectgarbage()
+  for i = 1, #keep do
+    local rec = keep[i]
+    if rec.id ~= i * 100 or (i * 100 % 3 == 0 and rec.g10 ~= 10) then
+      return false
+    end
+  end
+  return true
+end
+test:ok(churn(), 'GC of colocated tables (JIT on)')
+jit.off(churn, true)
+test:ok(churn(), 'GC of colocated tables (JIT off)')
+
+os.exit(test:check() and 0 or 1)
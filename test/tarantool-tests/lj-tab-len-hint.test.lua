@@ -0,0 +1,78 @@
+local tap = require('tap')
+
+-- Test file to check the length operator with the boundary
+-- remembered from the previous length operation on a table.
+
+local test = tap.test('lj-tab-len-hint')
+test:plan(14)
+
+local table_clear = require('table.clear')
+
+local function isborder(t, n)
+  return (n == 0 or t[n] ~= nil) and t[n + 1] == nil
+end
+
+local function run(mode)
+  local function append(n)
+    local t, ok = {}, true
+    for i = 1, n do
+      t[#t + 1] = i
+      if #t ~= i then ok = false end
+    end
+    return ok and #t == n and t
+  end
+
+  local t = append(1000)
+  test:ok(t, 'append ' .. mode)
+
+  local ok = true
+  for i = 1000, 1, -1 do
+    t[#t] = nil
+    if #t ~= i - 1 then ok = false end
+  end
+  test:ok(ok, 'remove the last element ' .. mode)
+
+  -- Remember a boundary, then move it far away.
+  t = append(100)
+  for i = 101, 500 do t[i] = i end
+  ok = #t == 500
+  for i = 500, 11, -1 do t[i] = nil end
+  test:ok(ok and #t == 10, 'moved boundary ' .. mode)
+
+  -- Holes: any boundary is fine.
+  t = append(100)
+  t[50] = nil
+  ok = isborder(t, #t)
+  t[100] = nil
+  ok = ok and isborder(t, #t)
+  t[1] = nil
+  test:ok(ok and isborder(t, #t), 'holes ' .. mode)
+
+  -- Boundary in the hash part.
+  t = { 1, 2, 3 }
+  for i = 4, 100 do t[i] = i end
+  t.x = 1
+  t[101] = 101
+  ok = #t == 101
+  t[101] = nil
+  test:ok(ok and #t == 100, 'hash part ' .. mode)
+
+  t = append(100)
+  table_clear(t)
+  ok = #t == 0
+  t[1] = 1
+  test:ok(ok and #t == 1, 'table.clear ' .. mode)
+
+  t = {}
+  for i = 1, 100 do table.insert(t, i) end
+  ok = #t == 100
+  for _ = 1, 60 do table.remove(t) end
+  test:ok(ok and #t == 40, 'table.insert/table.remove ' .. mode)
+end
+
+jit.on()
+run('(JIT on)')
+jit.off()
+run('(JIT off)')
+
+os.exit(test:check() and 0 or 1)
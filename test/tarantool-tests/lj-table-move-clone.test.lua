@@ -0,0 +1,115 @@
+local tap = require('tap')
+
+-- Test file to check table.move() and table.clone() implemented
+-- as fast functions.
+
+local test = tap.test('lj-table-move-clone')
+test:plan(25)
+
+local table_clone = require('table.clone')
+
+local function range(n, m)
+  local t = {}
+  for i = n, m do t[#t + 1] = i end
+  return t
+end
+
+local function eq(a, b)
+  for k, v in pairs(a) do
+    if b[k] ~= v then return false end
+  end
+  for k, v in pairs(b) do
+    if a[k] ~= v then return false end
+  end
+  return true
+end
+
+local function run(mode)
+  local t = range(1, 10)
+  test:ok(table.move(t, 1, 5, 4) == t and
+          eq(t, { 1, 2, 3, 1, 2, 3, 4, 5, 9, 10 }),
+          'overlap, destination above ' .. mode)
+
+  t = range(1, 10)
+  table.move(t, 4, 10, 1)
+  test:ok(eq(t, { 4, 5, 6, 7, 8, 9, 10, 8, 9, 10 }),
+          'overlap, destination below ' .. mode)
+
+  local d = {}
+  test:ok(table.move(range(1, 100), 1, 100, 1, d) == d and
+          eq(d, range(1, 100)), 'empty destination ' .. mode)
+
+  d = range(1, 3)
+  table.move(range(1, 10), 1, 10, 4, d)
+  test:ok(eq(d, { 1, 2, 3, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 }),
+          'grow destination array part ' .. mode)
+
+  -- Holes and elements in the hash part.
+  local s = { 1, nil, 3, [1000] = 1000, [1001] = 1001 }
+  d = { 0, 0, 0, [10] = 0 }
+  table.move(s, 1, 3, 1, d)
+  table.move(s, 1000, 1001, 9, d)
+  test:ok(eq(d, { 1, nil, 3, [9] = 1000, [10] = 1001 }),
+          'holes and hash part ' .. mode)
+
+  d = {}
+  table.move(range(1, 5), -2, 2, 0, d)
+  test:ok(eq(d, { [3] = 1, [4] = 2 }), 'non-positive indices ' .. mode)
+
+  -- Values loaded right after the move in the same trace.
+  local ok = true
+  for i = 1, 100 do
+    local dst = { i, i }
+    local src = { i + 1, i + 2, i + 3 }
+    local x = dst[1]
+    table.move(src, 1, 3, 1, dst)
+    if x ~= i or dst[1] ~= i + 1 or dst[2] ~= i + 2 or dst[3] ~= i + 3 then
+      ok = false
+    end
+  end
+  test:ok(ok, 'loads after move ' .. mode)
+
+  -- Metamethods.
+  local log = {}
+  s = setmetatable({}, { __index = function(_, k) return k * 10 end })
+  d = setmetatable({}, { __newindex = function(tt, k, v)
+    log[#log + 1] = k
+    rawset(tt, k, v)
+  end })
+  table.move(s, 1, 3, 1, d)
+  test:ok(eq(d, { 10, 20, 30 }) and eq(log, { 1, 2, 3 }),
+          'metamethods ' .. mode)
+
+  local c = { 1, 2, 3, x = 'x', [1.5] = 1.5 }
+  local mt = {}
+  setmetatable(c, mt)
+  local cc = table_clone(c)
+  test:ok(cc ~= c and eq(cc, c) and getmetatable(cc) == nil,
+          'clone ' .. mode)
+  cc[1] = 0
+  test:ok(c[1] == 1, 'clone is a copy ' .. mode)
+
+  ok = true
+  for i = 1, 100 do
+    local r = table_clone({ i, x = i })
+    r.y = i
+    if r[1] ~= i or r.x ~= i or r.y ~= i then ok = false end
+  end
+  test:ok(ok, 'clone in a loop ' .. mode)
+end
+
+jit.on()
+run('(JIT on)')
+jit.off()
+run('(JIT off)')
+jit.on()
+
+local s = range(1, 3)
+test:ok(not pcall(table.move, s, -1, 0x7fffffff, 1) and
+        not pcall(table.move, s, 0, 0x7fffffff, 1),
+        'too many elements to move')
+test:ok(not pcall(table.move, s, 1, 3, 0x7fffffff),
+        'destination wrap around')
+test:ok(not pcall(table_clone, 1), 'clone of a non-table')
+
+os.exit(test:check() and 0 or 1)
@@ -0,0 +1,124 @@
+local tap = require('tap')
+
+-- Test file to check table.sort() implemented with pdqsort: the C
+-- version for arrays of numbers or strings and the Lua version
+-- used with comparison functions.
+
+local test = tap.test('lj-table-sort-pdq')
+test:plan(21)
+
+local function issorted(t, n, lt)
+  if #t ~= n then return false end
+  for i = 2, n do
+    if lt(t[i], t[i - 1]) then return false end
+  end
+  return true
+end
+
+local function lt(a, b) return a < b end
+local function gt(a, b) return a > b end
+
+local SIZES = { 0, 1, 2, 3, 24, 25, 100, 129, 1000, 20000 }
+
+-- Patterns which are bad for naive quicksorts.
+local function pattern(p, n, i)
+  if p == 1 then return math.random(1, 1e9)
+  elseif p == 2 then return i
+  elseif p == 3 then return n - i
+  elseif p == 4 then return math.random(1, 3)
+  elseif p == 5 then return i <= n / 2 and i or n - i
+  elseif p == 6 then return i % 2 == 0 and i or n - i
+  else return 42 end
+end
+
+local function run(mode)
+  math.randomseed(1)
+  local ok = { true, true, true, true }
+  for _, n in ipairs(SIZES) do
+    for p = 1, 7 do
+      local a, b, c, d = {}, {}, {}, {}
+      for i = 1, n do
+        local v = pattern(p, n, i)
+        a[i], b[i], c[i], d[i] = v, v, ('%09d'):format(v), { v = v }
+      end
+      table.sort(a)
+      table.sort(b, gt)
+      table.sort(c)
+      table.sort(d, function(x, y) return x.v < y.v end)
+      ok[1] = ok[1] and issorted(a, n, lt)
+      ok[2] = ok[2] and issorted(b, n, gt)
+      ok[3] = ok[3] and issorted(c, n, lt)
+      ok[4] = ok[4] and issorted(d, n, function(x, y) return x.v < y.v end)
+    end
+  end
+  test:ok(ok[1], 'numbers ' .. mode)
+  test:ok(ok[2], 'numbers with comparison function ' .. mode)
+  test:ok(ok[3], 'strings ' .. mode)
+  test:ok(ok[4], 'records with comparison function ' .. mode)
+
+  -- Not only in the array part: the Lua version with a < b.
+  local t = {}
+  for i = 100, 1, -1 do t[i] = i * 0.5 end
+  t.x = 1
+  table.sort(t)
+  test:ok(issorted(t, 100, lt) and t.x == 1, 'hash part ' .. mode)
+
+  -- Tables with __lt.
+  local mt = { __lt = function(x, y) return x[1] < y[1] end }
+  t = {}
+  for i = 1, 100 do t[i] = setmetatable({ (i * 37) % 101 }, mt) end
+  table.sort(t)
+  test:ok(issorted(t, 100, lt), '__lt metamethod ' .. mode)
+end
+
+jit.on()
+run('(JIT on)')
+jit.off()
+run('(JIT off)')
+jit.on()
+
+local x = {}
+test:like(select(2, pcall(table.sort, { x, x, x, x },
+                          function() return true end)),
+          'invalid order function for sorting', 'invalid order function')
+test:ok(not pcall(table.sort, { 1, 'x', 3 }), 'mixed types')
+test:ok(select(2, pcall(table.sort, { 3, 2, 1 }, function() error('cmp') end))
+        :match('cmp$'), 'error in the comparison function')
+
+-- Tables with less than two elements are left as is, but the
+-- comparison function is still checked.
+local empty = {[0] = 'z'}
+table.sort(empty)
+table.sort({})
+test:ok(empty[0] == 'z' and #empty == 0, 'empty array part')
+local one = {'a'}
+table.sort(one)
+test:is(one[1], 'a', 'single element')
+test:ok(not pcall(table.sort, {}, 1), 'invalid comparison function')
+
+-- Elements are accessed raw, so no metamethods are triggered,
+-- even on holes of the array.
+local nmm = 0
+local mt = {
+  __index = function() nmm = nmm + 1; return 0 end,
+  __newindex = function(tab, k, v) nmm = nmm + 1; rawset(tab, k, v) end,
+}
+pcall(table.sort, setmetatable({3, nil, 1, 2}, mt))
+local holes = setmetatable({3, nil, 1, 2}, mt)
+table.sort(holes, function(a, b)
+  if a == nil then return false end
+  return b == nil or a < b
+end)
+test:is(nmm, 0, 'no metamethods on holes')
+test:ok(rawget(holes, 1) == 1 and rawget(holes, 2) == 2 and
+        rawget(holes, 3) == 3 and rawget(holes, 4) == nil,
+        'holes are sorted raw')
+
+-- Inconsistent, but must not crash.
+local nan = 0 / 0
+local t = {}
+for i = 1, 1000 do t[i] = i % 10 == 0 and nan or i end
+pcall(table.sort, t)
+test:ok(#t == 1000, 'NaN')
+
+os.exit(test:check() and 0 or 1)
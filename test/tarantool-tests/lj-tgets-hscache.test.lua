@@ -0,0 +1,110 @@
+local tap = require('tap')
+
+-- Test file to check the hash slot cache used by the interpreter
+-- for TGETS/TSETS (and GGET/GSET) lookups on long hash chains.
+
+local test = tap.test('lj-tgets-hscache')
+test:plan(8)
+
+-- The cache is used by the interpreter only.
+jit.off()
+
+local NKEYS = 512
+
+-- Lots of keys, so many of them end up deep in a hash chain.
+local function fill(t, n, base)
+  for i = 1, n do t['k' .. i] = base + i end
+  return t
+end
+
+-- Each access gets its own bytecode, i.e. its own cache slot.
+local function gen(fmt)
+  local s = {}
+  for i = 1, NKEYS do s[i] = fmt:format(i, i) end
+  return assert(loadstring('local t, v, r = ... ' .. table.concat(s, ' ')))
+end
+
+-- Store the values of t.k1 .. t.kNKEYS into r.
+local get = gen('r[%d] = t.k%d')
+local function getall(t)
+  local r = {}
+  get(t, nil, r)
+  return r
+end
+
+-- Assign v + i to t.ki for all keys.
+local setall = gen('t.k%d = v + %d')
+
+local function check(t, base, n)
+  local r = getall(t)
+  for i = 1, NKEYS do
+    local expected = i <= n and base + i or nil
+    if r[i] ~= expected then return false end
+  end
+  return true
+end
+
+local t1 = fill({}, NKEYS, 0)
+test:ok(check(t1, 0, NKEYS) and check(t1, 0, NKEYS), 'TGETS with warm cache')
+
+-- Same bytecode, different table of a different size: the cached
+-- slots point to the wrong nodes.
+local t2 = fill({}, 300, 1000)
+test:ok(check(t2, 1000, 300) and check(t1, 0, NKEYS), 'TGETS on other table')
+
+-- Rehash the table: all nodes move.
+for i = 1, 4 * NKEYS do t1['x' .. i] = i end
+test:ok(check(t1, 0, NKEYS), 'TGETS after rehash')
+
+-- Removed keys are found with nil values and go to __index.
+for i = 1, NKEYS, 2 do t1['k' .. i] = nil end
+setmetatable(t1, { __index = function() return -1 end })
+local r, ok = getall(t1), true
+for i = 1, NKEYS do
+  if r[i] ~= (i % 2 == 1 and -1 or i) then ok = false end
+end
+test:ok(ok, 'TGETS on removed keys with __index')
+
+-- TSETS with warm cache.
+local t3 = fill({}, NKEYS, 0)
+setall(t3, 10000)
+setall(t3, 20000)
+test:ok(check(t3, 20000, NKEYS), 'TSETS with warm cache')
+
+-- TSETS on removed keys must trigger __newindex.
+local nnew = 0
+for i = 1, NKEYS, 4 do t3['k' .. i] = nil end
+setmetatable(t3, { __newindex = function(t, k, v)
+  nnew = nnew + 1
+  rawset(t, k, v)
+end })
+setall(t3, 30000)
+test:ok(nnew == NKEYS / 4 and check(t3, 30000, NKEYS),
+        'TSETS on removed keys with __newindex')
+
+-- Same with globals.
+local gget = gen('r[%d] = k%d')
+local gset = gen('k%d = 40000 + %d')
+local env = fill({}, NKEYS, 0)
+setfenv(gset, env)
+gset()
+gset()
+local rg = {}
+setfenv(gget, env)
+gget(nil, nil, rg)
+gget(nil, nil, rg)
+ok = true
+for i = 1, NKEYS do
+  if rg[i] ~= 40000 + i then ok = false end
+end
+test:ok(ok, 'GGET/GSET with warm cache')
+
+-- Polymorphic site with tables of various sizes.
+ok = true
+for n = 1, 64 do
+  local t = fill({}, n * 8, n)
+  if not check(t, n, n * 8) then ok = false end
+end
+test:ok(ok, 'TGETS on tables of various sizes')
+
+os.exit(test:check() and 0 or 1)
@@ -37,6 +37,11 @@ static int base(lua_State *L)
 	(void)metrics.jit_mcode_size;
 	(void)metrics.jit_trace_num;
 
+	(void)metrics.gc_cdatapool_hit;
+	(void)metrics.gc_cdatapool_miss;
+
+	(void)metrics.jit_hotcount_collisions;
+
 	lua_pushboolean(L, 1);
 	return 1;
 }
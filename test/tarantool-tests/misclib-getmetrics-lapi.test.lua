@@ -8,7 +8,7 @@ require('utils').skipcond(jit.os == 'BSD', 'Disabled due to #4819')
 local tap = require('tap')
 
 local test = tap.test("lib-misc-getmetrics")
-test:plan(10)
+test:plan(11)
 
 local jit_opt_default = {
     3, -- level
@@ -19,7 +19,7 @@ local jit_opt_default = {
 
 -- Test Lua API.
 test:test("base", function(subtest)
-    subtest:plan(19)
+    subtest:plan(22)
     local metrics = misc.getmetrics()
     subtest:ok(metrics.strhash_hit >= 0)
     subtest:ok(metrics.strhash_miss >= 0)
@@ -44,6 +44,11 @@ test:test("base", function(subtest)
     subtest:ok(metrics.jit_trace_abort >= 0)
     subtest:ok(metrics.jit_mcode_size >= 0)
     subtest:ok(metrics.jit_trace_num >= 0)
+
+    subtest:ok(metrics.gc_cdatapool_hit >= 0)
+    subtest:ok(metrics.gc_cdatapool_miss >= 0)
+
+    subtest:ok(metrics.jit_hotcount_collisions >= 0)
 end)
 
 test:test("gc-allocated-freed", function(subtest)
@@ -253,6 +258,64 @@ test:test("objcount", function(subtest)
     jit.opt.start(unpack(jit_opt_default))
 end)
 
+test:test("cdata-pool", function(subtest)
+    subtest:plan(6)
+    local ffi = require("ffi")
+    local N = 100
+
+    local function alloc(n)
+        local placeholder = {}
+        for i = 1, n do
+            placeholder[i] = ffi.new("int64_t", i)
+        end
+        return placeholder
+    end
+    -- Traces allocate cdata bypassing the pool.
+    jit.off(alloc)
+
+    collectgarbage()
+    local placeholder = alloc(N)
+    placeholder = nil -- luacheck: no unused
+    -- Small cdata objects are kept in the pool after the sweep.
+    collectgarbage()
+    local old_metrics = misc.getmetrics()
+    placeholder = alloc(N)
+    local new_metrics = misc.getmetrics()
+    subtest:is(new_metrics.gc_cdatapool_hit - old_metrics.gc_cdatapool_hit, N,
+               "cdata are reused from the pool")
+    subtest:is(new_metrics.gc_cdatapool_miss,
+               old_metrics.gc_cdatapool_miss, "no pool misses")
+    subtest:is(new_metrics.gc_cdatanum - old_metrics.gc_cdatanum, N,
+               "cdatanum is incremented for the reused cdata")
+    placeholder = nil -- luacheck: no unused
+
+    -- Reused cdata are accounted as allocated and freed just like
+    -- the ones from the allocator. The first run drains the pool.
+    local POOLSIZE = 256
+    collectgarbage()
+    local drain = alloc(POOLSIZE) -- luacheck: no unused
+    old_metrics = misc.getmetrics()
+    placeholder = alloc(N)
+    new_metrics = misc.getmetrics()
+    local miss_allocated = new_metrics.gc_allocated - old_metrics.gc_allocated
+    subtest:is(new_metrics.gc_cdatapool_hit, old_metrics.gc_cdatapool_hit,
+               "no pool hits with drained pool")
+    drain = nil -- luacheck: no unused
+    placeholder = nil -- luacheck: no unused
+    collectgarbage()
+    old_metrics = misc.getmetrics()
+    placeholder = alloc(N)
+    new_metrics = misc.getmetrics()
+    subtest:is(new_metrics.gc_allocated - old_metrics.gc_allocated,
+               miss_allocated, "reused cdata are accounted as allocated")
+    placeholder = nil -- luacheck: no unused
+    old_metrics = misc.getmetrics()
+    collectgarbage()
+    new_metrics = misc.getmetrics()
+    subtest:ok(new_metrics.gc_freed - old_metrics.gc_freed >= miss_allocated,
+               "pooled cdata are accounted as freed")
+end)
+
 test:test("snap-restores-direct-loop", function(subtest)
     -- Compiled loop with a direct exit to the interpreter.
     subtest:plan(1)
@@ -380,26 +443,26 @@ test:test("strhash", function(subtest)
 
     local new_metrics = misc.getmetrics()
     -- Do not use test:ok to avoid extra strhash hits/misses.
-    assert(new_metrics.strhash_hit - old_metrics.strhash_hit == 19)
+    assert(new_metrics.strhash_hit - old_metrics.strhash_hit == 22)
     assert(new_metrics.strhash_miss - old_metrics.strhash_miss == 0)
     old_metrics = new_metrics
 
     local _ = "strhash".."_hit"
 
     new_metrics = misc.getmetrics()
-    assert(new_metrics.strhash_hit - old_metrics.strhash_hit == 20)
+    assert(new_metrics.strhash_hit - old_metrics.strhash_hit == 23)
     assert(new_metrics.strhash_miss - old_metrics.strhash_miss == 0)
     old_metrics = new_metrics
 
     new_metrics = misc.getmetrics()
-    assert(new_metrics.strhash_hit - old_metrics.strhash_hit == 19)
+    assert(new_metrics.strhash_hit - old_metrics.strhash_hit == 22)
     assert(new_metrics.strhash_miss - old_metrics.strhash_miss == 0)
     old_metrics = new_metrics
 
     local _ = "new".."string"
 
     new_metrics = misc.getmetrics()
-    assert(new_metrics.strhash_hit - old_metrics.strhash_hit == 19)
+    assert(new_metrics.strhash_hit - old_metrics.strhash_hit == 22)
     assert(new_metrics.strhash_miss - old_metrics.strhash_miss == 1)
     subtest:ok(true, "no assertion failed")
 end)